@@ -0,0 +1,497 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include <ircd/matrix.h>
+#include <fstream>
+#include <random>
+
+/// Microbenchmarks of the JSON and event processing hot paths. The corpus is
+/// a JSON array of events; at startup each event is given its content hash
+/// and a signature by a key generated here, so the hashing and verification
+/// benchmarks operate on events which actually pass. One line of JSON is
+/// printed for each benchmark so results can be compared between builds.
+namespace bench
+{
+	using namespace ircd;
+
+	struct event
+	{
+		std::string source;
+		ed25519::sig sig;
+	};
+
+	static void measure(const string_view &name, const size_t &bytes, const std::function<size_t ()> &);
+	static void prepare(const json::array &);
+	static std::string b64_reference(const string_view &, const char &c62, const char &c63, const bool &pad);
+	static void check_b64();
+
+	static const string_view seed {"construct bench construct bench "};
+	static ed25519::pk pk;
+	static ed25519::sk sk {&pk, seed};
+	static std::vector<event> corpus;
+	static size_t corpus_bytes;
+	static size_t rounds {1000};
+}
+
+int
+main(int argc, char *const *const argv)
+try
+{
+	using namespace bench;
+
+	const string_view path
+	{
+		argc > 1? argv[1] : "events.json"
+	};
+
+	if(argc > 2)
+		rounds = lex_cast<size_t>(string_view{argv[2]});
+
+	// The vectorized codecs are checked before anything is measured.
+	check_b64();
+
+	std::ifstream file
+	{
+		std::string(path)
+	};
+
+	const std::string text
+	{
+		std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()
+	};
+
+	if(!file || text.empty())
+		throw std::runtime_error
+		{
+			"Failed to read the corpus at " + std::string(path)
+		};
+
+	prepare(json::array{text});
+
+	// Visit every member and element at every depth.
+	static const auto walk{[](const auto &walk, const string_view &val) -> size_t
+	{
+		size_t ret(1);
+		switch(json::type(val))
+		{
+			case json::OBJECT:
+				for(const auto &[name, sub] : json::object(val))
+					ret += walk(walk, sub);
+				break;
+
+			case json::ARRAY:
+				for(const auto &sub : json::array(val))
+					ret += walk(walk, sub);
+				break;
+
+			default:
+				break;
+		}
+
+		return ret;
+	}};
+
+	measure("json.object.iterate", corpus_bytes, []
+	{
+		size_t ret(0);
+		for(const auto &event : corpus)
+			ret += walk(walk, event.source);
+
+		return ret;
+	});
+
+	measure("json.valid", corpus_bytes, []
+	{
+		size_t ret(0);
+		for(const auto &event : corpus)
+			ret += json::valid(event.source, std::nothrow);
+
+		return ret;
+	});
+
+	measure("json.tuple.event", corpus_bytes, []
+	{
+		size_t ret(0);
+		for(const auto &event : corpus)
+		{
+			const m::event tuple
+			{
+				json::object{event.source}
+			};
+
+			ret += json::get<"depth"_>(tuple) > 0;
+		}
+
+		return ret;
+	});
+
+	measure("json.stringify.event", corpus_bytes, []
+	{
+		thread_local char buf[m::event::MAX_SIZE];
+		size_t ret(0);
+		for(const auto &event : corpus)
+		{
+			const m::event tuple
+			{
+				json::object{event.source}
+			};
+
+			ret += size(json::stringify(mutable_buffer{buf}, tuple));
+		}
+
+		return ret;
+	});
+
+	measure("m.event.hash", corpus_bytes, []
+	{
+		size_t ret(0);
+		for(const auto &event : corpus)
+		{
+			const m::event tuple
+			{
+				json::object{event.source}
+			};
+
+			ret += m::verify_hash(tuple);
+		}
+
+		return ret;
+	});
+
+	measure("m.verify", corpus_bytes, []
+	{
+		size_t ret(0);
+		for(const auto &event : corpus)
+		{
+			const m::event tuple
+			{
+				json::object{event.source}
+			};
+
+			ret += m::verify(tuple, pk, event.sig);
+		}
+
+		return ret;
+	});
+
+	measure("b64.encode", corpus_bytes, []
+	{
+		thread_local char buf[b64encode_size(m::event::MAX_SIZE)];
+		size_t ret(0);
+		for(const auto &event : corpus)
+			ret += size(b64encode(buf, string_view{event.source}));
+
+		return ret;
+	});
+
+	measure("b64.decode", size(corpus) * b64encode_size(ed25519::SIG_SZ), []
+	{
+		thread_local char buf[2][b64encode_size(ed25519::SIG_SZ)];
+		size_t ret(0);
+		for(const auto &event : corpus)
+		{
+			const string_view sig
+			{
+				b64encode_unpadded(buf[0], event.sig)
+			};
+
+			ret += size(b64decode(buf[1], sig));
+		}
+
+		return ret;
+	});
+
+	measure("b58.encode+decode", size(corpus) * sha256::digest_size, []
+	{
+		thread_local char buf[2][b58encode_size(sha256::digest_size)];
+		size_t ret(0);
+		for(const auto &event : corpus)
+		{
+			const sha256::buf hash
+			{
+				sha256{string_view{event.source}}
+			};
+
+			const string_view hash58
+			{
+				b58encode(buf[0], hash)
+			};
+
+			ret += size(b58decode(buf[1], hash58));
+		}
+
+		return ret;
+	});
+
+	measure("m.id.valid", 0, []
+	{
+		size_t ret(0);
+		for(const auto &event : corpus)
+		{
+			const json::object object{event.source};
+			ret += m::valid(m::id::USER, json::string(object["sender"]));
+			ret += m::valid(m::id::ROOM, json::string(object["room_id"]));
+			for(const json::string prev : json::array(object["prev_events"]))
+				ret += m::valid(m::id::EVENT, prev);
+		}
+
+		return ret;
+	});
+
+	return EXIT_SUCCESS;
+}
+catch(const std::exception &e)
+{
+	fprintf(stderr, "construct-bench: %s\n", e.what());
+	return EXIT_FAILURE;
+}
+
+/// Gives each event of the corpus its hashes and the signature of the bench
+/// key; the hashes are part of what is signed.
+void
+bench::prepare(const json::array &events)
+{
+	thread_local char buf[4][m::event::MAX_SIZE];
+	for(const json::object object : events)
+	{
+		m::event event
+		{
+			object
+		};
+
+		json::get<"hashes"_>(event) = m::hashes(buf[0], event);
+		event.source = {};
+
+		const m::event essential
+		{
+			m::essential(event, buf[1])
+		};
+
+		const ed25519::sig sig
+		{
+			m::sign(essential, sk)
+		};
+
+		const json::strung sigb64
+		{
+			json::members
+			{
+				{ "bench.example", json::members
+				{
+					{ "ed25519:bench", b64encode_unpadded(buf[2], sig) }
+				}}
+			}
+		};
+
+		json::get<"signatures"_>(event) = sigb64;
+		const string_view source
+		{
+			json::stringify(mutable_buffer{buf[3]}, event)
+		};
+
+		corpus_bytes += size(source);
+		corpus.emplace_back(bench::event
+		{
+			std::string(source), sig
+		});
+	}
+}
+
+/// Straightforward bitwise base64 encoding; the codecs in libircd are
+/// checked against this.
+std::string
+bench::b64_reference(const string_view &in,
+                     const char &c62,
+                     const char &c63,
+                     const bool &pad)
+{
+	static const string_view alpha
+	{
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789"
+	};
+
+	std::string ret;
+	uint32_t acc(0);
+	size_t bits(0);
+	for(const auto &c : in)
+	{
+		acc = (acc << 8) | uint8_t(c);
+		for(bits += 8; bits >= 6; bits -= 6)
+		{
+			const uint8_t v((acc >> (bits - 6)) & 0x3f);
+			ret.push_back(v < 62? alpha[v] : v == 62? c62 : c63);
+		}
+	}
+
+	if(bits)
+	{
+		const uint8_t v((acc << (6 - bits)) & 0x3f);
+		ret.push_back(v < 62? alpha[v] : v == 62? c62 : c63);
+	}
+
+	while(pad && ret.size() % 4)
+		ret.push_back('=');
+
+	return ret;
+}
+
+/// Checks encoding and decoding of every length up to a few times the widest
+/// vector block, in both alphabets, padded and unpadded, into buffers of the
+/// exact size. Every position of every encoding is then corrupted in turn
+/// and the decoder must refuse it. Throws on the first mismatch.
+void
+bench::check_b64()
+{
+	static const size_t len_max {320};
+	static const string_view invalid
+	{
+		"!.* \x80\xff\0", 7
+	};
+
+	std::mt19937 prng{len_max};
+	std::string in, text;
+	size_t cases(0), refused(0);
+	const auto fail{[&in](const string_view &what)
+	{
+		throw std::runtime_error
+		{
+			fmt::snstringf
+			{
+				256, "b64 check: %s at length %zu", what, in.size()
+			}
+		};
+	}};
+
+	for(size_t len(0); len <= len_max; ++len)
+	{
+		in.resize(len);
+		for(auto &c : in)
+			c = prng();
+
+		const const_buffer src
+		{
+			string_view{in}
+		};
+
+		const std::string std_pad(b64_reference(in, '+', '/', true));
+		const std::string std_unpad(b64_reference(in, '+', '/', false));
+		const std::string url_unpad(b64_reference(in, '-', '_', false));
+
+		// The output buffers are exactly as large as the result; note that
+		// b64encode_size() and friends may estimate one more.
+		std::string out((len + 2) / 3 * 4, '\0');
+		if(b64encode(mutable_buffer{out}, src) != std_pad)
+			fail("b64encode mismatch");
+
+		out.resize((len * 4 + 2) / 3);
+		if(b64encode_unpadded(mutable_buffer{out}, src) != std_unpad)
+			fail("b64encode_unpadded mismatch");
+
+		if(b64urlencode_unpadded(mutable_buffer{out}, src) != url_unpad)
+			fail("b64urlencode_unpadded mismatch");
+
+		std::string dec(len, '\0');
+		for(const auto &enc : {std_pad, std_unpad})
+			if(string_view(b64decode(mutable_buffer{dec}, enc)) != in)
+				fail("b64decode mismatch");
+
+		if(string_view(b64urldecode(mutable_buffer{dec}, url_unpad)) != in)
+			fail("b64urldecode mismatch");
+
+		if(len)
+		{
+			dec.resize(len - 1);
+			try
+			{
+				b64decode(mutable_buffer{dec}, std_unpad);
+				fail("b64decode into short buffer");
+			}
+			catch(const ircd::error &) {}
+			dec.resize(len);
+		}
+
+		cases += 6;
+		for(size_t i(0); i < std_unpad.size(); ++i)
+		{
+			const auto bad
+			{
+				invalid[i % size(invalid)]
+			};
+
+			text = std_unpad;
+			text[i] = bad;
+			try
+			{
+				b64decode(mutable_buffer{dec}, text);
+				fail("b64decode accepted an invalid character");
+			}
+			catch(const ircd::error &) {}
+
+			text = url_unpad;
+			text[i] = i % 2? '+' : bad;
+			try
+			{
+				b64urldecode(mutable_buffer{dec}, text);
+				fail("b64urldecode accepted an invalid character");
+			}
+			catch(const ircd::error &) {}
+
+			refused += 2;
+		}
+	}
+
+	std::cout
+	<< json::strung{json::members
+	{
+		{ "name",     "b64.check"    },
+		{ "lengths",  long(len_max)  },
+		{ "cases",    long(cases)    },
+		{ "refused",  long(refused)  },
+	}}
+	<< std::endl;
+}
+
+/// Runs the closure for the configured number of rounds and prints the
+/// result as a line of JSON. The sum returned by the closure is printed so
+/// the work can't be optimized away and a change in outcome is visible.
+void
+bench::measure(const string_view &name,
+               const size_t &bytes,
+               const std::function<size_t ()> &closure)
+{
+	size_t result(0);
+	util::timer timer;
+	for(size_t i(0); i < rounds; ++i)
+		result += closure();
+
+	const auto elapsed
+	{
+		timer.at<nanoseconds>()
+	};
+
+	const size_t ops
+	{
+		size(corpus) * rounds
+	};
+
+	std::cout
+	<< json::strung{json::members
+	{
+		{ "name",       name                                           },
+		{ "rounds",     long(rounds)                                   },
+		{ "ops",        long(ops)                                      },
+		{ "bytes",      long(bytes * rounds)                           },
+		{ "ns",         long(elapsed.count())                          },
+		{ "ns_per_op",  double(elapsed.count()) / ops                  },
+		{ "mb_per_sec", bytes * rounds / (elapsed.count() / 1e9) / 1e6 },
+		{ "result",     long(result)                                   },
+	}}
+	<< std::endl;
+}
@@ -37,12 +37,18 @@ namespace ircd
 	string_view b64encode_unpadded(const mutable_buffer &out, const const_buffer &in);
 	std::string b64encode_unpadded(const const_buffer &in);
 
+	// Binary -> Base64URL conversion without padding
+	string_view b64urlencode_unpadded(const mutable_buffer &out, const const_buffer &in);
+
 	// Base64 -> Binary conversion (padded or unpadded)
 	constexpr size_t b64decode_size(const size_t &);
 	size_t b64decode_size(const string_view &in);
 	const_buffer b64decode(const mutable_buffer &out, const string_view &in);
 	std::string b64decode(const string_view &in);
 
+	// Base64URL -> Binary conversion (padded or unpadded)
+	const_buffer b64urldecode(const mutable_buffer &out, const string_view &in);
+
 	// Base64 convenience conversions
 	string_view b64tob58(const mutable_buffer &out, const string_view &in);
 	string_view b58tob64(const mutable_buffer &out, const string_view &in);
@@ -51,6 +57,12 @@ namespace ircd
 	string_view b64urltob64(const mutable_buffer &out, const string_view &in);
 }
 
+namespace ircd::b64
+{
+	// Throws if the compiled codec gets a known answer wrong.
+	void check();
+}
+
 inline size_t
 ircd::b64decode_size(const string_view &in)
 {
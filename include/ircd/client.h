@@ -32,6 +32,7 @@ struct ircd::client
 	struct conf;
 	struct settings;
 	struct request;
+	struct h2;
 
 	static log::log log;
 	static struct settings settings;
@@ -59,9 +60,12 @@ struct ircd::client
 	uint64_t request_count {0};
 	ctx::ctx *reqctx {nullptr};
 	ircd::timer timer;
+	microseconds queue_time {0};         // waited for a request ctx
 	size_t head_length {0};
 	size_t content_consumed {0};
 	resource::request request;
+	std::unique_ptr<h2> h2c;             // HTTP/2 connection state, if negotiated
+	http2::stream *stream {nullptr};     // HTTP/2 stream when this is a stream client
 
 	string_view loghead() const;
 	size_t write_all(const const_buffer &);
@@ -111,6 +115,7 @@ struct ircd::client::settings
 {
 	static ircd::conf::item<size_t> stack_size;
 	static ircd::conf::item<size_t> pool_size;
+	static ircd::conf::item<size_t> pipeline_depth;
 	static ircd::conf::item<size_t> max_client;
 	static ircd::conf::item<size_t> max_client_per_peer;
 };
@@ -120,3 +125,70 @@ struct ircd::client::init
 	init();
 	~init() noexcept;
 };
+
+/// HTTP/2 connection state (RFC 7540) for a client which negotiated "h2" with
+/// ALPN. The connection's client is dispatched to main() each time the socket
+/// becomes readable just like HTTP/1; all complete frames are processed and
+/// the client falls back to async mode. Each request stream is then handled
+/// by its own client instance sharing the socket, drawn from the same request
+/// pool, so resources are unaware of the protocol. The response written by a
+/// resource as HTTP/1.1 is translated into HEADERS and DATA frames.
+struct ircd::client::h2
+{
+	struct stream;
+
+	static ircd::conf::item<size_t> max_concurrent_streams;
+	static ircd::conf::item<size_t> initial_window_size;
+	static ircd::conf::item<size_t> max_frame_size;
+	static ircd::conf::item<size_t> header_table_size;
+	static ircd::conf::item<size_t> max_header_list_size;
+	static ircd::conf::item<size_t> content_max;
+
+	client *c;
+	http2::settings local, peer;
+	http2::hpack::decoder decoder;
+	std::map<uint32_t, std::unique_ptr<stream>> streams;
+	unique_buffer<mutable_buffer> buf;
+	size_t buf_have {0};
+	std::string block;                   // header block pending CONTINUATION
+	uint32_t block_sid {0};
+	uint8_t block_flags {0};
+	uint32_t last_sid {0};
+	int64_t send_window {65535};
+	ctx::mutex write_mutex;
+	ctx::dock dock;
+	bool preface {false};
+	bool goaway {false};
+	bool closed {false};
+
+	void send(const vector_view<const const_buffer> &);
+	void send(const http2::frame::header &, const const_buffer & = {});
+	void send_goaway(const enum http2::error::code &);
+	void send_rst(const uint32_t &sid, const enum http2::error::code &);
+	void send_settings();
+
+	void dispatch(stream &);
+	void handle_headers_block();
+	void handle_headers(const http2::frame::header &, const_buffer);
+	void handle_continuation(const http2::frame::header &, const const_buffer &);
+	void handle_data(const http2::frame::header &, const_buffer);
+	void handle_settings(const http2::frame::header &, const const_buffer &);
+	void handle_ping(const http2::frame::header &, const const_buffer &);
+	void handle_goaway(const http2::frame::header &, const const_buffer &);
+	void handle_window_update(const http2::frame::header &, const const_buffer &);
+	void handle_rst_stream(const http2::frame::header &, const const_buffer &);
+	void handle_frame(const http2::frame::header &, const const_buffer &);
+	size_t handle_frames();
+
+	bool active() const;
+	bool main();
+
+	static size_t write(client &, const const_buffer &);
+	static void reset(client &);
+	static bool negotiated(const client &);
+
+	h2(client &);
+	h2(h2 &&) = delete;
+	h2(const h2 &) = delete;
+	~h2() noexcept;
+};
@@ -138,6 +138,8 @@ final
 	void finalize(const mutable_buffer &) override;
 	void update(const const_buffer &) override;
 
+	static void batch(const vector_view<const mutable_buffer> &, const vector_view<const const_buffer> &);
+
 	sha256(const mutable_buffer &, const const_buffer &); // note: finalizes
 	sha256(const const_buffer &); // note: finalizes
 	sha256();
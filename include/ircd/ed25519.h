@@ -25,6 +25,9 @@ namespace ircd::ed25519
 	struct pk;
 	struct sk;
 	struct sig;
+	struct verify_item;
+
+	size_t verify_batch(const vector_view<const verify_item> &, const vector_view<bool> &valid);
 }
 
 class ircd::ed25519::sk
@@ -60,3 +63,12 @@ struct ircd::ed25519::sig
 	:fixed_mutable_buffer<SIG_SZ>{nullptr}
 	{}
 };
+
+/// One of the independent signatures given to verify_batch(). The result
+/// for each is given at its index, so a failure is always identified.
+struct ircd::ed25519::verify_item
+{
+	const ed25519::pk *key {nullptr};
+	const_buffer msg;
+	const ed25519::sig *sig {nullptr};
+};
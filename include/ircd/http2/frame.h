@@ -21,6 +21,7 @@ struct ircd::http2::frame
 	struct header;
 	struct settings;
 	enum type :uint8_t;
+	enum flag :uint8_t;
 
 	static string_view reflect(const type &);
 };
@@ -32,6 +33,19 @@ struct ircd::http2::frame::header
 	uint8_t flags;
 	uint32_t            : 1;
 	uint32_t stream_id  : 31;
+
+	// Composes the 9 octet header in network byte order.
+	const_buffer operator()(const mutable_buffer &) const;
+
+	// Parses from the network; the buffer must contain at least 9 octets.
+	header(const const_buffer &);
+
+	header(const enum type &,
+	       const uint8_t &flags,
+	       const uint32_t &stream_id,
+	       const uint32_t &len = 0);
+
+	header() = default;
 }
 __attribute__((packed));
 
@@ -49,3 +63,15 @@ enum ircd::http2::frame::type
 	WINDOW_UPDATE  = 0x8,
 	CONTINUATION   = 0x9,
 };
+
+/// Frame flags share bits between types; i.e END_STREAM applies to DATA and
+/// HEADERS while ACK applies to SETTINGS and PING.
+enum ircd::http2::frame::flag
+:uint8_t
+{
+	END_STREAM     = 0x01,
+	ACK            = 0x01,
+	END_HEADERS    = 0x04,
+	PADDED         = 0x08,
+	PRIORITIZED    = 0x20,    // "PRIORITY" in RFC 7540; renamed to not conflict with type
+};
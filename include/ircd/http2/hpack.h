@@ -0,0 +1,60 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2019 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_HTTP2_HPACK_H
+
+/// HPACK: Header Compression for HTTP/2 (RFC 7541)
+namespace ircd::http2::hpack
+{
+	struct table;
+	struct decoder;
+
+	using header = std::pair<string_view, string_view>;
+	using closure = std::function<void (const string_view &name, const string_view &value)>;
+
+	extern const header static_table[61];
+
+	size_t huffman_size(const string_view &);
+	const_buffer huffman_encode(const mutable_buffer &, const string_view &);
+	string_view huffman_decode(const mutable_buffer &, const const_buffer &);
+
+	void encode(window_buffer &, const string_view &name, const string_view &value);
+}
+
+/// The dynamic table (RFC 7541 2.3.2). Entries are indexed after the static
+/// table, with the most recently added entry at the lowest index. The size
+/// accounting follows the RFC; each entry costs its name and value lengths
+/// plus 32 octets of overhead.
+struct ircd::http2::hpack::table
+{
+	std::deque<std::pair<std::string, std::string>> entries;
+	size_t size {0};
+	size_t max {4096};
+
+	header operator[](const size_t &index) const;   // 1-based; static then dynamic
+	void add(const string_view &name, const string_view &value);
+	void resize(const size_t &max);
+};
+
+/// Stateful header block decoder for one connection. The closure is called
+/// with each header field in the order they appear in the block; the views
+/// are only valid for the duration of the call. Throws http2::error with
+/// COMPRESSION_ERROR on any malformed input, which is a connection error.
+struct ircd::http2::hpack::decoder
+{
+	table dynamic;
+	size_t max_size {4096};   // SETTINGS_HEADER_TABLE_SIZE in effect locally
+	unique_buffer<mutable_buffer> buf;
+
+	void operator()(const const_buffer &block, const closure &);
+
+	decoder(const size_t &buf_size = 16_KiB);
+};
@@ -21,6 +21,7 @@ struct ircd::http2::stream
 	enum class state :uint8_t;
 
 	enum state state;
+	uint32_t id {0};
 
 	stream();
 };
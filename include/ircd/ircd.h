@@ -81,6 +81,7 @@
 #include "http.h"
 #include "http2/http2.h"
 #include "magics.h"
+#include "zlib.h"
 #include "conf.h"
 #include "stats.h"
 #include "prof/prof.h"
@@ -0,0 +1,50 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_JSON_CANONICAL_H
+
+namespace ircd::json
+{
+	struct canonical;
+}
+
+/// Streaming canonical JSON writer.
+///
+/// The value is written with the members of every object sorted by name and
+/// without insignificant whitespace; this is the form which is hashed and
+/// signed. Unlike stringify() no copy of the whole output is made: the output
+/// is gathered in a small window on the stack which is given to the sink
+/// each time it fills, so the sink can feed an incremental hash directly.
+/// Objects are sorted in place as they are reached, using a per-thread pool
+/// of member views shared by every level of the recursion; nothing is
+/// allocated.
+///
+/// The members of the outermost object can be skipped with the filter, which
+/// returns false for a name which is not to be written. The sink must not
+/// yield the ircd::ctx.
+///
+struct ircd::json::canonical
+{
+	struct window;
+
+	using sink = std::function<void (const const_buffer &)>;
+	using filter = std::function<bool (const string_view &)>;
+
+	static const size_t pool_size;
+
+  private:
+	static void value(window &, const string_view &, const uint &depth);
+	static void object(window &, const json::object &, const uint &depth, const filter *const &);
+	static void array(window &, const json::array &, const uint &depth);
+
+  public:
+	canonical(const string_view &value, const sink &, const filter & = {});
+};
@@ -0,0 +1,177 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_JSON_INDEX_H
+
+namespace ircd::json
+{
+	struct index;
+}
+
+/// Member index for a json::object which is queried repeatedly.
+///
+/// Every query on a json::object iterates the object from the beginning. When
+/// the same object is queried for many keys, or for the same key many times
+/// (e.g. event content tested against every push rule) this companion is
+/// built by a single iteration and then answers each query with a binary
+/// search over the member name hashes.
+///
+/// The index owns nothing. The entries are written into a buffer supplied by
+/// the user, typically on the stack, and they hold offsets into the object,
+/// which must outlive the index. Members beyond the capacity of the buffer
+/// are not indexed; the index is then incomplete and a query for a name it
+/// does not contain falls back to iterating the object. As with json::object
+/// the first of any duplicate names is found.
+///
+struct ircd::json::index
+{
+	struct entry;
+
+	json::object object;
+	vector_view<const entry> entries;
+	bool complete {true};
+
+	string_view find(const name_hash_t &, const string_view &key) const;
+
+  public:
+	bool empty() const;
+	size_t count() const;
+	bool has(const string_view &key) const;
+	bool has(const name_hash_t &key) const;
+
+	// returns value or default
+	template<class T> T get(const string_view &key, const T &def = T{}) const;
+	string_view get(const string_view &key, const string_view &def = {}) const;
+
+	// returns value or throws not_found
+	template<class T = string_view> T at(const string_view &key) const;
+
+	// returns value or empty
+	string_view operator[](const string_view &key) const;
+	string_view operator[](const name_hash_t &key) const;
+
+	index(const json::object &, const vector_view<entry> &buf);
+	index() = default;
+};
+
+struct ircd::json::index::entry
+{
+	name_hash_t hash;
+	uint32_t key_off;
+	uint32_t key_len;
+	uint32_t val_off;
+	uint32_t val_len;
+};
+
+template<class T>
+T
+ircd::json::index::at(const string_view &key)
+const try
+{
+	const string_view val
+	{
+		operator[](key)
+	};
+
+	if(unlikely(val.empty()))
+		throw not_found
+		{
+			"'%s'", key
+		};
+
+	return lex_cast<T>(val);
+}
+catch(const bad_lex_cast &e)
+{
+	throw type_error
+	{
+		"'%s' must cast to type %s",
+		key,
+		typeid(T).name()
+	};
+}
+
+template<class T>
+T
+ircd::json::index::get(const string_view &key,
+                       const T &def)
+const try
+{
+	const string_view val
+	{
+		operator[](key)
+	};
+
+	return !val.empty()?
+		lex_cast<T>(val):
+		def;
+}
+catch(const bad_lex_cast &e)
+{
+	return def;
+}
+
+inline ircd::string_view
+ircd::json::index::get(const string_view &key,
+                       const string_view &def)
+const
+{
+	const string_view val
+	{
+		operator[](key)
+	};
+
+	return !val.empty()? val : def;
+}
+
+inline ircd::string_view
+ircd::json::index::operator[](const string_view &key)
+const
+{
+	return find(name_hash(key), key);
+}
+
+inline ircd::string_view
+ircd::json::index::operator[](const name_hash_t &key)
+const
+{
+	return find(key, {});
+}
+
+inline bool
+ircd::json::index::has(const string_view &key)
+const
+{
+	return !operator[](key).empty();
+}
+
+inline bool
+ircd::json::index::has(const name_hash_t &key)
+const
+{
+	return !operator[](key).empty();
+}
+
+inline size_t
+ircd::json::index::count()
+const
+{
+	return complete?
+		entries.size():
+		object.count();
+}
+
+inline bool
+ircd::json::index::empty()
+const
+{
+	return entries.empty();
+}
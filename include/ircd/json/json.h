@@ -32,10 +32,12 @@ namespace ircd::json
 #include "string.h"
 #include "array.h"
 #include "object.h"
+#include "index.h"
 #include "vector.h"
 #include "value.h"
 #include "member.h"
 #include "iov.h"
+#include "canonical.h"
 #include "strung.h"
 #include "tuple/tuple.h"
 #include "stack.h"
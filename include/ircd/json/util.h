@@ -33,8 +33,15 @@ namespace ircd::json
 	void valid(const string_view &);
 	std::string why(const string_view &);
 
+	// Validate UTF-8 - checks the encoding of the text, not its syntax.
+	bool valid_utf8(const string_view &) noexcept;
+
 	// (Internal) validates output
 	void valid_output(const string_view &, const size_t &expected);
+
+	// Iteration, validation and string printing try a vectorized scanner
+	// before the grammar.
+	extern bool scan_enable;
 }
 
 /// Alternative to `json::strung` which uses a fixed array rather than an
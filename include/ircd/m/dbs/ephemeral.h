@@ -0,0 +1,41 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_EPHEMERAL_H
+
+namespace ircd::m::dbs
+{
+	constexpr size_t EPHEMERAL_SPACE_MAX_SIZE
+	{
+		event::TYPE_MAX_SIZE
+	};
+
+	constexpr size_t EPHEMERAL_KEY_MAX_SIZE
+	{
+		EPHEMERAL_SPACE_MAX_SIZE + 1 + event::STATE_KEY_MAX_SIZE
+	};
+
+	string_view ephemeral_key(const mutable_buffer &out, const string_view &space, const string_view &key);
+	std::pair<string_view, string_view> ephemeral_key(const string_view &amalgam);
+
+	// space | key => expires, value
+	extern db::domain ephemeral;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<size_t> ephemeral__block__size;
+	extern conf::item<size_t> ephemeral__meta_block__size;
+	extern conf::item<size_t> ephemeral__cache__size;
+	extern const db::prefix_transform ephemeral__pfx;
+	extern const db::compactor ephemeral__cmp;
+	extern const db::descriptor ephemeral;
+}
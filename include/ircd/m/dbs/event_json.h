@@ -13,6 +13,14 @@
 
 namespace ircd::m::dbs
 {
+	struct event_json_header;
+
+	bool event_json_packed(const string_view &val) noexcept;
+	json::object event_json_source(const string_view &val) noexcept;
+	string_view event_json_get(const string_view &val, const string_view &key);
+	void event_json_unpack(m::event &, const string_view &val, const event::keys &);
+	string_view event_json_pack(const mutable_buffer &, const json::object &source);
+
 	void _index_event_json(db::txn &, const event &, const write_opts &);
 
 	// event_idx => full json
@@ -26,5 +34,35 @@ namespace ircd::m::dbs::desc
 	extern conf::item<size_t> event_json__cache__size;
 	extern conf::item<size_t> event_json__cache_comp__size;
 	extern conf::item<size_t> event_json__bloom__bits;
+	extern conf::item<bool> event_json__pack;
+	extern const db::compactor event_json__cmp;
 	extern const db::descriptor event_json;
 }
+
+/// A packed value of _event_json. The value is the stored JSON of the
+/// event prefixed by this header, followed by a location (offset, length)
+/// into the JSON for the value of each m::event property present, in order
+/// of the property's index. The tuple is then assigned without tokenizing
+/// the object, while the JSON itself is still given to everything which
+/// reads event.source. An unpacked value always starts with '{' and never
+/// with the magic, so both forms coexist in the column.
+struct ircd::m::dbs::event_json_header
+{
+	struct loc;
+
+	static constexpr const uint8_t MAGIC {0xEC};
+	static constexpr const uint8_t FORMAT {1};
+
+	uint8_t magic {MAGIC};
+	uint8_t version {FORMAT};
+	uint16_t count {0};                      // number of loc following
+	uint32_t present {0};                    // bit for each property index
+}
+__attribute__((packed));
+
+struct ircd::m::dbs::event_json_header::loc
+{
+	uint16_t off {0};
+	uint16_t len {0};
+}
+__attribute__((packed));
@@ -0,0 +1,39 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_EPHEMERAL_H
+
+/// Key-value store for internal caches which have no business being events.
+///
+/// Values are grouped by space (an arbitrary name, like an event type) and
+/// each has a lifetime after which it is treated as absent. A write goes to
+/// memory and through to the dbs::ephemeral column directly; there is no
+/// vm::eval, so no event_idx is consumed, no hooks are run and sync is not
+/// woken. Recently used values are served from memory; the column is read
+/// when a value is not there. Expired values are removed from the column by
+/// its compaction filter.
+namespace ircd::m::ephemeral
+{
+	using closure = std::function<void (const string_view &)>;
+	using closure_bool = std::function<bool (const string_view &key, const string_view &val)>;
+
+	extern conf::item<size_t> mem_max;
+	extern stats::item mem_hits;
+	extern stats::item mem_misses;
+	extern stats::item writes;
+
+	bool for_each(const string_view &space, const closure_bool &);
+	bool get(std::nothrow_t, const string_view &space, const string_view &key, const closure &);
+	void get(const string_view &space, const string_view &key, const closure &);
+	bool has(const string_view &space, const string_view &key);
+	void set(const string_view &space, const string_view &key, const string_view &val, const seconds &ttl);
+	bool del(const string_view &space, const string_view &key);
+}
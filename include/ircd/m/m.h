@@ -78,6 +78,7 @@ namespace ircd
 #include "request.h"
 #include "fed/fed.h"
 #include "keys.h"
+#include "ephemeral.h"
 #include "edu.h"
 #include "presence.h"
 #include "typing.h"
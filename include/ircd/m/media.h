@@ -48,12 +48,14 @@ namespace ircd::m::media::block
 {
 	using closure = std::function<void (const const_buffer &)>;
 
-	bool prefetch(const string_view &hash);
-	bool get(const string_view &hash, const closure &);
-	const_buffer get(const mutable_buffer &out, const string_view &hash);
+	sha256::buf key(const json::object &content);
 
-	void set(const string_view &hash, const const_buffer &block);
-	string_view set(const mutable_buffer &hashbuf, const const_buffer &block);
+	bool prefetch(const sha256::buf &hash);
+	bool get(const sha256::buf &hash, const closure &);
+	const_buffer get(const mutable_buffer &out, const sha256::buf &hash);
+
+	void set(const sha256::buf &hash, const const_buffer &block);
+	sha256::buf set(const const_buffer &block);
 	m::event::id::buf set(const room &, const user::id &, const const_buffer &block);
 }
 
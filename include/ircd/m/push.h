@@ -50,6 +50,10 @@ struct ircd::m::push::match
 struct ircd::m::push::match::opts
 {
 	m::id::user user_id;
+
+	/// Index of the event's content built once by the caller, who then
+	/// evaluates many rules (for many users) against the same event.
+	const json::index *content {nullptr};
 };
 
 /// 13.13.1 I'm your pusher, baby.
@@ -34,6 +34,7 @@ struct ircd::m::resource::method
 	handler function;
 
 	response handle(client &, ircd::resource::request &);
+	void rate_limit(const client &, const request &, const string_view &scope = {}) const;
 
 	method(m::resource &, const string_view &name, handler, struct opts = {});
 	~method() noexcept;
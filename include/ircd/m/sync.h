@@ -42,6 +42,70 @@ namespace ircd::m::sync
 	extern conf::item<bool> stats_info;
 }
 
+/// Tracks the m.room.member events sent to each device of a user while
+/// lazy-loading members, so redundant members can be omitted from later
+/// responses (/sync and /messages). This is only held in memory; when an
+/// entry is lost the members are simply sent again.
+namespace ircd::m::sync::members
+{
+	bool sent(const user::id &, const string_view &device_id, const event::idx &);
+	bool mark(const user::id &, const string_view &device_id, const event::idx &);
+	size_t reset(const user::id &, const string_view &device_id);
+
+	extern conf::item<size_t> max_devices;
+	extern conf::item<size_t> max_members;
+}
+
+/// Index of each user's rooms ordered by the last event_idx in the room which
+/// is relevant to a sync (the room's own events, the user's membership, read
+/// receipts and the user's room account data). Polylog sync consults this to
+/// visit only the rooms which changed since the since token rather than all
+/// of the user's rooms. It is built in memory on first use for a user and is
+/// maintained by a vm.notify hook thereafter, so it can only answer for a
+/// since token after the point it was built; when the index is unavailable
+/// the caller falls back to iterating all rooms.
+namespace ircd::m::sync::changed
+{
+	using closure = std::function<bool (const room::id &, const event::idx &)>;
+
+	bool available(const user::id &, const event::idx &since);
+	bool for_each(const user::id &, const event::idx &since, const closure &);
+	size_t clear(const user::id &);
+	size_t clear();
+
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> max_users;
+	extern ircd::stats::item builds;
+	extern ircd::stats::item hits;
+	extern ircd::stats::item skipped;
+}
+
+/// Shared cache of serialized per-room sync fragments. Room item handlers
+/// which produce the same output for many users (i.e. the state, timeline
+/// and summary of a room at some head) compose their output once and it is
+/// spliced into the json::stack of every other request for the same key.
+/// The key is the room, the room head event_idx, the item name, the filter
+/// and a visibility class supplied by the handler; the latter allows the
+/// handler to segregate requests which would see different output (e.g. by
+/// membership, or by user when the output is personal). Fragments for a
+/// room are dropped when its head moves.
+namespace ircd::m::sync::cache
+{
+	using closure = std::function<bool (data &)>;
+
+	bool fragment(data &, const string_view &name, const string_view &vclass, const closure &);
+	size_t clear(const room::id &);
+	size_t clear();
+
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> max_bytes;
+	extern conf::item<size_t> max_fragment;
+	extern ircd::stats::item hits;
+	extern ircd::stats::item misses;
+	extern ircd::stats::item waits;
+	extern ircd::stats::item bytes;
+}
+
 struct ircd::m::sync::item
 :instance_multimap<std::string, item, std::less<>>
 {
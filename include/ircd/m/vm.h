@@ -83,6 +83,8 @@ struct ircd::m::vm::eval
 	vector_view<m::event> pdus;
 	const json::iov *issue {nullptr};
 	const event *event_ {nullptr};
+	const sha256::buf *pdu_hash {nullptr};
+	bool pdu_verified {false};
 	string_view room_id;
 	event::id::buf event_id;
 	event::conforms report;
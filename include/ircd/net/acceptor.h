@@ -28,6 +28,16 @@ struct ircd::net::acceptor
 	IRCD_EXCEPTION(listener::error, error)
 	IRCD_EXCEPTION(error, sni_warning)
 
+	/// Key material for stateless session tickets (RFC 5077). The name is
+	/// sent in the clear with each ticket to select the key for decryption.
+	struct ticket_key
+	{
+		std::array<uint8_t, 16> name;
+		std::array<uint8_t, 32> aes;
+		std::array<uint8_t, 32> hmac;
+		steady_point created;
+	};
+
 	static log::log log;
 	static conf::item<size_t> handshaking_max;
 	static conf::item<size_t> handshaking_max_per_peer;
@@ -35,6 +45,19 @@ struct ircd::net::acceptor
 	static conf::item<std::string> ssl_curve_list;
 	static conf::item<std::string> ssl_cipher_list;
 	static conf::item<std::string> ssl_cipher_blacklist;
+	static conf::item<bool> alpn_h2;
+	static conf::item<bool> ssl_session_tickets;
+	static conf::item<seconds> ssl_session_ticket_rotate;
+	static conf::item<size_t> ssl_session_cache_size;
+	static conf::item<seconds> ssl_session_timeout;
+	static stats::item handshakes_full;
+	static stats::item handshakes_resumed;
+	static conf::item<size_t> handshake_offload_threads;
+	static conf::item<size_t> handshake_offload_min;
+	static stats::item handshake_offload_steps;
+	static stats::item handshake_offload_queued;
+	static stats::item handshake_offload_queue_time;
+	static stats::item handshake_offload_queue_max;
 
 	net::listener *listener_;
 	std::string name;
@@ -50,6 +73,10 @@ struct ircd::net::acceptor
 	sockets handshaking;
 	bool interrupting {false};
 	ctx::dock joining;
+	std::deque<ticket_key> ticket_keys;          // front is current; others only decrypt
+	std::mutex ticket_keys_mutex;                // handshakes may run on the offload pool
+	seconds ticket_rotate {0};
+	std::atomic<bool> h2 {false};                // alpn_h2 as of the last accept
 
 	// Internal configuration
 	void configure_dh(const json::object &);
@@ -58,14 +85,21 @@ struct ircd::net::acceptor
 	void configure_ciphers(const json::object &);
 	void configure_flags(const json::object &);
 	void configure_password(const json::object &);
+	void configure_sessions(const json::object &);
 	void configure(const json::object &opts);
 
 	// Handshake stack
 	bool handle_sni(SSL &, int &ad);
 	string_view handle_alpn(SSL &, const vector_view<const string_view> &in);
+	int handle_ticket_key(ticket_key &, SSL &, const const_buffer &name);
 	void check_handshake_error(const error_code &ec, socket &) const;
 	void handshake(const error_code &, const std::shared_ptr<socket>, const decltype(handshaking)::const_iterator) noexcept;
 
+	// Offloaded handshake stack
+	void handshake_stepped(std::shared_ptr<socket>, const decltype(handshaking)::const_iterator, BIO *, const error_code &, const nanoseconds &queued) noexcept;
+	void handshake_step(std::shared_ptr<socket>, const decltype(handshaking)::const_iterator, BIO *);
+	void handshake_offload(std::shared_ptr<socket>, const decltype(handshaking)::const_iterator);
+
 	// Acceptance stack
 	static bool proffer_default(listener &, const ipport &);
 	bool check_handshake_limit(socket &, const ipport &) const;
@@ -0,0 +1,72 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_NET_IOU_H
+
+/// io_uring socket input.
+///
+/// When enabled, an established socket is not read by asio; instead a
+/// multishot recv on one ring shared by all sockets delivers the ciphertext
+/// into buffers selected by the kernel from a provided buffer ring. There is
+/// no readiness notification, no MSG_PEEK, and no recv(2) per read; the
+/// submissions made during an ios iteration go to the kernel in one
+/// io_uring_enter(2) and completions are reaped when the ring's eventfd is
+/// signaled. Writes are unaffected.
+///
+/// This interface is available whether or not the platform supports it; if
+/// it does not, the system pointer is always null and sockets use asio.
+namespace ircd::net::iou
+{
+	struct init;
+	struct system;
+	struct recv;
+	struct bench;
+
+	// a priori
+	extern const bool support;
+
+	// configuration
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> entries;
+	extern conf::item<size_t> buf_count;
+	extern conf::item<size_t> buf_size;
+	extern conf::item<size_t> pending_max;
+
+	// statistics
+	extern stats::item enters;
+	extern stats::item submits;
+	extern stats::item completions;
+	extern stats::item bytes;
+	extern stats::item arms;
+	extern stats::item nobufs;
+
+	// runtime state
+	extern struct system *system;
+}
+
+struct ircd::net::iou::init
+{
+	init();
+	~init() noexcept;
+};
+
+/// Loopback throughput of socket input by asio's reactor and by the ring.
+struct ircd::net::iou::bench
+{
+	size_t bytes {0};
+	nanoseconds reactor {0};
+	nanoseconds ring {0};
+	size_t reactor_reads {0};                    // each a readiness wait and recv(2)
+	size_t ring_enters {0};                      // io_uring_enter(2) during the transfer
+	size_t ring_cqes {0};
+
+	bench(const size_t &bytes, const size_t &chunk = 64_KiB);
+};
@@ -50,6 +50,7 @@ namespace ircd::net
 #include "read.h"
 #include "write.h"
 #include "scope_timeout.h"
+#include "iou.h"
 
 namespace ircd::net
 {
@@ -67,6 +68,7 @@ namespace ircd::net
 	const_buffer peer_cert_der(const mutable_buffer &, const socket &);
 	const_buffer peer_cert_der_sha256(const mutable_buffer &, const socket &);
 	string_view peer_cert_der_sha256_b64(const mutable_buffer &, const socket &);
+	string_view alpn(const socket &) noexcept;
 }
 
 // Exports to ircd::
@@ -77,6 +79,8 @@ namespace ircd
 
 struct ircd::net::init
 {
+	iou::init _iou_;
+
 	init();
 	~init() noexcept;
 };
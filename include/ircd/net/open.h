@@ -14,6 +14,7 @@
 namespace ircd::net
 {
 	struct open_opts;
+	struct session;
 	using open_callback = std::function<void (std::exception_ptr)>;
 
 	string_view common_name(const open_opts &);
@@ -113,6 +114,27 @@ struct ircd::net::open_opts
 
 	/// Option to allow expired certificates.
 	bool allow_expired { default_allow_expired };
+
+	/// TLS session state for resumption with this remote. A session saved
+	/// here by a prior connection is offered in the handshake, and sessions
+	/// issued by the remote replace it. This is shared so it can be kept by
+	/// the owner of these options (i.e server::peer) across connections.
+	std::shared_ptr<net::session> session;
+};
+
+/// Client-side TLS session cache entry for one remote. Opaque outside of
+/// the net unit; the session is only accessed on the main thread.
+struct ircd::net::session
+{
+	openssl::SSL_SESSION *ssl {nullptr};
+	uint64_t saved {0};                          // sessions issued by the remote
+	uint64_t offered {0};                        // handshakes offering a session
+	uint64_t resumed {0};                        // handshakes which resumed
+
+	session() = default;
+	session(session &&) = delete;
+	session(const session &) = delete;
+	~session() noexcept;
 };
 
 /// Constructor intended to provide implicit conversions (no-brackets required)
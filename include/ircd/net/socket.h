@@ -52,12 +52,16 @@ struct ircd::net::socket
 	static stats::item total_bytes_out;
 	static stats::item total_calls_in;
 	static stats::item total_calls_out;
+	static stats::item handshakes_full;
+	static stats::item handshakes_resumed;
 
 	uint64_t id {++count};
 	ip::tcp::socket sd;
 	asio::ssl::stream<ip::tcp::socket &> ssl;
 	stat in, out;
 	deadline_timer timer;
+	std::shared_ptr<net::session> session;       // client-side resumption
+	std::shared_ptr<iou::recv> iou;              // input by io_uring when attached
 	uint64_t timer_sem[2] {0};                   // handler, sender
 	bool timer_set {false};                      // boolean lockout
 	bool timedout {false};
@@ -71,6 +75,8 @@ struct ircd::net::socket
 	void handle_connect(std::weak_ptr<socket>, const open_opts &, eptr_handler, error_code) noexcept;
 	void handle_timeout(std::weak_ptr<socket>, ec_handler, error_code) noexcept;
 	void handle_ready(std::weak_ptr<socket>, ready, ec_handler, error_code) noexcept;
+	size_t read_iou(const vector_view<const mutable_buffer> &, const bool &one, const size_t &offset = 0);
+	void wait_iou();
 
   public:
 	operator const ip::tcp::socket &() const     { return sd;                                      }
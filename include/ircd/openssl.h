@@ -17,6 +17,7 @@
 struct ssl_st;
 struct ssl_ctx_st;
 struct ssl_cipher_st;
+struct ssl_session_st;
 struct rsa_st;
 struct x509_st;
 struct x509_store_ctx_st;
@@ -43,6 +44,7 @@ namespace ircd::openssl
 	using SSL = ::ssl_st;
 	using SSL_CTX = ::ssl_ctx_st;
 	using SSL_CIPHER = ::ssl_cipher_st;
+	using SSL_SESSION = ::ssl_session_st;
 	using RSA = ::rsa_st;
 	using X509 = ::x509_st;
 	using X509_STORE_CTX = ::x509_store_ctx_st;
@@ -18,6 +18,11 @@ struct ircd::resource::method
 	struct stats;
 	using handler = std::function<response (client &, request &)>;
 
+	static conf::item<bool> admit_enable;
+	static conf::item<milliseconds> admit_queue_max;
+	static conf::item<milliseconds> admit_queue_max_interactive;
+	static conf::item<milliseconds> admit_queue_max_expensive;
+	static conf::item<size_t> admit_expensive_share;
 	static ctx::dock idle_dock;
 
 	struct resource *resource;
@@ -28,6 +33,7 @@ struct ircd::resource::method
 	unique_const_iterator<decltype(resource::methods)> methods_it;
 
 	void handle_timeout(client &) const;
+	void admit(client &) const;
 	response call_handler(client &, request &);
 
   public:
@@ -45,6 +51,8 @@ enum ircd::resource::method::flag
 	RATE_LIMITED          = 0x02,
 	VERIFY_ORIGIN         = 0x04,   //TODO: matrix abstraction bleed.
 	CONTENT_DISCRETION    = 0x08,
+	INTERACTIVE           = 0x10,   // Cheap; admitted longest under load.
+	EXPENSIVE             = 0x20,   // Shed first under load.
 };
 
 struct ircd::resource::method::opts
@@ -61,6 +69,11 @@ struct ircd::resource::method::opts
 	/// MIME type; first part is the Registry (i.e application) and second
 	/// part is the format (i.e json). Empty value means nothing rejected.
 	std::pair<string_view, string_view> mime;
+
+	/// Token bucket for each requester when RATE_LIMITED: requests per second
+	/// sustained and the size of a burst. Zero takes the configured default.
+	float rate {0.0f};
+	uint32_t burst {0};
 };
 
 struct ircd::resource::method::stats
@@ -70,4 +83,6 @@ struct ircd::resource::method::stats
 	uint64_t timeouts {0};            // The method's timeout was exceeded.
 	uint64_t completions {0};         // The handler returned without throwing.
 	uint64_t internal_errors {0};     // The handler threw a very bad exception.
+	uint64_t queue_time {0};          // Microseconds requests waited for a ctx.
+	uint64_t shed {0};                // Refused by admission control.
 };
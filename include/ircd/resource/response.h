@@ -81,18 +81,39 @@ struct ircd::resource::response
 /// encoding with some other content has the option of setting a zero buffer
 /// size on construction.
 ///
+/// When the client accepts it, textual content is compressed with the gzip
+/// content-coding as it is written. The compressor retains input until it
+/// has enough to emit, so a write() no longer corresponds to a chunk on the
+/// wire; flush() consumes the whole buffer it is given regardless.
+///
 struct ircd::resource::response::chunked
 :resource::response
 {
 	static conf::item<size_t> default_buffer_size;
+	static conf::item<bool> encoding_enable;
+	static conf::item<int64_t> encoding_level;
+	static conf::item<size_t> encoding_buffer_size;
+	static conf::item<size_t> encoding_offload_min;
+	static stats::item encoding_bytes_in;
+	static stats::item encoding_bytes_out;
+	static stats::item encoding_count;
 
 	client *c {nullptr};
 	unique_buffer<mutable_buffer> buf;
+	std::unique_ptr<zlib::deflate> encoder;
+	unique_buffer<mutable_buffer> encoder_buf;
 	size_t flushed {0};
 	size_t wrote {0};
 	uint count {0};
 	bool finished {false};
 
+  private:
+	static bool chunked_encoding(const client &, const string_view &content_type);
+
+	size_t write_chunk(const const_buffer &chunk, const bool &ignore_empty);
+	size_t write_encoded(const const_buffer &chunk, const bool &finish);
+
+  public:
 	size_t write(const const_buffer &chunk, const bool &ignore_empty = true);
 	const_buffer flush(const const_buffer &);
 	bool finish();
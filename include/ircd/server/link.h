@@ -32,6 +32,8 @@ struct ircd::server::link
 	time_t synack_ts {0L};                       ///< time socket was estab
 	time_t read_ts {0L};                         ///< time of last read
 	time_t write_ts {0L};                        ///< time of last write
+	steady_point done_ts;                        ///< time of last tag done
+	microseconds latency {0};                    ///< EWMA tag queued to done
 	bool op_init {false};                        ///< link is connecting
 	bool op_fini {false};                        ///< link is disconnecting
 	bool op_open {false};
@@ -38,6 +38,9 @@ struct ircd::server::peer
 	std::string server_version;
 	size_t write_bytes {0};
 	size_t read_bytes {0};
+	microseconds rtt {0};         // EWMA request sent to response head
+	double rate {0.0};            // EWMA response bytes per second
+	size_t read_avg {0};          // EWMA response size
 	bool op_resolve {false};
 	bool op_fini {false};
 
@@ -99,6 +102,9 @@ struct ircd::server::peer
 	size_t write_total() const;
 	size_t read_total() const;
 
+	// expected completion time of a request placed on the link (or new link)
+	microseconds expected(const link *) const;
+
 	// link control panel
 	link &link_add(const size_t &num = 1);
 	link *link_get(const request &);
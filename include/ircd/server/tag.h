@@ -39,6 +39,9 @@ struct ircd::server::tag
 		size_t chunk_read {0};         // content read after last chunk head
 		size_t chunk_length {0};       // -1 for chunk header mode
 		http::code status {(http::code)0};
+		steady_point queued;           // placed on a link's queue
+		steady_point sent;             // request entirely written
+		steady_point head;             // response head received
 	}
 	state;
 	ctx::promise<http::code> p;
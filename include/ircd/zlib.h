@@ -0,0 +1,54 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_ZLIB_H
+
+// Forward declarations for zlib because it is not included here.
+struct z_stream_s;
+
+/// zlib compression interface.
+namespace ircd::zlib
+{
+	struct deflate;
+
+	IRCD_EXCEPTION(ircd::error, error)
+
+	extern const bool available;
+	extern const info::versions version_api, version_abi;
+}
+
+/// Streaming compressor. Input is fed incrementally and the compressed
+/// output is produced into the caller's buffer as it becomes available. Each
+/// feeding is sync-flushed so the receiver can decode everything sent so far
+/// without waiting for the stream to finish. The output has a gzip (RFC 1952) wrapper by default, otherwise
+/// a zlib (RFC 1950) wrapper for HTTP's "deflate" content-coding.
+///
+/// This object holds no references to the ircd::ctx which created it, so
+/// the calls may be made from an offload thread.
+struct ircd::zlib::deflate
+{
+	std::unique_ptr<z_stream_s> z;
+	size_t consumed {0};
+	size_t produced {0};
+	bool flushed {true};
+	bool finished {false};
+
+	// Compresses `in` into `out`, advancing `in` past the input consumed.
+	// Returns the view of `out` written, which may be empty. The caller
+	// repeats while `in` is not empty or not flushed; with `finish` set,
+	// until finished.
+	const_buffer operator()(const mutable_buffer &out, const_buffer &in, const bool &finish = false);
+
+	deflate(const int &level = -1, const bool &gzip = true);
+	deflate(deflate &&) = delete;
+	deflate(const deflate &) = delete;
+	~deflate() noexcept;
+};
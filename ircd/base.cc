@@ -8,9 +8,7 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/binary_from_base64.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
+#include <ircd/simd.h>
 
 namespace [[gnu::visibility("hidden")]] ircd
 {
@@ -94,6 +92,31 @@ namespace [[gnu::visibility("hidden")]] ircd
 	static std::string _b64encode(const const_buffer &in, const _b64_encoder &);
 }
 
+/// Base64 for the standard and URL-safe alphabets; the alphabets differ only
+/// by the characters for 62 and 63, which parameterize everything here. The
+/// vector paths produce exactly the output of the scalar path; they only
+/// stop earlier, leaving the remainder to it.
+namespace ircd::b64
+{
+	template<char c62, char c63> static constexpr std::array<char, 64> make_dict() noexcept;
+	template<char c62, char c63> static constexpr std::array<u8, 256> make_index() noexcept;
+	template<char c62, char c63> static constexpr const auto dict {make_dict<c62, c63>()};
+	template<char c62, char c63> static constexpr const auto index {make_index<c62, c63>()};
+
+	#if defined(IRCD_SIMD) && defined(__SSSE3__)
+	template<char c62, char c63> static u128x1 encode_block(const u128x1) noexcept;
+	template<char c62, char c63> static bool decode_block(u128x1 &, const u128x1) noexcept;
+	#endif
+
+	#if defined(IRCD_SIMD) && defined(__AVX2__)
+	template<char c62, char c63> static u256x1 encode_block(const u256x1) noexcept;
+	template<char c62, char c63> static bool decode_block(u256x1 &, const u256x1) noexcept;
+	#endif
+
+	template<char c62, char c63> static string_view encode(const mutable_buffer &, const const_buffer &) noexcept;
+	template<char c62, char c63> static const_buffer decode(const mutable_buffer &, const string_view &);
+}
+
 namespace [[gnu::visibility("default")]] ircd
 {
 	// this stub needed for clang
@@ -170,27 +193,15 @@ ircd::string_view
 ircd::b64encode_unpadded(const mutable_buffer &out,
                          const const_buffer &in)
 {
-	namespace iterators = boost::archive::iterators;
-	using transform = iterators::transform_width<unsigned char *, 6, 8>;
-	using b64fb = iterators::base64_from_binary<transform>;
-
-	const auto cpsz
-	{
-		std::min(size(in), size_t(size(out) * (3.0 / 4.0)))
-	};
-
-	const auto end
-	{
-		std::copy(b64fb(data(in)), b64fb(data(in) + cpsz), begin(out))
-	};
-
-	const auto len
-	{
-		size_t(std::distance(begin(out), end))
-	};
+	return b64::encode<'+', '/'>(out, in);
+}
 
-	assert(len <= size(out));
-	return { data(out), len };
+/// Encoding in to base64url at out. Out must be 1.33+ larger than in.
+ircd::string_view
+ircd::b64urlencode_unpadded(const mutable_buffer &out,
+                            const const_buffer &in)
+{
+	return b64::encode<'-', '_'>(out, in);
 }
 
 std::string
@@ -224,27 +235,416 @@ ircd::const_buffer
 ircd::b64decode(const mutable_buffer &out,
                 const string_view &in)
 {
-	namespace iterators = boost::archive::iterators;
-	using b64bf = iterators::binary_from_base64<const char *>;
-	using transform = iterators::transform_width<b64bf, 8, 6>;
+	return b64::decode<'+', '/'>(out, in);
+}
+
+/// Decode base64url from in to the buffer at out; out can be 75% of the
+/// size of in.
+ircd::const_buffer
+ircd::b64urldecode(const mutable_buffer &out,
+                   const string_view &in)
+{
+	return b64::decode<'-', '_'>(out, in);
+}
+
+//
+// b64 internal
+//
+
+/// Encode without padding. Input beyond what fits the output is ignored.
+template<char c62,
+         char c63>
+ircd::string_view
+ircd::b64::encode(const mutable_buffer &out,
+                  const const_buffer &in)
+noexcept
+{
+	const size_t len
+	{
+		std::min(size(in), size_t(size(out) * (3.0 / 4.0)))
+	};
+
+	const u8 *i(reinterpret_cast<const u8 *>(data(in)));
+	const u8 *const ie(i + len);
+	char *o(data(out));
+
+	// 24 bytes to 32 characters; the two halves are loaded 12 bytes apart
+	// so each 128-bit lane holds the 12 bytes it encodes.
+	#if defined(IRCD_SIMD) && defined(__AVX2__)
+	for(; i + 12 + sizeof(u128x1) <= ie; i += 24, o += 32)
+	{
+		const u256x1 in
+		{
+			_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const u128x1_u *>(i))),
+			                        _mm_loadu_si128(reinterpret_cast<const u128x1_u *>(i + 12)), 1)
+		};
+
+		_mm256_storeu_si256(reinterpret_cast<u256x1_u *>(o), encode_block<c62, c63>(in));
+	}
+	#endif
+
+	// 12 bytes to 16 characters; the load reads 4 bytes beyond.
+	#if defined(IRCD_SIMD) && defined(__SSSE3__)
+	for(; i + sizeof(u128x1) <= ie; i += 12, o += 16)
+	{
+		const u128x1 in
+		{
+			_mm_loadu_si128(reinterpret_cast<const u128x1_u *>(i))
+		};
+
+		_mm_storeu_si128(reinterpret_cast<u128x1_u *>(o), encode_block<c62, c63>(in));
+	}
+	#endif
+
+	for(; i + 3 <= ie; i += 3, o += 4)
+	{
+		const u32 v(u32(i[0]) << 16 | u32(i[1]) << 8 | u32(i[2]));
+		o[0] = dict<c62, c63>[(v >> 18) & 0x3f];
+		o[1] = dict<c62, c63>[(v >> 12) & 0x3f];
+		o[2] = dict<c62, c63>[(v >> 6) & 0x3f];
+		o[3] = dict<c62, c63>[v & 0x3f];
+	}
+
+	if(ie - i == 2)
+	{
+		const u32 v(u32(i[0]) << 16 | u32(i[1]) << 8);
+		*o++ = dict<c62, c63>[(v >> 18) & 0x3f];
+		*o++ = dict<c62, c63>[(v >> 12) & 0x3f];
+		*o++ = dict<c62, c63>[(v >> 6) & 0x3f];
+	}
+	else if(ie - i == 1)
+	{
+		const u32 v(u32(i[0]) << 16);
+		*o++ = dict<c62, c63>[(v >> 18) & 0x3f];
+		*o++ = dict<c62, c63>[(v >> 12) & 0x3f];
+	}
+
+	assert(o <= data(out) + size(out));
+	return string_view
+	{
+		data(out), o
+	};
+}
 
+/// Decode with or without padding. A trailing character which does not
+/// complete a byte is ignored.
+template<char c62,
+         char c63>
+ircd::const_buffer
+ircd::b64::decode(const mutable_buffer &out,
+                  const string_view &in)
+{
 	const auto pads
 	{
 		endswith_count(in, _b64_pad_)
 	};
 
-	const auto e
+	const u8 *const ib(reinterpret_cast<const u8 *>(data(in)));
+	const u8 *const ie(ib + size(in) - pads);
+	const u8 *i(ib);
+	u8 *const ob(reinterpret_cast<u8 *>(data(out)));
+	u8 *const oe(ob + size(out));
+	u8 *o(ob);
+
+	// The vector paths leave any invalid input to the scalar path to find.
+	#if defined(IRCD_SIMD) && defined(__AVX2__)
+	for(; i + sizeof(u256x1) <= ie && o + sizeof(u256x1) <= oe; i += 32, o += 24)
+	{
+		u256x1 block;
+		if(!decode_block<c62, c63>(block, _mm256_loadu_si256(reinterpret_cast<const u256x1_u *>(i))))
+			break;
+
+		_mm256_storeu_si256(reinterpret_cast<u256x1_u *>(o), block);
+	}
+	#endif
+
+	#if defined(IRCD_SIMD) && defined(__SSSE3__)
+	for(; i + sizeof(u128x1) <= ie && o + sizeof(u128x1) <= oe; i += 16, o += 12)
+	{
+		u128x1 block;
+		if(!decode_block<c62, c63>(block, _mm_loadu_si128(reinterpret_cast<const u128x1_u *>(i))))
+			break;
+
+		_mm_storeu_si128(reinterpret_cast<u128x1_u *>(o), block);
+	}
+	#endif
+
+	const auto &idx(index<c62, c63>);
+	const size_t rem((ie - i) % 4);
+	const size_t need((ie - i) / 4 * 3 + (rem? rem - 1 : 0));
+	if(unlikely(o + need > oe))
+		throw error
+		{
+			"Insufficient buffer of %zu bytes to decode %zu base64 characters.",
+			size(out),
+			size(in),
+		};
+
+	for(; i < ie; i += 4)
+	{
+		const size_t n(std::min(ssize_t(4), ie - i));
+		u32 v(0);
+		for(size_t j(0); j < n; ++j)
+		{
+			if(unlikely(idx[i[j]] & 0x80))
+				throw error
+				{
+					"Invalid base64 character at position %zu.",
+					size_t(i + j - ib),
+				};
+
+			v |= u32(idx[i[j]]) << (18 - 6 * j);
+		}
+
+		for(size_t j(0); j + 1 < n; ++j)
+			*o++ = u8(v >> (16 - 8 * j));
+	}
+
+	assert(o <= oe);
+	return const_buffer
+	{
+		data(out), size_t(o - ob)
+	};
+}
+
+#if defined(IRCD_SIMD) && defined(__AVX2__)
+template<char c62,
+         char c63>
+ircd::u256x1
+ircd::b64::encode_block(const u256x1 in)
+noexcept
+{
+	const u256x1 split
 	{
-		std::copy(transform(begin(in)), transform(begin(in) + size(in) - pads), begin(out))
+		_mm256_shuffle_epi8(in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+		                                        10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1))
 	};
 
-	const auto len
+	const u256x1 t0        { _mm256_and_si256(split, _mm256_set1_epi32(0x0fc0fc00))        };
+	const u256x1 t1        { _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040))          };
+	const u256x1 t2        { _mm256_and_si256(split, _mm256_set1_epi32(0x003f03f0))        };
+	const u256x1 t3        { _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010))          };
+	const u256x1 sextets   { _mm256_or_si256(t1, t3)                                        };
+	const u256x1 reduced   { _mm256_subs_epu8(sextets, _mm256_set1_epi8(51))                };
+	const u256x1 upper     { _mm256_cmpgt_epi8(_mm256_set1_epi8(26), sextets)               };
+	const u256x1 range     { _mm256_or_si256(reduced, _mm256_and_si256(upper, _mm256_set1_epi8(13))) };
+	const u256x1 offsets
+	{
+		_mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		                 '0' - 52, '0' - 52, '0' - 52, c62 - 62, c63 - 63, 'A', 0, 0,
+		                 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		                 '0' - 52, '0' - 52, '0' - 52, c62 - 62, c63 - 63, 'A', 0, 0)
+	};
+
+	return _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), sextets);
+}
+
+template<char c62,
+         char c63>
+bool
+ircd::b64::decode_block(u256x1 &out,
+                        const u256x1 in)
+noexcept
+{
+	const auto between{[&in](const char lo, const char hi)
+	{
+		return _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8(lo - 1)),
+		                        _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), in));
+	}};
+
+	const u256x1 upper     { between('A', 'Z')                                             };
+	const u256x1 lower     { between('a', 'z')                                             };
+	const u256x1 digit     { between('0', '9')                                             };
+	const u256x1 is62      { _mm256_cmpeq_epi8(in, _mm256_set1_epi8(c62))                  };
+	const u256x1 is63      { _mm256_cmpeq_epi8(in, _mm256_set1_epi8(c63))                  };
+	const u256x1 valid
+	{
+		_mm256_or_si256(_mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, is62)), is63)
+	};
+
+	if(u32(_mm256_movemask_epi8(valid)) != 0xffffffffU)
+		return false;
+
+	const u256x1 shift
+	{
+		_mm256_or_si256(_mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+		                                _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+		                _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+		                                                _mm256_and_si256(is62, _mm256_set1_epi8(62 - c62))),
+		                                _mm256_and_si256(is63, _mm256_set1_epi8(63 - c63))))
+	};
+
+	const u256x1 sextets   { _mm256_add_epi8(in, shift)                                     };
+	const u256x1 pairs     { _mm256_maddubs_epi16(sextets, _mm256_set1_epi32(0x01400140))   };
+	const u256x1 triples   { _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000))        };
+	const u256x1 packed
+	{
+		_mm256_shuffle_epi8(triples, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		                                              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1))
+	};
+
+	out = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+	return true;
+}
+#endif
+
+#if defined(IRCD_SIMD) && defined(__SSSE3__)
+template<char c62,
+         char c63>
+ircd::u128x1
+ircd::b64::encode_block(const u128x1 in)
+noexcept
+{
+	const u128x1 split
+	{
+		_mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1))
+	};
+
+	const u128x1 t0        { _mm_and_si128(split, _mm_set1_epi32(0x0fc0fc00))              };
+	const u128x1 t1        { _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040))                };
+	const u128x1 t2        { _mm_and_si128(split, _mm_set1_epi32(0x003f03f0))              };
+	const u128x1 t3        { _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010))                };
+	const u128x1 sextets   { _mm_or_si128(t1, t3)                                           };
+	const u128x1 reduced   { _mm_subs_epu8(sextets, _mm_set1_epi8(51))                      };
+	const u128x1 upper     { _mm_cmpgt_epi8(_mm_set1_epi8(26), sextets)                     };
+	const u128x1 range     { _mm_or_si128(reduced, _mm_and_si128(upper, _mm_set1_epi8(13))) };
+	const u128x1 offsets
+	{
+		_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		              '0' - 52, '0' - 52, '0' - 52, c62 - 62, c63 - 63, 'A', 0, 0)
+	};
+
+	return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), sextets);
+}
+
+template<char c62,
+         char c63>
+bool
+ircd::b64::decode_block(u128x1 &out,
+                        const u128x1 in)
+noexcept
+{
+	const auto between{[&in](const char lo, const char hi)
+	{
+		return _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(lo - 1)),
+		                     _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), in));
+	}};
+
+	const u128x1 upper     { between('A', 'Z')                                             };
+	const u128x1 lower     { between('a', 'z')                                             };
+	const u128x1 digit     { between('0', '9')                                             };
+	const u128x1 is62      { _mm_cmpeq_epi8(in, _mm_set1_epi8(c62))                        };
+	const u128x1 is63      { _mm_cmpeq_epi8(in, _mm_set1_epi8(c63))                        };
+	const u128x1 valid
+	{
+		_mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, is62)), is63)
+	};
+
+	if(_mm_movemask_epi8(valid) != 0xffff)
+		return false;
+
+	const u128x1 shift
+	{
+		_mm_or_si128(_mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+		                          _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+		             _mm_or_si128(_mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+		                                       _mm_and_si128(is62, _mm_set1_epi8(62 - c62))),
+		                          _mm_and_si128(is63, _mm_set1_epi8(63 - c63))))
+	};
+
+	const u128x1 sextets   { _mm_add_epi8(in, shift)                                        };
+	const u128x1 pairs     { _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140))         };
+	const u128x1 triples   { _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000))              };
+	out = _mm_shuffle_epi8(triples, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	return true;
+}
+#endif
+
+template<char c62,
+         char c63>
+constexpr std::array<ircd::u8, 256>
+ircd::b64::make_index()
+noexcept
+{
+	std::array<u8, 256> ret {0};
+	for(size_t i(0); i < ret.size(); ++i)
+		ret[i] = 0xff;
+
+	for(size_t i(0); i < 64; ++i)
+		ret[u8(make_dict<c62, c63>()[i])] = i;
+
+	return ret;
+}
+
+template<char c62,
+         char c63>
+constexpr std::array<char, 64>
+ircd::b64::make_dict()
+noexcept
+{
+	std::array<char, 64> ret {0};
+	for(size_t i(0); i < 26; ++i)
+		ret[i] = 'A' + i;
+
+	for(size_t i(0); i < 26; ++i)
+		ret[26 + i] = 'a' + i;
+
+	for(size_t i(0); i < 10; ++i)
+		ret[52 + i] = '0' + i;
+
+	ret[62] = c62;
+	ret[63] = c63;
+	return ret;
+}
+
+/// Known answers from RFC 4648 section 10, and in both alphabets, for the
+/// kernel this was compiled with. The longer inputs span whole vector blocks
+/// and make use of the characters for 62 and 63.
+void
+ircd::b64::check()
+{
+	static const string_view vectors[][3]
 	{
-		std::distance(begin(out), e)
+		// binary, base64, base64url unpadded
+		{ ""_sv,          "",          ""          },
+		{ "f"_sv,         "Zg==",      "Zg"        },
+		{ "fo"_sv,        "Zm8=",      "Zm8"       },
+		{ "foo"_sv,       "Zm9v",      "Zm9v"      },
+		{ "foob"_sv,      "Zm9vYg==",  "Zm9vYg"    },
+		{ "fooba"_sv,     "Zm9vYmE=",  "Zm9vYmE"   },
+		{ "foobar"_sv,    "Zm9vYmFy",  "Zm9vYmFy"  },
+		{ "\xfb\xff"_sv,  "+/8=",      "-_8"       },
+		{
+			"\xfb\xef\xbe\xff\xff\xff\xfb\xef\xbe\xff\xff\xff\xfb\xef\xbe\xff\xff\xff\xfb\xef\xbe\xff\xff\xff"
+			"\xfb\xef\xbe\xff\xff\xff\xfb\xef\xbe\xff\xff\xff\xfb\xef\xbe\xff\xff\xff\xfb\xef\xbe\xff\xff\xff"_sv,
+			"++++////++++////++++////++++////++++////++++////++++////++++////",
+			"----____----____----____----____----____----____----____----____",
+		},
+		{
+			"\x00\x05\x0a\x0f\x14\x19\x1e\x23\x28\x2d\x32\x37\x3c\x41\x46\x4b\x50\x55\x5a\x5f\x64\x69\x6e\x73\x78\x7d"
+			"\x82\x87\x8c\x91\x96\x9b\xa0\xa5\xaa\xaf\xb4\xb9\xbe\xc3\xc8\xcd\xd2\xd7\xdc\xe1\xe6\xeb\xf0\xf5\xfa\xff"_sv,
+			"AAUKDxQZHiMoLTI3PEFGS1BVWl9kaW5zeH2Ch4yRlpugpaqvtLm+w8jN0tfc4ebr8PX6/w==",
+			"AAUKDxQZHiMoLTI3PEFGS1BVWl9kaW5zeH2Ch4yRlpugpaqvtLm-w8jN0tfc4ebr8PX6_w",
+		},
 	};
 
-	assert(size_t(len) <= size(out));
-	return { data(out), size_t(len) };
+	char buf[128];
+	for(const auto &[bin, enc, url] : vectors)
+	{
+		const bool ok
+		{
+			b64encode(buf, bin) == enc &&
+			b64urlencode_unpadded(buf, bin) == url &&
+			string_view(b64decode(buf, enc)) == bin &&
+			string_view(b64urldecode(buf, url)) == bin
+		};
+
+		if(unlikely(!ok))
+			throw error
+			{
+				"base64 codec does not reproduce the known answer '%s'", enc
+			};
+	}
 }
 
 namespace ircd
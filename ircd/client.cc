@@ -33,6 +33,20 @@ ircd::client::settings::stack_size
 	{ "default",  ssize_t(1_MiB)            },
 };
 
+ircd::conf::item<size_t>
+ircd::client::settings::pipeline_depth
+{
+	{ "name",     "ircd.client.pipeline_depth"  },
+	{ "default",  32L                           },
+	{ "help",
+	R"(
+	Number of requests a client may have handled by one request context
+	before yielding it back to the pool. Requests which have already arrived
+	when one finishes are read and handled without another readiness wait
+	or pool acquisition until this is reached; 1 disables reading ahead.
+	)"},
+};
+
 ircd::conf::item<size_t>
 ircd::client::settings::pool_size
 {
@@ -273,7 +287,17 @@ ircd::client::create(net::listener &,
 size_t
 ircd::client::count(const net::ipport &remote)
 {
-	return client::map.count(remote);
+	// HTTP/2 stream clients share their connection's socket.
+	const auto range
+	{
+		client::map.equal_range(remote)
+	};
+
+	return std::count_if(range.first, range.second, []
+	(const auto &pair)
+	{
+		return !pair.second->stream;
+	});
 }
 
 ircd::parse::read_closure
@@ -394,6 +418,9 @@ ircd::handle_client_ready(std::shared_ptr<client> client,
 	if(!handle_ec(*client, ec))
 		return;
 
+	// Marks the time this request starts waiting for a ctx.
+	client->timer = ircd::timer{};
+
 	auto handler
 	{
 		std::bind(ircd::handle_client_request, std::move(client))
@@ -424,6 +451,7 @@ try
 	assert(!client->reqctx);
 	client->reqctx = ctx::current;
 	client->ready_count++;
+	client->queue_time = client->timer.at<microseconds>();
 	const unwind reset{[&client]
 	{
 		assert(bool(client));
@@ -576,6 +604,15 @@ ircd::handle_ec_timeout(client &client)
 try
 {
 	assert(bool(client.sock));
+
+	// An HTTP/2 connection is not idle while any of its streams are active;
+	// those might not be reading or writing the socket for some time.
+	if(client.h2c && client.h2c->active() && !client.reqctx)
+	{
+		client.async();
+		return false;
+	}
+
 	log::debug
 	{
 		client::log, "%s disconnecting after inactivity timeout",
@@ -670,7 +707,9 @@ catch(const std::exception &e)
 /// Nothing from the socket has been read into userspace before main().
 ///
 /// This function parses requests off the socket in a loop until there are no
-/// more requests or there is a fatal error. The ctx will "block" to wait for
+/// more requests or there is a fatal error. Requests pipelined by the client
+/// are handled in order, each response written before the next request is
+/// parsed; see settings::pipeline_depth. The ctx will "block" to wait for
 /// more data off the socket during the middle of a request until the request
 /// timeout is reached. main() will not "block" to wait for more data after a
 /// request; it will simply `return true` which puts this client back into
@@ -687,6 +726,20 @@ bool
 ircd::client::main()
 try
 {
+	if(h2c || h2::negotiated(*this))
+	{
+		if(!h2c)
+			h2c = std::make_unique<h2>(*this);
+
+		return h2c->main();
+	}
+
+	const size_t pipeline_depth
+	{
+		settings.pipeline_depth
+	};
+
+	size_t handled(0);
 	parse::buffer pb{head_buffer};
 	parse::capstan pc{pb, read_closure(*this)}; do
 	{
@@ -696,9 +749,26 @@ try
 		// After the request, the head and content has been read off the socket
 		// and the capstan has advanced to the end of the content. The catch is
 		// that reading off the socket could have read too much, bleeding into
-		// the next request. This is rare, but pb.remove() will memmove() the
-		// bleed back to the beginning of the head buffer for the next loop.
+		// the next request. With pipelining clients this is common; pb.remove()
+		// will memmove() the bleed back to the beginning of the head buffer
+		// for the next loop.
 		pb.remove();
+		++handled;
+
+		// Requests which follow on this ctx did not wait in the queue.
+		queue_time = 0us;
+
+		// When nothing is left over, any request which has already arrived is
+		// read without blocking so it is handled on this ctx rather than
+		// after another trip through async mode and the request pool. The
+		// depth bounds how long one client holds the ctx; whatever is
+		// already in the buffer is always handled since it can't be returned
+		// to the socket.
+		if(!pc.unparsed() && handled < pipeline_depth)
+			pb.read += net::read_one(*sock, mutable_buffer
+			{
+				pb.read, pb.stop
+			});
 	}
 	while(pc.unparsed());
 
@@ -995,6 +1065,13 @@ ircd::client::discard_unconsumed(const http::request::head &head)
 ircd::ctx::future<void>
 ircd::client::close(const net::close_opts &opts)
 {
+	// A stream client only closes its stream.
+	if(stream)
+	{
+		h2::reset(*this);
+		return ctx::already;
+	}
+
 	return likely(sock) && !sock->fini?
 		net::close(*sock, opts):
 		ctx::already;
@@ -1007,6 +1084,12 @@ ircd::client::close(const net::close_opts &opts,
 	if(!sock)
 		return;
 
+	if(stream)
+	{
+		h2::reset(*this);
+		return callback({});
+	}
+
 	if(sock->fini)
 		return callback({});
 
@@ -1028,6 +1111,9 @@ ircd::client::write_all(const const_buffer &buf)
 			make_error_code(std::errc::not_connected)
 		};
 
+	if(stream)
+		return h2::write(*this, buf);
+
 	return net::write_all(*sock, buf);
 }
 
@@ -1045,12 +1131,14 @@ const
 	thread_local char locbuf[128];
 	return fmt::sprintf
 	{
-		buf, "socket:%lu local:%s remote:%s client:%lu req:%lu:%lu",
+		buf, "socket:%lu local:%s remote:%s client:%lu req:%lu:%lu%s%u",
 		sock? net::id(*sock) : -1UL,
 		string(locbuf, ircd::local(*this)),
 		string(rembuf, ircd::remote(*this)),
 		id,
 		ready_count,
-		request_count
+		request_count,
+		stream? " stream:"_sv : string_view{},
+		stream? stream->id : 0U,
 	};
 }
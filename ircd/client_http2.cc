@@ -0,0 +1,1289 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd
+{
+	static const_buffer h2_unpad(const http2::frame::header &, const const_buffer &);
+	static uint32_t h2_be32(const const_buffer &, const size_t &off = 0);
+	static void handle_client_stream(std::shared_ptr<client>, std::shared_ptr<client>);
+}
+
+/// A request stream on the connection. The request head and content are
+/// collected here by the connection; the stream is then dispatched to its
+/// own client (req) which runs the resource on a request context. That
+/// context alone removes the stream from the connection when finished.
+struct ircd::client::h2::stream
+:http2::stream
+{
+	h2 *conn;
+	std::shared_ptr<ircd::client> req;
+	std::string method;
+	std::string path;
+	std::string authority;
+	std::string headers;
+	std::string content;
+	std::string response_head;
+	int64_t send_window;
+	bool malformed {false};
+	bool dispatched {false};
+	bool head_sent {false};
+	bool writing {false};
+	bool reset {false};
+
+	size_t send_data(const_buffer, const bool &fin);
+	void send_head(const string_view &);
+	size_t write(const const_buffer &);
+	void finish();
+
+	stream(h2 &, const uint32_t &id);
+};
+
+decltype(ircd::client::h2::max_concurrent_streams)
+ircd::client::h2::max_concurrent_streams
+{
+	{ "name",     "ircd.client.h2.max_concurrent_streams" },
+	{ "default",  32L                                     },
+};
+
+decltype(ircd::client::h2::initial_window_size)
+ircd::client::h2::initial_window_size
+{
+	{ "name",     "ircd.client.h2.initial_window_size" },
+	{ "default",  long(256_KiB)                        },
+};
+
+decltype(ircd::client::h2::max_frame_size)
+ircd::client::h2::max_frame_size
+{
+	{ "name",     "ircd.client.h2.max_frame_size" },
+	{ "default",  long(16_KiB)                    },
+};
+
+decltype(ircd::client::h2::header_table_size)
+ircd::client::h2::header_table_size
+{
+	{ "name",     "ircd.client.h2.header_table_size" },
+	{ "default",  long(4_KiB)                        },
+};
+
+decltype(ircd::client::h2::max_header_list_size)
+ircd::client::h2::max_header_list_size
+{
+	{ "name",     "ircd.client.h2.max_header_list_size" },
+	{ "default",  long(16_KiB)                          },
+};
+
+decltype(ircd::client::h2::content_max)
+ircd::client::h2::content_max
+{
+	{ "name",     "ircd.client.h2.content_max" },
+	{ "default",  long(8_MiB)                  },
+	{ "help",
+
+	"Maximum request content buffered for a stream before it is dispatched;"
+	" requests with larger content are reset."
+
+	},
+};
+
+bool
+ircd::client::h2::negotiated(const client &client)
+{
+	return client.sock && net::alpn(*client.sock) == "h2";
+}
+
+size_t
+ircd::client::h2::write(client &client,
+                        const const_buffer &buf)
+{
+	assert(client.stream);
+	auto &stream
+	{
+		static_cast<h2::stream &>(*client.stream)
+	};
+
+	return stream.write(buf);
+}
+
+void
+ircd::client::h2::reset(client &client)
+try
+{
+	assert(client.stream);
+	auto &stream
+	{
+		static_cast<h2::stream &>(*client.stream)
+	};
+
+	if(stream.reset)
+		return;
+
+	stream.reset = true;
+	stream.conn->dock.notify_all();
+	if(!stream.conn->closed)
+		stream.conn->send_rst(stream.id, http2::error::CANCEL);
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "%s reset :%s",
+		client.loghead(),
+		e.what(),
+	};
+}
+
+//
+// h2::h2
+//
+
+ircd::client::h2::h2(client &c)
+:c
+{
+	&c
+}
+,buf
+{
+	size_t(max_frame_size) + 9
+}
+{
+	using code = http2::settings::code;
+
+	local[code::HEADER_TABLE_SIZE] = size_t(header_table_size);
+	local[code::ENABLE_PUSH] = 0;
+	local[code::MAX_CONCURRENT_STREAMS] = size_t(max_concurrent_streams);
+	local[code::INITIAL_WINDOW_SIZE] = size_t(initial_window_size);
+	local[code::MAX_FRAME_SIZE] = size_t(max_frame_size);
+	local[code::MAX_HEADER_LIST_SIZE] = size_t(max_header_list_size);
+}
+
+ircd::client::h2::~h2()
+noexcept
+{
+	// Each dispatched stream holds a reference to the connection's client.
+	assert(std::all_of(begin(streams), end(streams), [](const auto &p)
+	{
+		return !p.second->dispatched;
+	}));
+}
+
+bool
+ircd::client::h2::active()
+const
+{
+	return !streams.empty();
+}
+
+/// Connection main loop. All frames available on the socket are processed;
+/// when a frame is only partially received we wait for the remainder under
+/// the client's request timeout. Returns true to put the connection back into
+/// async mode, or false to close it.
+bool
+ircd::client::h2::main()
+try
+{
+	const unwind_exceptional on_error{[this]
+	{
+		closed = true;
+		dock.notify_all();
+	}};
+
+	if(!preface)
+	{
+		const net::scope_timeout timeout
+		{
+			*c->sock, c->conf->request_timeout
+		};
+
+		char pbuf[24];
+		const string_view received
+		{
+			pbuf, net::read_all(*c->sock, mutable_buffer{pbuf})
+		};
+
+		if(received != http2::connection_preface)
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "Invalid connection preface."
+			};
+
+		preface = true;
+		send_settings();
+	}
+
+	while(1)
+	{
+		buf_have -= handle_frames();
+		if(goaway && streams.empty())
+		{
+			closed = true;
+			dock.notify_all();
+			return false;
+		}
+
+		const mutable_buffer space
+		{
+			data(buf) + buf_have, size(buf) - buf_have
+		};
+
+		size_t got
+		{
+			net::read_one(*c->sock, space)
+		};
+
+		if(!got && !buf_have)
+			return true;
+
+		if(!got)
+		{
+			const net::scope_timeout timeout
+			{
+				*c->sock, c->conf->request_timeout
+			};
+
+			got = net::read_few(*c->sock, space);
+		}
+
+		buf_have += got;
+	}
+}
+catch(const http2::error &e)
+{
+	log::derror
+	{
+		log, "%s HTTP/2 :%s",
+		c->loghead(),
+		e.what(),
+	};
+
+	if(!c->sock->fini) try
+	{
+		send_goaway(e.code);
+	}
+	catch(...) {}
+
+	return false;
+}
+
+size_t
+ircd::client::h2::handle_frames()
+{
+	size_t off(0);
+	while(buf_have - off >= 9)
+	{
+		const http2::frame::header header
+		{
+			const_buffer{data(buf) + off, 9}
+		};
+
+		if(unlikely(header.len > local[http2::settings::code::MAX_FRAME_SIZE]))
+			throw http2::error
+			{
+				http2::error::FRAME_SIZE_ERROR, "%s frame length %u exceeds maximum.",
+				http2::frame::reflect(header.type),
+				uint(header.len),
+			};
+
+		if(buf_have - off < size_t(9) + header.len)
+			break;
+
+		const const_buffer payload
+		{
+			data(buf) + off + 9, header.len
+		};
+
+		handle_frame(header, payload);
+		off += 9 + header.len;
+	}
+
+	std::memmove(data(buf), data(buf) + off, buf_have - off);
+	return off;
+}
+
+void
+ircd::client::h2::handle_frame(const http2::frame::header &header,
+                               const const_buffer &payload)
+{
+	using type = http2::frame::type;
+
+	// A header block is contiguous; no other frame may interleave.
+	if(unlikely(block_sid && header.type != type::CONTINUATION))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "%s frame during header block.",
+			http2::frame::reflect(header.type),
+		};
+
+	switch(header.type)
+	{
+		case type::DATA:
+			return handle_data(header, payload);
+
+		case type::HEADERS:
+			return handle_headers(header, payload);
+
+		case type::CONTINUATION:
+			return handle_continuation(header, payload);
+
+		case type::SETTINGS:
+			return handle_settings(header, payload);
+
+		case type::PING:
+			return handle_ping(header, payload);
+
+		case type::GOAWAY:
+			return handle_goaway(header, payload);
+
+		case type::WINDOW_UPDATE:
+			return handle_window_update(header, payload);
+
+		case type::RST_STREAM:
+			return handle_rst_stream(header, payload);
+
+		// Stream prioritization is advisory; streams are served by the
+		// request pool in order of arrival.
+		case type::PRIORITY:
+			if(unlikely(header.len != 5))
+				throw http2::error
+				{
+					http2::error::FRAME_SIZE_ERROR, "PRIORITY frame length %u.",
+					uint(header.len),
+				};
+
+			return;
+
+		case type::PUSH_PROMISE:
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "PUSH_PROMISE from client."
+			};
+
+		// Unknown frame types are ignored (RFC 7540 4.1).
+		default:
+			return;
+	}
+}
+
+void
+ircd::client::h2::handle_headers(const http2::frame::header &header,
+                                 const_buffer payload)
+{
+	if(unlikely(!header.stream_id || !(header.stream_id & 1)))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "HEADERS on invalid stream %u.",
+			uint(header.stream_id),
+		};
+
+	payload = h2_unpad(header, payload);
+	if(header.flags & http2::frame::PRIORITIZED)
+	{
+		if(unlikely(size(payload) < 5))
+			throw http2::error
+			{
+				http2::error::FRAME_SIZE_ERROR, "HEADERS priority truncated."
+			};
+
+		consume(payload, 5);
+	}
+
+	block.assign(data(payload), size(payload));
+	block_sid = header.stream_id;
+	block_flags = header.flags;
+	if(header.flags & http2::frame::END_HEADERS)
+		handle_headers_block();
+}
+
+void
+ircd::client::h2::handle_continuation(const http2::frame::header &header,
+                                      const const_buffer &payload)
+{
+	if(unlikely(!block_sid || header.stream_id != block_sid))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "Unexpected CONTINUATION on stream %u.",
+			uint(header.stream_id),
+		};
+
+	if(unlikely(block.size() + size(payload) > local[http2::settings::code::MAX_HEADER_LIST_SIZE]))
+		throw http2::error
+		{
+			http2::error::ENHANCE_YOUR_CALM, "Header block too large."
+		};
+
+	block.append(data(payload), size(payload));
+	if(header.flags & http2::frame::END_HEADERS)
+		handle_headers_block();
+}
+
+void
+ircd::client::h2::handle_headers_block()
+{
+	const auto sid(block_sid);
+	const auto flags(block_flags);
+	const unwind clear{[this]
+	{
+		block.clear();
+		block_sid = 0;
+		block_flags = 0;
+	}};
+
+	// Trailers on an existing stream are decoded to keep the decoder state
+	// in sync but otherwise ignored.
+	auto it(streams.find(sid));
+	if(it != end(streams))
+	{
+		auto &stream(*it->second);
+		decoder(string_view{block}, [](const string_view &, const string_view &) {});
+		if(unlikely(stream.dispatched || ~flags & http2::frame::END_STREAM))
+		{
+			send_rst(sid, http2::error::PROTOCOL_ERROR);
+			if(!stream.dispatched)
+				streams.erase(it);
+
+			return;
+		}
+
+		return dispatch(stream);
+	}
+
+	auto stream
+	{
+		std::make_unique<h2::stream>(*this, sid)
+	};
+
+	const size_t header_max
+	{
+		local[http2::settings::code::MAX_HEADER_LIST_SIZE]
+	};
+
+	decoder(string_view{block}, [&stream, &header_max]
+	(const string_view &name, const string_view &value)
+	{
+		auto &s(*stream);
+
+		// Values are transcribed into an HTTP/1.1 head below; anything
+		// which could break out of the field is malformed (RFC 7540 10.3).
+		const auto invalid{[](const char &c)
+		{
+			return c == '\r' || c == '\n' || c == '\0';
+		}};
+
+		if(std::any_of(begin(name), end(name), invalid) || std::any_of(begin(value), end(value), invalid))
+			s.malformed = true;
+		else if(name == ":method")
+			s.method = value;
+		else if(name == ":path")
+			s.path = value;
+		else if(name == ":authority")
+			s.authority = value;
+		else if(name == ":scheme")
+			return;
+		else if(startswith(name, ':') || has(name, ' '))
+			s.malformed = true;
+		else if(name == "host")
+		{
+			if(s.authority.empty())
+				s.authority = value;
+		}
+		else if(name == "content-length" || name == "connection" || name == "transfer-encoding")
+			return;
+		else
+		{
+			s.headers.append(data(name), size(name));
+			s.headers.append(": ", 2);
+			s.headers.append(data(value), size(value));
+			s.headers.append("\r\n", 2);
+		}
+
+		if(unlikely(s.headers.size() > header_max))
+			s.malformed = true;
+	});
+
+	if(unlikely(sid <= last_sid))
+		throw http2::error
+		{
+			http2::error::STREAM_CLOSED, "HEADERS on closed stream %u.",
+			uint(sid),
+		};
+
+	last_sid = sid;
+	if(unlikely(goaway))
+		return;
+
+	if(streams.size() >= local[http2::settings::code::MAX_CONCURRENT_STREAMS])
+		return send_rst(sid, http2::error::REFUSED_STREAM);
+
+	if(stream->malformed || stream->method.empty() || stream->path.empty())
+		return send_rst(sid, http2::error::PROTOCOL_ERROR);
+
+	stream->state = http2::stream::state::OPEN;
+	it = streams.emplace(sid, std::move(stream)).first;
+	if(flags & http2::frame::END_STREAM)
+		dispatch(*it->second);
+}
+
+void
+ircd::client::h2::handle_data(const http2::frame::header &header,
+                              const_buffer payload)
+{
+	if(unlikely(!header.stream_id || header.stream_id > last_sid))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "DATA on idle stream %u.",
+			uint(header.stream_id),
+		};
+
+	// Credit is returned immediately for the whole frame including padding;
+	// the content is buffered in full and bounded by content_max instead.
+	char wbuf[2][13];
+	const auto window_update{[&wbuf](const size_t &i, const uint32_t &sid, const uint32_t &inc)
+	{
+		const http2::frame::header frame
+		{
+			http2::frame::type::WINDOW_UPDATE, 0, sid, 4
+		};
+
+		frame(wbuf[i]);
+		wbuf[i][9] = uint8_t(inc >> 24) & 0x7fU;
+		wbuf[i][10] = uint8_t(inc >> 16);
+		wbuf[i][11] = uint8_t(inc >> 8);
+		wbuf[i][12] = uint8_t(inc);
+		return const_buffer{wbuf[i], 13};
+	}};
+
+	const auto it(streams.find(header.stream_id));
+	const bool closed(it == end(streams) || it->second->dispatched);
+	const bool fin(header.flags & http2::frame::END_STREAM);
+	if(header.len)
+	{
+		const const_buffer iov[]
+		{
+			window_update(0, 0, header.len),
+			window_update(1, header.stream_id, header.len),
+		};
+
+		// The stream's credit is only returned while it can receive more.
+		send(vector_view<const const_buffer>(iov, closed || fin? 1 : 2));
+	}
+
+	if(closed)
+		return send_rst(header.stream_id, http2::error::STREAM_CLOSED);
+
+	auto &stream(*it->second);
+	payload = h2_unpad(header, payload);
+	if(stream.content.size() + size(payload) > size_t(content_max))
+	{
+		send_rst(stream.id, http2::error::CANCEL);
+		streams.erase(it);
+		return;
+	}
+
+	stream.content.append(data(payload), size(payload));
+	if(fin)
+		dispatch(stream);
+}
+
+void
+ircd::client::h2::handle_settings(const http2::frame::header &header,
+                                  const const_buffer &payload)
+{
+	using code = http2::settings::code;
+
+	if(unlikely(header.stream_id))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "SETTINGS on stream %u.",
+			uint(header.stream_id),
+		};
+
+	if(header.flags & http2::frame::ACK)
+	{
+		if(unlikely(header.len))
+			throw http2::error
+			{
+				http2::error::FRAME_SIZE_ERROR, "SETTINGS ACK with payload."
+			};
+
+		// Our table size is now in effect for the peer's encoder.
+		decoder.max_size = local[code::HEADER_TABLE_SIZE];
+		return;
+	}
+
+	if(unlikely(header.len % 6))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "SETTINGS length %u.",
+			uint(header.len),
+		};
+
+	for(size_t off(0); off < size(payload); off += 6)
+	{
+		const auto *const p(reinterpret_cast<const uint8_t *>(data(payload) + off));
+		const uint16_t id(uint16_t(p[0]) << 8 | p[1]);
+		const uint32_t value(h2_be32(payload, off + 2));
+		if(!id || id >= code::_NUM_)
+			continue;
+
+		switch(id)
+		{
+			case code::ENABLE_PUSH:
+				if(unlikely(value > 1))
+					throw http2::error
+					{
+						http2::error::PROTOCOL_ERROR, "ENABLE_PUSH %u.", value
+					};
+
+				break;
+
+			case code::INITIAL_WINDOW_SIZE:
+			{
+				if(unlikely(value > 0x7fffffffU))
+					throw http2::error
+					{
+						http2::error::FLOW_CONTROL_ERROR, "INITIAL_WINDOW_SIZE %u.", value
+					};
+
+				const int64_t delta(int64_t(value) - peer[code::INITIAL_WINDOW_SIZE]);
+				for(auto &[sid, stream] : streams)
+					stream->send_window += delta;
+
+				break;
+			}
+
+			case code::MAX_FRAME_SIZE:
+				if(unlikely(value < 16_KiB || value > 16_MiB - 1))
+					throw http2::error
+					{
+						http2::error::PROTOCOL_ERROR, "MAX_FRAME_SIZE %u.", value
+					};
+
+				break;
+		}
+
+		peer[code(id)] = value;
+	}
+
+	send(http2::frame::header
+	{
+		http2::frame::type::SETTINGS, http2::frame::ACK, 0, 0
+	});
+
+	dock.notify_all();
+}
+
+void
+ircd::client::h2::handle_ping(const http2::frame::header &header,
+                              const const_buffer &payload)
+{
+	if(unlikely(header.stream_id))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "PING on stream %u.",
+			uint(header.stream_id),
+		};
+
+	if(unlikely(header.len != 8))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "PING length %u.",
+			uint(header.len),
+		};
+
+	if(header.flags & http2::frame::ACK)
+		return;
+
+	send(http2::frame::header
+	{
+		http2::frame::type::PING, http2::frame::ACK, 0, 8
+	}, payload);
+}
+
+void
+ircd::client::h2::handle_goaway(const http2::frame::header &header,
+                                const const_buffer &payload)
+{
+	if(unlikely(header.stream_id || header.len < 8))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "Invalid GOAWAY."
+		};
+
+	const auto code
+	{
+		(enum http2::error::code)(h2_be32(payload, 4))
+	};
+
+	log::debug
+	{
+		log, "%s HTTP/2 GOAWAY last:%u %s",
+		c->loghead(),
+		h2_be32(payload) & 0x7fffffffU,
+		http2::reflect(code),
+	};
+
+	goaway = true;
+}
+
+void
+ircd::client::h2::handle_window_update(const http2::frame::header &header,
+                                       const const_buffer &payload)
+{
+	if(unlikely(header.len != 4))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "WINDOW_UPDATE length %u.",
+			uint(header.len),
+		};
+
+	const uint32_t inc
+	{
+		h2_be32(payload) & 0x7fffffffU
+	};
+
+	if(!header.stream_id)
+	{
+		if(unlikely(!inc || send_window + inc > 0x7fffffff))
+			throw http2::error
+			{
+				http2::error::FLOW_CONTROL_ERROR, "Connection window increment %u.", inc
+			};
+
+		send_window += inc;
+		dock.notify_all();
+		return;
+	}
+
+	const auto it(streams.find(header.stream_id));
+	if(it == end(streams))
+		return;
+
+	auto &stream(*it->second);
+	if(unlikely(!inc || stream.send_window + inc > 0x7fffffff))
+	{
+		send_rst(stream.id, http2::error::FLOW_CONTROL_ERROR);
+		stream.reset = true;
+	}
+	else stream.send_window += inc;
+
+	dock.notify_all();
+}
+
+void
+ircd::client::h2::handle_rst_stream(const http2::frame::header &header,
+                                    const const_buffer &payload)
+{
+	if(unlikely(!header.stream_id || header.stream_id > last_sid))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "RST_STREAM on idle stream %u.",
+			uint(header.stream_id),
+		};
+
+	if(unlikely(header.len != 4))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "RST_STREAM length %u.",
+			uint(header.len),
+		};
+
+	const auto it(streams.find(header.stream_id));
+	if(it == end(streams))
+		return;
+
+	auto &stream(*it->second);
+	stream.reset = true;
+	stream.state = http2::stream::state::CLOSED;
+	dock.notify_all();
+	if(!stream.dispatched)
+	{
+		streams.erase(it);
+		return;
+	}
+
+	// Interrupting a write would cancel all operations on the socket.
+	if(stream.req && stream.req->reqctx && !stream.writing)
+		ctx::interrupt(*stream.req->reqctx);
+}
+
+/// The request is complete; transcribe it into an HTTP/1.1 head for a new
+/// client which is then dispatched to the request pool.
+void
+ircd::client::h2::dispatch(stream &stream)
+{
+	assert(!stream.dispatched);
+	stream.dispatched = true;
+	stream.state = http2::stream::state::HALF_CLOSED_REMOTE;
+
+	char lenbuf[24];
+	const string_view content_length
+	{
+		lex_cast(stream.content.size(), lenbuf)
+	};
+
+	const string_view parts[]
+	{
+		stream.method, " "_sv, stream.path, " HTTP/1.1\r\n"_sv,
+		"Host: "_sv, stream.authority, "\r\n"_sv,
+		stream.headers,
+		"Content-Length: "_sv, content_length, "\r\n\r\n"_sv,
+		stream.content,
+	};
+
+	const size_t total
+	{
+		std::accumulate(begin(parts), end(parts), size_t(0), []
+		(const size_t &ret, const string_view &part)
+		{
+			return ret + size(part);
+		})
+	};
+
+	auto req
+	{
+		std::make_shared<client>(c->sock)
+	};
+
+	req->conf = c->conf;
+	req->stream = &stream;
+	req->head_buffer = unique_buffer<mutable_buffer>{total};
+	mutable_buffer out(req->head_buffer);
+	for(const auto &part : parts)
+		consume(out, copy(out, part));
+
+	stream.req = req;
+	stream.headers = {};
+	stream.content = {};
+	client::pool(std::bind(ircd::handle_client_stream, std::move(req), shared_from(*c)));
+}
+
+void
+ircd::client::h2::send_settings()
+{
+	using code = http2::settings::code;
+
+	static const code codes[]
+	{
+		code::HEADER_TABLE_SIZE,
+		code::ENABLE_PUSH,
+		code::MAX_CONCURRENT_STREAMS,
+		code::INITIAL_WINDOW_SIZE,
+		code::MAX_FRAME_SIZE,
+		code::MAX_HEADER_LIST_SIZE,
+	};
+
+	char buf[std::size(codes) * 6];
+	for(size_t i(0); i < std::size(codes); ++i)
+	{
+		const auto &value(local[codes[i]]);
+		buf[i * 6 + 0] = 0;
+		buf[i * 6 + 1] = uint8_t(codes[i]);
+		buf[i * 6 + 2] = uint8_t(value >> 24);
+		buf[i * 6 + 3] = uint8_t(value >> 16);
+		buf[i * 6 + 4] = uint8_t(value >> 8);
+		buf[i * 6 + 5] = uint8_t(value);
+	}
+
+	send(http2::frame::header
+	{
+		http2::frame::type::SETTINGS, 0, 0, sizeof(buf)
+	}, buf);
+}
+
+void
+ircd::client::h2::send_rst(const uint32_t &sid,
+                           const enum http2::error::code &code)
+{
+	const char payload[4]
+	{
+		char(uint32_t(code) >> 24), char(uint32_t(code) >> 16),
+		char(uint32_t(code) >> 8), char(code),
+	};
+
+	send(http2::frame::header
+	{
+		http2::frame::type::RST_STREAM, 0, sid, 4
+	}, payload);
+}
+
+void
+ircd::client::h2::send_goaway(const enum http2::error::code &code)
+{
+	const char payload[8]
+	{
+		char(last_sid >> 24), char(last_sid >> 16), char(last_sid >> 8), char(last_sid),
+		char(uint32_t(code) >> 24), char(uint32_t(code) >> 16),
+		char(uint32_t(code) >> 8), char(code),
+	};
+
+	send(http2::frame::header
+	{
+		http2::frame::type::GOAWAY, 0, 0, 8
+	}, payload);
+}
+
+void
+ircd::client::h2::send(const http2::frame::header &header,
+                       const const_buffer &payload)
+{
+	char buf[9];
+	const const_buffer iov[]
+	{
+		header(buf), payload
+	};
+
+	send(vector_view<const const_buffer>(iov, empty(payload)? 1 : 2));
+}
+
+/// All writes to the socket are made here; the mutex keeps the frames of
+/// concurrent streams from interleaving within each other.
+void
+ircd::client::h2::send(const vector_view<const const_buffer> &iov)
+{
+	const std::lock_guard lock
+	{
+		write_mutex
+	};
+
+	if(unlikely(!c->sock || c->sock->fini))
+		throw std::system_error
+		{
+			make_error_code(std::errc::not_connected)
+		};
+
+	net::write_all(*c->sock, iov);
+}
+
+//
+// h2::stream
+//
+
+ircd::client::h2::stream::stream(h2 &conn,
+                                 const uint32_t &id)
+:conn
+{
+	&conn
+}
+,send_window
+{
+	conn.peer[http2::settings::code::INITIAL_WINDOW_SIZE]
+}
+{
+	this->id = id;
+}
+
+/// Called by the resource through client::write_all() with HTTP/1.1. The
+/// head is collected until complete and sent as HEADERS; everything after it
+/// is content sent as DATA.
+size_t
+ircd::client::h2::stream::write(const const_buffer &buf)
+{
+	if(unlikely(reset || conn->closed))
+		throw std::system_error
+		{
+			make_error_code(std::errc::connection_reset)
+		};
+
+	if(head_sent)
+		return send_data(buf, false);
+
+	const size_t before(response_head.size());
+	response_head.append(data(buf), size(buf));
+	const auto pos(response_head.find("\r\n\r\n"));
+	if(pos == std::string::npos)
+	{
+		if(unlikely(response_head.size() > 64_KiB))
+			throw http2::error
+			{
+				"Response head too large."
+			};
+
+		return size(buf);
+	}
+
+	const size_t head_len(pos + 4);
+	send_head(string_view(response_head.data(), head_len));
+	head_sent = true;
+	response_head = {};
+
+	assert(head_len > before);
+	const const_buffer content
+	{
+		buf + (head_len - before)
+	};
+
+	if(!empty(content))
+		send_data(content, false);
+
+	return size(buf);
+}
+
+void
+ircd::client::h2::stream::send_head(const string_view &head)
+{
+	parse::buffer pb{const_buffer{head}};
+	parse::capstan pc{pb};
+	const http::line::response line
+	{
+		http::line{pc}
+	};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		size(head) * 2 + 64
+	};
+
+	window_buffer block(buf);
+	http2::hpack::encode(block, ":status", line.status);
+	http::headers
+	{
+		pc, [&block](const http::header &header)
+		{
+			// Connection-specific fields are prohibited (RFC 7540 8.1.2.2)
+			const auto &name(header.first);
+			if(iequals(name, "connection"_sv)
+			|| iequals(name, "keep-alive"_sv)
+			|| iequals(name, "proxy-connection"_sv)
+			|| iequals(name, "transfer-encoding"_sv)
+			|| iequals(name, "upgrade"_sv))
+				return;
+
+			http2::hpack::encode(block, name, header.second);
+		}
+	};
+
+	// The block is split into HEADERS and CONTINUATION frames which must
+	// be contiguous on the connection; they are sent in one write.
+	const const_buffer completed(block.completed());
+	const size_t frame_max(conn->peer[http2::settings::code::MAX_FRAME_SIZE]);
+	const size_t frames(std::max((size(completed) + frame_max - 1) / frame_max, 1UL));
+	std::vector<std::array<char, 9>> headers(frames);
+	std::vector<const_buffer> iov;
+	iov.reserve(frames * 2);
+	for(size_t i(0); i < frames; ++i)
+	{
+		const const_buffer fragment
+		{
+			data(completed) + i * frame_max,
+			std::min(frame_max, size(completed) - i * frame_max)
+		};
+
+		const http2::frame::header header
+		{
+			i == 0?
+				http2::frame::type::HEADERS:
+				http2::frame::type::CONTINUATION,
+
+			i + 1 == frames?
+				uint8_t(http2::frame::END_HEADERS):
+				uint8_t(0),
+
+			id,
+			uint32_t(size(fragment)),
+		};
+
+		iov.emplace_back(header(mutable_buffer{headers[i].data(), 9}));
+		if(!empty(fragment))
+			iov.emplace_back(fragment);
+	}
+
+	const scope_restore writing
+	{
+		this->writing, true
+	};
+
+	conn->send(iov);
+}
+
+/// Sends content within the peer's frame size and flow control windows,
+/// yielding when either window is exhausted until it is replenished.
+size_t
+ircd::client::h2::stream::send_data(const_buffer buf,
+                                    const bool &fin)
+{
+	using code = http2::settings::code;
+
+	size_t ret(0); do
+	{
+		const auto writable{[this, &buf]
+		{
+			return reset || conn->closed || empty(buf) ||
+			(send_window > 0 && conn->send_window > 0);
+		}};
+
+		if(!conn->dock.wait_for(seconds(conn->c->conf->request_timeout), writable))
+			throw std::system_error
+			{
+				make_error_code(std::errc::timed_out)
+			};
+
+		if(unlikely(reset || conn->closed))
+			throw std::system_error
+			{
+				make_error_code(std::errc::connection_reset)
+			};
+
+		const size_t len
+		{
+			std::min
+			({
+				size(buf),
+				size_t(std::max(send_window, 0L)),
+				size_t(std::max(conn->send_window, 0L)),
+				size_t(conn->peer[code::MAX_FRAME_SIZE]),
+			})
+		};
+
+		const http2::frame::header header
+		{
+			http2::frame::type::DATA,
+			uint8_t(fin && len == size(buf)? http2::frame::END_STREAM : 0),
+			id,
+			uint32_t(len),
+		};
+
+		const scope_restore writing
+		{
+			this->writing, true
+		};
+
+		conn->send(header, const_buffer{data(buf), len});
+		send_window -= len;
+		conn->send_window -= len;
+		consume(buf, len);
+		ret += len;
+	}
+	while(!empty(buf));
+
+	return ret;
+}
+
+/// The resource has returned; the stream is ended with an empty DATA frame
+/// since the length of the content is not otherwise known here.
+void
+ircd::client::h2::stream::finish()
+{
+	if(reset || conn->closed)
+		return;
+
+	if(!head_sent)
+		return conn->send_rst(id, http2::error::INTERNAL_ERROR);
+
+	send_data(const_buffer{}, true);
+	state = http2::stream::state::CLOSED;
+}
+
+/// A stream's client is handled here on a request context, similar to
+/// handle_client_request() for HTTP/1.
+void
+ircd::handle_client_stream(std::shared_ptr<client> client,
+                           std::shared_ptr<ircd::client> conn)
+{
+	assert(client->stream);
+	assert(conn->h2c);
+	auto &stream
+	{
+		static_cast<client::h2::stream &>(*client->stream)
+	};
+
+	client->reqctx = ctx::current;
+	client->ready_count++;
+	const unwind reset{[&client, &conn, &stream]
+	{
+		auto &h2(*conn->h2c);
+		const auto id(stream.id);
+		client->reqctx = nullptr;
+		client->stream = nullptr;
+		stream.req.reset();
+		h2.streams.erase(id);
+		h2.dock.notify_all();
+		if(client::pool.avail() <= 1)
+			client::dock.notify_all();
+	}};
+
+	if(stream.reset || conn->h2c->closed)
+		return;
+
+	try
+	{
+		parse::buffer pb
+		{
+			const_buffer{client->head_buffer}
+		};
+
+		parse::capstan pc{pb};
+		client->queue_time = client->timer.at<microseconds>();
+		client->timer = ircd::timer{};
+		++client->request_count;
+		const http::request::head head{pc};
+		client->head_length = pc.parsed - data(client->head_buffer);
+		client->content_consumed = size(client->head_buffer) - client->head_length;
+		assert(client->content_consumed == head.content_length);
+
+		log::debug
+		{
+			resource::log, "%s HTTP/2 %s `%s' content-length:%zu",
+			client->loghead(),
+			head.method,
+			head.path,
+			head.content_length,
+		};
+
+		const scope_restore request
+		{
+			client->request, resource::request
+			{
+				head, string_view{}
+			}
+		};
+
+		client->resource_request(head);
+		stream.finish();
+	}
+	catch(const std::exception &e)
+	{
+		log::derror
+		{
+			client::log, "%s stream :%s",
+			client->loghead(),
+			e.what()
+		};
+
+		client::h2::reset(*client);
+	}
+}
+
+ircd::const_buffer
+ircd::h2_unpad(const http2::frame::header &header,
+               const const_buffer &payload)
+{
+	if(~header.flags & http2::frame::PADDED)
+		return payload;
+
+	if(unlikely(empty(payload) || uint8_t(payload[0]) >= size(payload)))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "Invalid padding."
+		};
+
+	return const_buffer
+	{
+		data(payload) + 1, size(payload) - 1 - uint8_t(payload[0])
+	};
+}
+
+uint32_t
+ircd::h2_be32(const const_buffer &buf,
+              const size_t &off)
+{
+	assert(size(buf) >= off + 4);
+	const auto *const p(reinterpret_cast<const uint8_t *>(data(buf) + off));
+	return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
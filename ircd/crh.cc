@@ -8,6 +8,8 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <ircd/simd.h>
+
 //
 // This file anchors the abstract ircd::crh::hash vtable and default
 // functionalities. Various implementations of crh::hash will be contained
@@ -41,3 +43,188 @@ ircd::crh::hash::finalize(const mutable_buffer &b)
 {
 	digest(b);
 }
+
+//
+// sha256::batch
+//
+
+#if defined(IRCD_SIMD) && defined(__AVX2__) && !defined(__SHA__)
+namespace ircd::crh
+{
+	static void sha256_x8(const vector_view<const mutable_buffer> &, const vector_view<const const_buffer> &, const uint32_t *const &idx, const size_t &n) noexcept;
+	extern const uint32_t sha256_h[8], sha256_k[64];
+}
+#endif
+
+/// Hash each independent input into the output at the same index. Where AVX2
+/// is available eight messages are compressed at once, each in a 32-bit lane;
+/// the messages are first grouped by length so the lanes of a group finish
+/// together. With the SHA extensions each message is hashed by OpenSSL,
+/// which uses them and is faster than the lanes.
+void
+ircd::crh::sha256::batch(const vector_view<const mutable_buffer> &out,
+                         const vector_view<const const_buffer> &in)
+{
+	assert(out.size() >= in.size());
+
+	#if defined(IRCD_SIMD) && defined(__AVX2__) && !defined(__SHA__)
+	if(in.size() > 1)
+	{
+		std::vector<uint32_t> idx(in.size());
+		std::iota(begin(idx), end(idx), 0U);
+		std::sort(begin(idx), end(idx), [&in]
+		(const auto &a, const auto &b)
+		{
+			return size(in[a]) < size(in[b]);
+		});
+
+		for(size_t i(0); i < in.size(); i += 8)
+			sha256_x8(out, in, idx.data() + i, std::min(in.size() - i, 8UL));
+
+		return;
+	}
+	#endif
+
+	for(size_t i(0); i < in.size(); ++i)
+		sha256{out[i], in[i]};
+}
+
+#if defined(IRCD_SIMD) && defined(__AVX2__) && !defined(__SHA__)
+/// FIPS 180-4 5.3.3
+decltype(ircd::crh::sha256_h)
+ircd::crh::sha256_h
+{
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+/// FIPS 180-4 4.2.2
+decltype(ircd::crh::sha256_k)
+ircd::crh::sha256_k
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/// Up to eight messages at idx are hashed in the lanes. The final one or two
+/// blocks of each message are padded in a copy; a lane which has finished
+/// compresses a block of zeroes which is masked out of its state.
+void
+ircd::crh::sha256_x8(const vector_view<const mutable_buffer> &out,
+                     const vector_view<const const_buffer> &in,
+                     const uint32_t *const &idx,
+                     const size_t &n)
+noexcept
+{
+	static const uint8_t zero[64] {0};
+	alignas(32) uint8_t tail[8][128];
+	alignas(32) uint32_t blocks[8] {0};
+	size_t full[8] {0}, max(0);
+	for(size_t j(0); j < n; ++j)
+	{
+		const auto &buf(in[idx[j]]);
+		const size_t len(size(buf)), rem(len % 64);
+		const size_t tails(rem + 9 > 64? 2 : 1);
+		const uint64_t bits(htobe64(uint64_t(len) * 8));
+		full[j] = len / 64;
+		memset(tail[j], 0x0, sizeof(tail[j]));
+		memcpy(tail[j], data(buf) + full[j] * 64, rem);
+		memcpy(tail[j] + tails * 64 - 8, &bits, 8);
+		tail[j][rem] = 0x80;
+		blocks[j] = full[j] + tails;
+		max = std::max(max, size_t(blocks[j]));
+	}
+
+	const auto ror{[](const u256x1 x, const int n)
+	{
+		return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+	}};
+
+	const u256x1 bswap
+	{
+		_mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		                 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+	};
+
+	const u256x1 count
+	{
+		_mm256_load_si256(reinterpret_cast<const u256x1 *>(blocks))
+	};
+
+	u256x1 s[8];
+	for(size_t i(0); i < 8; ++i)
+		s[i] = _mm256_set1_epi32(sha256_h[i]);
+
+	for(size_t k(0); k < max; ++k)
+	{
+		const uint8_t *blk[8];
+		for(size_t j(0); j < 8; ++j)
+			blk[j] =
+				j < n && k < full[j]?
+					reinterpret_cast<const uint8_t *>(data(in[idx[j]])) + k * 64:
+				j < n && k < blocks[j]?
+					tail[j] + (k - full[j]) * 64:
+					zero;
+
+		u256x1 w[16];
+		for(size_t t(0); t < 16; ++t)
+		{
+			uint32_t word[8];
+			for(size_t j(0); j < 8; ++j)
+				memcpy(word + j, blk[j] + t * 4, 4);
+
+			w[t] = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const u256x1_u *>(word)), bswap);
+		}
+
+		u256x1 a(s[0]), b(s[1]), c(s[2]), d(s[3]), e(s[4]), f(s[5]), g(s[6]), h(s[7]);
+		for(size_t t(0); t < 64; ++t)
+		{
+			if(t >= 16)
+			{
+				const u256x1 w15(w[(t + 1) & 15]), w2(w[(t + 14) & 15]);
+				const u256x1 s0(_mm256_xor_si256(_mm256_xor_si256(ror(w15, 7), ror(w15, 18)), _mm256_srli_epi32(w15, 3)));
+				const u256x1 s1(_mm256_xor_si256(_mm256_xor_si256(ror(w2, 17), ror(w2, 19)), _mm256_srli_epi32(w2, 10)));
+				w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t + 9) & 15], s1));
+			}
+
+			const u256x1 S1(_mm256_xor_si256(_mm256_xor_si256(ror(e, 6), ror(e, 11)), ror(e, 25)));
+			const u256x1 ch(_mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g)));
+			const u256x1 kw(_mm256_add_epi32(_mm256_set1_epi32(sha256_k[t]), w[t & 15]));
+			const u256x1 t1(_mm256_add_epi32(_mm256_add_epi32(h, S1), _mm256_add_epi32(ch, kw)));
+			const u256x1 S0(_mm256_xor_si256(_mm256_xor_si256(ror(a, 2), ror(a, 13)), ror(a, 22)));
+			const u256x1 maj(_mm256_xor_si256(_mm256_and_si256(a, _mm256_xor_si256(b, c)), _mm256_and_si256(b, c)));
+			const u256x1 t2(_mm256_add_epi32(S0, maj));
+			h = g; g = f; f = e;
+			e = _mm256_add_epi32(d, t1);
+			d = c; c = b; b = a;
+			a = _mm256_add_epi32(t1, t2);
+		}
+
+		const u256x1 active
+		{
+			_mm256_cmpgt_epi32(count, _mm256_set1_epi32(k))
+		};
+
+		const u256x1 x[8] {a, b, c, d, e, f, g, h};
+		for(size_t i(0); i < 8; ++i)
+			s[i] = _mm256_blendv_epi8(s[i], _mm256_add_epi32(s[i], x[i]), active);
+	}
+
+	alignas(32) uint32_t state[8][8];
+	for(size_t i(0); i < 8; ++i)
+		_mm256_store_si256(reinterpret_cast<u256x1 *>(state[i]), _mm256_shuffle_epi8(s[i], bswap));
+
+	for(size_t j(0); j < n; ++j)
+	{
+		assert(size(out[idx[j]]) >= sha256::digest_size);
+		for(size_t i(0); i < 8; ++i)
+			memcpy(data(out[idx[j]]) + i * 4, &state[i][j], 4);
+	}
+}
+#endif
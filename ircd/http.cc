@@ -396,6 +396,9 @@ ircd::http::assign(request::head &head,
 	else if(key == "upgrade"_sv)
 		head.upgrade = val;
 
+	else if(key == "accept-encoding"_sv)
+		head.accept_encoding = val;
+
 	else if(key == "range"_sv)
 		head.range = val;
 
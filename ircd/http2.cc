@@ -14,6 +14,628 @@ ircd::http2::connection_preface
 	"PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
 };
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// hpack.h
+//
+
+namespace ircd::http2::hpack
+{
+	struct huffman_code
+	{
+		uint32_t code;
+		uint8_t len;
+	};
+
+	struct huffman_canon
+	{
+		uint32_t first[32] {0};       // first code of each length
+		uint16_t count[32] {0};       // number of codes of each length
+		uint16_t offset[32] {0};      // index into sym[] of first code
+		uint16_t sym[257] {0};        // symbols ordered by (length, code)
+
+		huffman_canon();
+	};
+
+	extern const huffman_code huffman_table[257];
+	extern const huffman_canon huffman_canonical;
+
+	static uint64_t decode_int(const uint8_t *&, const uint8_t *const &, const uint8_t &prefix);
+	static string_view decode_str(const uint8_t *&, const uint8_t *const &, window_buffer &);
+	static void encode_int(window_buffer &, const uint8_t &first, const uint8_t &prefix, uint64_t val);
+	static void encode_str(window_buffer &, const string_view &, const bool &lower = false);
+}
+
+/// RFC 7541 Appendix A
+decltype(ircd::http2::hpack::static_table)
+ircd::http2::hpack::static_table
+{
+	{ ":authority",                  ""               },
+	{ ":method",                     "GET"            },
+	{ ":method",                     "POST"           },
+	{ ":path",                       "/"              },
+	{ ":path",                       "/index.html"    },
+	{ ":scheme",                     "http"           },
+	{ ":scheme",                     "https"          },
+	{ ":status",                     "200"            },
+	{ ":status",                     "204"            },
+	{ ":status",                     "206"            },
+	{ ":status",                     "304"            },
+	{ ":status",                     "400"            },
+	{ ":status",                     "404"            },
+	{ ":status",                     "500"            },
+	{ "accept-charset",              ""               },
+	{ "accept-encoding",             "gzip, deflate"  },
+	{ "accept-language",             ""               },
+	{ "accept-ranges",               ""               },
+	{ "accept",                      ""               },
+	{ "access-control-allow-origin", ""               },
+	{ "age",                         ""               },
+	{ "allow",                       ""               },
+	{ "authorization",               ""               },
+	{ "cache-control",               ""               },
+	{ "content-disposition",         ""               },
+	{ "content-encoding",            ""               },
+	{ "content-language",            ""               },
+	{ "content-length",              ""               },
+	{ "content-location",            ""               },
+	{ "content-range",               ""               },
+	{ "content-type",                ""               },
+	{ "cookie",                      ""               },
+	{ "date",                        ""               },
+	{ "etag",                        ""               },
+	{ "expect",                      ""               },
+	{ "expires",                     ""               },
+	{ "from",                        ""               },
+	{ "host",                        ""               },
+	{ "if-match",                    ""               },
+	{ "if-modified-since",           ""               },
+	{ "if-none-match",               ""               },
+	{ "if-range",                    ""               },
+	{ "if-unmodified-since",         ""               },
+	{ "last-modified",               ""               },
+	{ "link",                        ""               },
+	{ "location",                    ""               },
+	{ "max-forwards",                ""               },
+	{ "proxy-authenticate",          ""               },
+	{ "proxy-authorization",         ""               },
+	{ "range",                       ""               },
+	{ "referer",                     ""               },
+	{ "refresh",                     ""               },
+	{ "retry-after",                 ""               },
+	{ "server",                      ""               },
+	{ "set-cookie",                  ""               },
+	{ "strict-transport-security",   ""               },
+	{ "transfer-encoding",           ""               },
+	{ "user-agent",                  ""               },
+	{ "vary",                        ""               },
+	{ "via",                         ""               },
+	{ "www-authenticate",            ""               },
+};
+
+/// RFC 7541 Appendix B; the final entry is EOS.
+decltype(ircd::http2::hpack::huffman_table)
+ircd::http2::hpack::huffman_table
+{
+	{ 0x00001ff8, 13 }, { 0x007fffd8, 23 }, { 0x0fffffe2, 28 }, { 0x0fffffe3, 28 },
+	{ 0x0fffffe4, 28 }, { 0x0fffffe5, 28 }, { 0x0fffffe6, 28 }, { 0x0fffffe7, 28 },
+	{ 0x0fffffe8, 28 }, { 0x00ffffea, 24 }, { 0x3ffffffc, 30 }, { 0x0fffffe9, 28 },
+	{ 0x0fffffea, 28 }, { 0x3ffffffd, 30 }, { 0x0fffffeb, 28 }, { 0x0fffffec, 28 },
+	{ 0x0fffffed, 28 }, { 0x0fffffee, 28 }, { 0x0fffffef, 28 }, { 0x0ffffff0, 28 },
+	{ 0x0ffffff1, 28 }, { 0x0ffffff2, 28 }, { 0x3ffffffe, 30 }, { 0x0ffffff3, 28 },
+	{ 0x0ffffff4, 28 }, { 0x0ffffff5, 28 }, { 0x0ffffff6, 28 }, { 0x0ffffff7, 28 },
+	{ 0x0ffffff8, 28 }, { 0x0ffffff9, 28 }, { 0x0ffffffa, 28 }, { 0x0ffffffb, 28 },
+	{ 0x00000014,  6 }, { 0x000003f8, 10 }, { 0x000003f9, 10 }, { 0x00000ffa, 12 },
+	{ 0x00001ff9, 13 }, { 0x00000015,  6 }, { 0x000000f8,  8 }, { 0x000007fa, 11 },
+	{ 0x000003fa, 10 }, { 0x000003fb, 10 }, { 0x000000f9,  8 }, { 0x000007fb, 11 },
+	{ 0x000000fa,  8 }, { 0x00000016,  6 }, { 0x00000017,  6 }, { 0x00000018,  6 },
+	{ 0x00000000,  5 }, { 0x00000001,  5 }, { 0x00000002,  5 }, { 0x00000019,  6 },
+	{ 0x0000001a,  6 }, { 0x0000001b,  6 }, { 0x0000001c,  6 }, { 0x0000001d,  6 },
+	{ 0x0000001e,  6 }, { 0x0000001f,  6 }, { 0x0000005c,  7 }, { 0x000000fb,  8 },
+	{ 0x00007ffc, 15 }, { 0x00000020,  6 }, { 0x00000ffb, 12 }, { 0x000003fc, 10 },
+	{ 0x00001ffa, 13 }, { 0x00000021,  6 }, { 0x0000005d,  7 }, { 0x0000005e,  7 },
+	{ 0x0000005f,  7 }, { 0x00000060,  7 }, { 0x00000061,  7 }, { 0x00000062,  7 },
+	{ 0x00000063,  7 }, { 0x00000064,  7 }, { 0x00000065,  7 }, { 0x00000066,  7 },
+	{ 0x00000067,  7 }, { 0x00000068,  7 }, { 0x00000069,  7 }, { 0x0000006a,  7 },
+	{ 0x0000006b,  7 }, { 0x0000006c,  7 }, { 0x0000006d,  7 }, { 0x0000006e,  7 },
+	{ 0x0000006f,  7 }, { 0x00000070,  7 }, { 0x00000071,  7 }, { 0x00000072,  7 },
+	{ 0x000000fc,  8 }, { 0x00000073,  7 }, { 0x000000fd,  8 }, { 0x00001ffb, 13 },
+	{ 0x0007fff0, 19 }, { 0x00001ffc, 13 }, { 0x00003ffc, 14 }, { 0x00000022,  6 },
+	{ 0x00007ffd, 15 }, { 0x00000003,  5 }, { 0x00000023,  6 }, { 0x00000004,  5 },
+	{ 0x00000024,  6 }, { 0x00000005,  5 }, { 0x00000025,  6 }, { 0x00000026,  6 },
+	{ 0x00000027,  6 }, { 0x00000006,  5 }, { 0x00000074,  7 }, { 0x00000075,  7 },
+	{ 0x00000028,  6 }, { 0x00000029,  6 }, { 0x0000002a,  6 }, { 0x00000007,  5 },
+	{ 0x0000002b,  6 }, { 0x00000076,  7 }, { 0x0000002c,  6 }, { 0x00000008,  5 },
+	{ 0x00000009,  5 }, { 0x0000002d,  6 }, { 0x00000077,  7 }, { 0x00000078,  7 },
+	{ 0x00000079,  7 }, { 0x0000007a,  7 }, { 0x0000007b,  7 }, { 0x00007ffe, 15 },
+	{ 0x000007fc, 11 }, { 0x00003ffd, 14 }, { 0x00001ffd, 13 }, { 0x0ffffffc, 28 },
+	{ 0x000fffe6, 20 }, { 0x003fffd2, 22 }, { 0x000fffe7, 20 }, { 0x000fffe8, 20 },
+	{ 0x003fffd3, 22 }, { 0x003fffd4, 22 }, { 0x003fffd5, 22 }, { 0x007fffd9, 23 },
+	{ 0x003fffd6, 22 }, { 0x007fffda, 23 }, { 0x007fffdb, 23 }, { 0x007fffdc, 23 },
+	{ 0x007fffdd, 23 }, { 0x007fffde, 23 }, { 0x00ffffeb, 24 }, { 0x007fffdf, 23 },
+	{ 0x00ffffec, 24 }, { 0x00ffffed, 24 }, { 0x003fffd7, 22 }, { 0x007fffe0, 23 },
+	{ 0x00ffffee, 24 }, { 0x007fffe1, 23 }, { 0x007fffe2, 23 }, { 0x007fffe3, 23 },
+	{ 0x007fffe4, 23 }, { 0x001fffdc, 21 }, { 0x003fffd8, 22 }, { 0x007fffe5, 23 },
+	{ 0x003fffd9, 22 }, { 0x007fffe6, 23 }, { 0x007fffe7, 23 }, { 0x00ffffef, 24 },
+	{ 0x003fffda, 22 }, { 0x001fffdd, 21 }, { 0x000fffe9, 20 }, { 0x003fffdb, 22 },
+	{ 0x003fffdc, 22 }, { 0x007fffe8, 23 }, { 0x007fffe9, 23 }, { 0x001fffde, 21 },
+	{ 0x007fffea, 23 }, { 0x003fffdd, 22 }, { 0x003fffde, 22 }, { 0x00fffff0, 24 },
+	{ 0x001fffdf, 21 }, { 0x003fffdf, 22 }, { 0x007fffeb, 23 }, { 0x007fffec, 23 },
+	{ 0x001fffe0, 21 }, { 0x001fffe1, 21 }, { 0x003fffe0, 22 }, { 0x001fffe2, 21 },
+	{ 0x007fffed, 23 }, { 0x003fffe1, 22 }, { 0x007fffee, 23 }, { 0x007fffef, 23 },
+	{ 0x000fffea, 20 }, { 0x003fffe2, 22 }, { 0x003fffe3, 22 }, { 0x003fffe4, 22 },
+	{ 0x007ffff0, 23 }, { 0x003fffe5, 22 }, { 0x003fffe6, 22 }, { 0x007ffff1, 23 },
+	{ 0x03ffffe0, 26 }, { 0x03ffffe1, 26 }, { 0x000fffeb, 20 }, { 0x0007fff1, 19 },
+	{ 0x003fffe7, 22 }, { 0x007ffff2, 23 }, { 0x003fffe8, 22 }, { 0x01ffffec, 25 },
+	{ 0x03ffffe2, 26 }, { 0x03ffffe3, 26 }, { 0x03ffffe4, 26 }, { 0x07ffffde, 27 },
+	{ 0x07ffffdf, 27 }, { 0x03ffffe5, 26 }, { 0x00fffff1, 24 }, { 0x01ffffed, 25 },
+	{ 0x0007fff2, 19 }, { 0x001fffe3, 21 }, { 0x03ffffe6, 26 }, { 0x07ffffe0, 27 },
+	{ 0x07ffffe1, 27 }, { 0x03ffffe7, 26 }, { 0x07ffffe2, 27 }, { 0x00fffff2, 24 },
+	{ 0x001fffe4, 21 }, { 0x001fffe5, 21 }, { 0x03ffffe8, 26 }, { 0x03ffffe9, 26 },
+	{ 0x0ffffffd, 28 }, { 0x07ffffe3, 27 }, { 0x07ffffe4, 27 }, { 0x07ffffe5, 27 },
+	{ 0x000fffec, 20 }, { 0x00fffff3, 24 }, { 0x000fffed, 20 }, { 0x001fffe6, 21 },
+	{ 0x003fffe9, 22 }, { 0x001fffe7, 21 }, { 0x001fffe8, 21 }, { 0x007ffff3, 23 },
+	{ 0x003fffea, 22 }, { 0x003fffeb, 22 }, { 0x01ffffee, 25 }, { 0x01ffffef, 25 },
+	{ 0x00fffff4, 24 }, { 0x00fffff5, 24 }, { 0x03ffffea, 26 }, { 0x007ffff4, 23 },
+	{ 0x03ffffeb, 26 }, { 0x07ffffe6, 27 }, { 0x03ffffec, 26 }, { 0x03ffffed, 26 },
+	{ 0x07ffffe7, 27 }, { 0x07ffffe8, 27 }, { 0x07ffffe9, 27 }, { 0x07ffffea, 27 },
+	{ 0x07ffffeb, 27 }, { 0x0ffffffe, 28 }, { 0x07ffffec, 27 }, { 0x07ffffed, 27 },
+	{ 0x07ffffee, 27 }, { 0x07ffffef, 27 }, { 0x07fffff0, 27 }, { 0x03ffffee, 26 },
+	{ 0x3fffffff, 30 },
+};
+
+/// The HPACK Huffman code is canonical: within each length the codes are
+/// consecutive and in order of their symbol. This lets the decoder work bit
+/// by bit with three small arrays rather than a large state table.
+decltype(ircd::http2::hpack::huffman_canonical)
+ircd::http2::hpack::huffman_canonical;
+
+ircd::http2::hpack::huffman_canon::huffman_canon()
+{
+	for(size_t i(0); i < 257; ++i)
+		++count[huffman_table[i].len];
+
+	for(size_t len(1), off(0); len < 32; ++len)
+	{
+		offset[len] = off;
+		off += count[len];
+	}
+
+	uint16_t pos[32];
+	std::copy(std::begin(offset), std::end(offset), std::begin(pos));
+	for(size_t i(0); i < 257; ++i)
+	{
+		const auto &len(huffman_table[i].len);
+		if(pos[len] == offset[len])
+			first[len] = huffman_table[i].code;
+
+		sym[pos[len]++] = i;
+	}
+}
+
+size_t
+ircd::http2::hpack::huffman_size(const string_view &in)
+{
+	size_t bits(0);
+	for(const auto &c : in)
+		bits += huffman_table[uint8_t(c)].len;
+
+	return (bits + 7) / 8;
+}
+
+ircd::const_buffer
+ircd::http2::hpack::huffman_encode(const mutable_buffer &out,
+                                   const string_view &in)
+{
+	uint64_t acc(0);
+	size_t bits(0), i(0);
+	for(const auto &c : in)
+	{
+		const auto &code(huffman_table[uint8_t(c)]);
+		acc = (acc << code.len) | code.code;
+		bits += code.len;
+		for(; bits >= 8; bits -= 8)
+		{
+			if(unlikely(i >= size(out)))
+				throw error
+				{
+					"Insufficient buffer for huffman encoding."
+				};
+
+			out[i++] = uint8_t(acc >> (bits - 8));
+		}
+	}
+
+	// Pad the final octet with the most significant bits of EOS (all 1's).
+	if(bits)
+	{
+		if(unlikely(i >= size(out)))
+			throw error
+			{
+				"Insufficient buffer for huffman encoding."
+			};
+
+		out[i++] = uint8_t(acc << (8 - bits)) | uint8_t(0xffU >> bits);
+	}
+
+	return const_buffer
+	{
+		data(out), i
+	};
+}
+
+ircd::string_view
+ircd::http2::hpack::huffman_decode(const mutable_buffer &out,
+                                   const const_buffer &in)
+{
+	const auto &h(huffman_canonical);
+	uint32_t code(0), len(0);
+	size_t i(0);
+	for(const auto &c : in)
+		for(int b(7); b >= 0; --b)
+		{
+			code = (code << 1) | ((uint8_t(c) >> b) & 1U);
+			++len;
+			if(unlikely(len > 30))
+				throw error
+				{
+					error::COMPRESSION_ERROR, "Invalid huffman code."
+				};
+
+			if(!h.count[len] || code < h.first[len] || code - h.first[len] >= h.count[len])
+				continue;
+
+			const auto &sym
+			{
+				h.sym[h.offset[len] + code - h.first[len]]
+			};
+
+			if(unlikely(sym == 256))
+				throw error
+				{
+					error::COMPRESSION_ERROR, "EOS in huffman string."
+				};
+
+			if(unlikely(i >= size(out)))
+				throw error
+				{
+					error::COMPRESSION_ERROR, "Huffman string too large."
+				};
+
+			out[i++] = char(sym);
+			code = 0;
+			len = 0;
+		}
+
+	// Padding is strictly less than 8 bits and must be the EOS prefix.
+	if(unlikely(len >= 8 || code != (1U << len) - 1))
+		throw error
+		{
+			error::COMPRESSION_ERROR, "Invalid huffman padding."
+		};
+
+	return string_view
+	{
+		data(out), i
+	};
+}
+
+/// Encodes a header field as a literal without indexing. A name or a full
+/// match found in the static table is referenced rather than repeated. The
+/// dynamic table is never used for encoding, so the peer's table size never
+/// concerns us. Names are lower-cased as required by RFC 7540 8.1.2.
+void
+ircd::http2::hpack::encode(window_buffer &out,
+                           const string_view &name,
+                           const string_view &value)
+{
+	size_t name_idx(0);
+	for(size_t i(0); i < 61; ++i)
+	{
+		if(!iequals(static_table[i].first, name))
+			continue;
+
+		if(static_table[i].second == value)
+			return encode_int(out, 0x80, 7, i + 1);
+
+		if(!name_idx)
+			name_idx = i + 1;
+	}
+
+	encode_int(out, 0x00, 4, name_idx);
+	if(!name_idx)
+		encode_str(out, name, true);
+
+	encode_str(out, value);
+}
+
+//
+// decoder
+//
+
+ircd::http2::hpack::decoder::decoder(const size_t &buf_size)
+:buf
+{
+	buf_size
+}
+{
+}
+
+void
+ircd::http2::hpack::decoder::operator()(const const_buffer &block,
+                                        const closure &closure)
+{
+	const auto *p(reinterpret_cast<const uint8_t *>(data(block)));
+	const auto *const e(p + size(block));
+	while(p < e)
+	{
+		// The strings of one field are decoded into the scratch buffer.
+		window_buffer scratch(buf);
+		const uint8_t b(*p);
+
+		// 6.1 Indexed Header Field
+		if(b & 0x80)
+		{
+			const auto field
+			{
+				dynamic[decode_int(p, e, 7)]
+			};
+
+			closure(field.first, field.second);
+			continue;
+		}
+
+		// 6.3 Dynamic Table Size Update
+		if((b & 0xe0) == 0x20)
+		{
+			const auto max(decode_int(p, e, 5));
+			if(unlikely(max > max_size))
+				throw error
+				{
+					error::COMPRESSION_ERROR, "Table size update %lu exceeds %zu.",
+					max,
+					max_size,
+				};
+
+			dynamic.resize(max);
+			continue;
+		}
+
+		// 6.2.1 Literal with Incremental Indexing, otherwise 6.2.2 without
+		// indexing or 6.2.3 never indexed; the latter two are alike to us.
+		const bool indexing((b & 0xc0) == 0x40);
+		const auto idx(decode_int(p, e, indexing? 6 : 4));
+		const string_view name
+		{
+			idx?
+				dynamic[idx].first:
+				decode_str(p, e, scratch)
+		};
+
+		const string_view value
+		{
+			decode_str(p, e, scratch)
+		};
+
+		closure(name, value);
+		if(indexing)
+			dynamic.add(name, value);
+	}
+}
+
+//
+// table
+//
+
+ircd::http2::hpack::header
+ircd::http2::hpack::table::operator[](const size_t &index)
+const
+{
+	if(likely(index && index <= 61))
+		return static_table[index - 1];
+
+	if(likely(index > 61 && index - 62 < entries.size()))
+	{
+		const auto &entry(entries.at(index - 62));
+		return header
+		{
+			entry.first, entry.second
+		};
+	}
+
+	throw error
+	{
+		error::COMPRESSION_ERROR, "Invalid table index %zu.",
+		index,
+	};
+}
+
+void
+ircd::http2::hpack::table::add(const string_view &name,
+                               const string_view &value)
+{
+	// The strings are copied first; the name may reference an entry which
+	// is about to be evicted.
+	std::pair<std::string, std::string> entry
+	{
+		std::string(name), std::string(value)
+	};
+
+	const size_t cost
+	{
+		entry.first.size() + entry.second.size() + 32
+	};
+
+	while(!entries.empty() && size + cost > max)
+	{
+		const auto &back(entries.back());
+		size -= back.first.size() + back.second.size() + 32;
+		entries.pop_back();
+	}
+
+	// An entry larger than the table empties the table (RFC 7541 4.4).
+	if(cost > max)
+		return;
+
+	entries.emplace_front(std::move(entry));
+	size += cost;
+}
+
+void
+ircd::http2::hpack::table::resize(const size_t &max)
+{
+	this->max = max;
+	while(!entries.empty() && size > max)
+	{
+		const auto &back(entries.back());
+		size -= back.first.size() + back.second.size() + 32;
+		entries.pop_back();
+	}
+}
+
+//
+// util
+//
+
+/// RFC 7541 5.1
+uint64_t
+ircd::http2::hpack::decode_int(const uint8_t *&p,
+                               const uint8_t *const &e,
+                               const uint8_t &prefix)
+{
+	assert(p < e);
+	const uint8_t mask((1U << prefix) - 1);
+	uint64_t ret(*p++ & mask);
+	if(ret < mask)
+		return ret;
+
+	for(uint shift(0); shift <= 56; shift += 7)
+	{
+		if(unlikely(p >= e))
+			break;
+
+		const uint8_t b(*p++);
+		ret += uint64_t(b & 0x7fU) << shift;
+		if(!(b & 0x80))
+			return ret;
+	}
+
+	throw error
+	{
+		error::COMPRESSION_ERROR, "Truncated or oversized integer."
+	};
+}
+
+/// RFC 7541 5.2
+ircd::string_view
+ircd::http2::hpack::decode_str(const uint8_t *&p,
+                               const uint8_t *const &e,
+                               window_buffer &scratch)
+{
+	if(unlikely(p >= e))
+		throw error
+		{
+			error::COMPRESSION_ERROR, "Truncated string."
+		};
+
+	const bool huffman(*p & 0x80);
+	const auto len(decode_int(p, e, 7));
+	if(unlikely(len > size_t(e - p)))
+		throw error
+		{
+			error::COMPRESSION_ERROR, "String length %lu exceeds block.",
+			len,
+		};
+
+	const const_buffer str
+	{
+		reinterpret_cast<const char *>(p), len
+	};
+
+	p += len;
+	if(!huffman)
+		return str;
+
+	string_view ret;
+	scratch([&ret, &str](const mutable_buffer &buf)
+	{
+		ret = huffman_decode(buf, str);
+		return size(ret);
+	});
+
+	return ret;
+}
+
+void
+ircd::http2::hpack::encode_int(window_buffer &out,
+                               const uint8_t &first,
+                               const uint8_t &prefix,
+                               uint64_t val)
+{
+	out([&first, &prefix, &val](const mutable_buffer &buf)
+	{
+		if(unlikely(size(buf) < 10))
+			throw error
+			{
+				"Insufficient buffer for header block."
+			};
+
+		size_t i(0);
+		const uint8_t mask((1U << prefix) - 1);
+		if(val < mask)
+		{
+			buf[i++] = first | uint8_t(val);
+			return i;
+		}
+
+		buf[i++] = first | mask;
+		for(val -= mask; val >= 0x80; val >>= 7)
+			buf[i++] = uint8_t(val & 0x7fU) | 0x80U;
+
+		buf[i++] = uint8_t(val);
+		return i;
+	});
+}
+
+void
+ircd::http2::hpack::encode_str(window_buffer &out,
+                               const string_view &str,
+                               const bool &lower)
+{
+	thread_local char lowbuf[8_KiB];
+	const string_view s
+	{
+		lower?
+			tolower(lowbuf, str):
+			str
+	};
+
+	const size_t hsize
+	{
+		huffman_size(s)
+	};
+
+	const bool huffman
+	{
+		hsize < size(s)
+	};
+
+	encode_int(out, huffman? 0x80 : 0x00, 7, huffman? hsize : size(s));
+	out([&s, &huffman](const mutable_buffer &buf)
+	{
+		if(huffman)
+			return size(huffman_encode(buf, s));
+
+		if(unlikely(size(buf) < size(s)))
+			throw error
+			{
+				"Insufficient buffer for header block."
+			};
+
+		return copy(buf, s);
+	});
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // stream.h
@@ -91,6 +713,76 @@ static_assert
     sizeof(ircd::http2::frame::header) == 9
 );
 
+ircd::http2::frame::header::header(const const_buffer &buf)
+{
+	assert(size(buf) >= 9);
+	const auto *const p
+	{
+		reinterpret_cast<const uint8_t *>(data(buf))
+	};
+
+	len = uint32_t(p[0]) << 16 | uint32_t(p[1]) << 8 | uint32_t(p[2]);
+	type = (enum type)(p[3]);
+	flags = p[4];
+	stream_id = (uint32_t(p[5]) << 24 | uint32_t(p[6]) << 16 | uint32_t(p[7]) << 8 | uint32_t(p[8])) & 0x7fffffffU;
+}
+
+ircd::http2::frame::header::header(const enum type &type,
+                                   const uint8_t &flags,
+                                   const uint32_t &stream_id,
+                                   const uint32_t &len)
+{
+	this->len = len;
+	this->type = type;
+	this->flags = flags;
+	this->stream_id = stream_id;
+}
+
+ircd::const_buffer
+ircd::http2::frame::header::operator()(const mutable_buffer &buf)
+const
+{
+	assert(size(buf) >= 9);
+	auto *const p
+	{
+		reinterpret_cast<uint8_t *>(data(buf))
+	};
+
+	p[0] = uint8_t(len >> 16);
+	p[1] = uint8_t(len >> 8);
+	p[2] = uint8_t(len);
+	p[3] = uint8_t(type);
+	p[4] = flags;
+	p[5] = uint8_t(stream_id >> 24) & 0x7fU;
+	p[6] = uint8_t(stream_id >> 16);
+	p[7] = uint8_t(stream_id >> 8);
+	p[8] = uint8_t(stream_id);
+	return const_buffer
+	{
+		data(buf), 9
+	};
+}
+
+ircd::string_view
+ircd::http2::frame::reflect(const type &type)
+{
+	switch(type)
+	{
+		case type::DATA:                return "DATA";
+		case type::HEADERS:             return "HEADERS";
+		case type::PRIORITY:            return "PRIORITY";
+		case type::RST_STREAM:          return "RST_STREAM";
+		case type::SETTINGS:            return "SETTINGS";
+		case type::PUSH_PROMISE:        return "PUSH_PROMISE";
+		case type::PING:                return "PING";
+		case type::GOAWAY:              return "GOAWAY";
+		case type::WINDOW_UPDATE:       return "WINDOW_UPDATE";
+		case type::CONTINUATION:        return "CONTINUATION";
+	}
+
+	return "??????";
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -130,6 +130,10 @@ try
 	// This starts off the log with library information.
 	info::dump();
 
+	// The vectorized codecs are selected at compile time; make sure the one
+	// built here is right before anything is encoded with it.
+	b64::check();
+
 	// Setup the main context, which is a new stack executing the function
 	// ircd::main(). The main_context is the first ircd::ctx to be spawned
 	// and will be the last to finish.
@@ -8,6 +8,8 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <ircd/simd.h>
+
 namespace ircd { namespace json
 __attribute__((visibility("hidden")))
 {
@@ -469,6 +471,409 @@ __attribute__((visibility("default")))
 	// this stub needed for clang
 }}
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// (internal) scan
+//
+
+/// Hand-written scanner tried ahead of the grammar when iterating and
+/// validating. It accepts a strict subset of what the grammar accepts and
+/// returns null for anything else; the caller then repeats the work with the
+/// grammar, which either accepts what the scanner was too strict for or
+/// throws the proper error. String content, which is most of the bytes in
+/// practice, is classified a vector at a time by a bitmap of quote, escape
+/// and control characters.
+namespace ircd::json::scan
+{
+	static const char *special(const char *, const char *const) noexcept;
+	static const char *ascii(const char *, const char *const) noexcept;
+	static const char *ws(const char *, const char *const) noexcept;
+	static const char *string(const char *, const char *const) noexcept;
+	static const char *number(const char *, const char *const) noexcept;
+	static const char *literal(const char *, const char *const) noexcept;
+	static const char *object(const char *, const char *const, const uint) noexcept;
+	static const char *array(const char *, const char *const, const uint) noexcept;
+	static const char *value(const char *, const char *const, const uint) noexcept;
+	static const char *member(const char *, const char *const, object::member &) noexcept;
+}
+
+namespace ircd::json
+{
+	static size_t escaped_size(const string_view &) noexcept;
+	static void print_escaped(mutable_buffer &, const string_view &);
+	static void print_string(mutable_buffer &, const string_view &);
+}
+
+decltype(ircd::json::scan_enable)
+ircd::json::scan_enable
+{
+	true
+};
+
+/// Scan an object member at p, which is the opening quote of its name.
+/// Returns the end of the member's value.
+const char *
+ircd::json::scan::member(const char *p,
+                         const char *const e,
+                         object::member &ret)
+noexcept
+{
+	if(unlikely(p >= e || *p != '"'))
+		return nullptr;
+
+	const char *const name(p + 1);
+	if(!(p = string(p, e)))
+		return nullptr;
+
+	ret.first = string_view{name, p - 1};
+	p = ws(p, e);
+	if(unlikely(p >= e || *p != ':'))
+		return nullptr;
+
+	const char *const val(ws(p + 1, e));
+	if(!(p = value(val, e, 0)))
+		return nullptr;
+
+	ret.second = string_view{val, p};
+	return p;
+}
+
+/// Scan any value at p; the depth is that of the enclosing container as in
+/// the grammar, which limits recursion the same way.
+const char *
+ircd::json::scan::value(const char *const p,
+                        const char *const e,
+                        const uint depth)
+noexcept
+{
+	if(unlikely(p >= e))
+		return nullptr;
+
+	switch(*p)
+	{
+		case '"':
+			return string(p, e);
+
+		case '{':
+			return object(p, e, depth + 1);
+
+		case '[':
+			return array(p, e, depth + 1);
+
+		case 't':
+		case 'f':
+		case 'n':
+			return literal(p, e);
+
+		case '-':
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+			return number(p, e);
+
+		default:
+			return nullptr;
+	}
+}
+
+const char *
+ircd::json::scan::object(const char *p,
+                         const char *const e,
+                         const uint depth)
+noexcept
+{
+	assert(*p == '{');
+	if(unlikely(depth >= json::object::max_recursion_depth))
+		return nullptr;
+
+	p = ws(p + 1, e);
+	if(p < e && *p == '}')
+		return p + 1;
+
+	while(p < e && *p == '"')
+	{
+		if(!(p = string(p, e)))
+			return nullptr;
+
+		p = ws(p, e);
+		if(unlikely(p >= e || *p != ':'))
+			return nullptr;
+
+		if(!(p = value(ws(p + 1, e), e, depth)))
+			return nullptr;
+
+		p = ws(p, e);
+		if(likely(p < e && *p == '}'))
+			return p + 1;
+
+		if(unlikely(p >= e || *p != ','))
+			return nullptr;
+
+		p = ws(p + 1, e);
+	}
+
+	return nullptr;
+}
+
+const char *
+ircd::json::scan::array(const char *p,
+                        const char *const e,
+                        const uint depth)
+noexcept
+{
+	assert(*p == '[');
+	if(unlikely(depth >= json::array::max_recursion_depth))
+		return nullptr;
+
+	p = ws(p + 1, e);
+	if(p < e && *p == ']')
+		return p + 1;
+
+	while((p = value(p, e, depth)))
+	{
+		p = ws(p, e);
+		if(likely(p < e && *p == ']'))
+			return p + 1;
+
+		if(unlikely(p >= e || *p != ','))
+			return nullptr;
+
+		p = ws(p + 1, e);
+	}
+
+	return nullptr;
+}
+
+const char *
+ircd::json::scan::literal(const char *const p,
+                          const char *const e)
+noexcept
+{
+	const string_view s
+	{
+		p, size_t(e - p)
+	};
+
+	for(const string_view lit : {"true"_sv, "false"_sv, "null"_sv})
+		if(startswith(s, lit))
+			return p + size(lit);
+
+	return nullptr;
+}
+
+/// Only the strict JSON number form is accepted; the grammar's double_ also
+/// accepts forms like "01", "+1" and "1." which are left to it.
+const char *
+ircd::json::scan::number(const char *p,
+                         const char *const e)
+noexcept
+{
+	static const auto digit{[](const char c)
+	{
+		return c >= '0' && c <= '9';
+	}};
+
+	if(*p == '-')
+		++p;
+
+	if(unlikely(p >= e || !digit(*p)))
+		return nullptr;
+
+	if(*p++ != '0')
+		while(p < e && digit(*p))
+			++p;
+
+	if(p < e && *p == '.')
+	{
+		if(unlikely(++p >= e || !digit(*p)))
+			return nullptr;
+
+		while(p < e && digit(*p))
+			++p;
+	}
+
+	if(p < e && (*p == 'e' || *p == 'E'))
+	{
+		if(++p < e && (*p == '+' || *p == '-'))
+			++p;
+
+		if(unlikely(p >= e || !digit(*p)))
+			return nullptr;
+
+		while(p < e && digit(*p))
+			++p;
+	}
+
+	// A digit here means something like "01" which the grammar reads
+	// differently than the prefix we've matched.
+	if(unlikely(p < e && (digit(*p) || *p == '.' || *p == 'e' || *p == 'E')))
+		return nullptr;
+
+	return p;
+}
+
+/// Scan a string at p, which is the opening quote. Returns one past the
+/// closing quote.
+const char *
+ircd::json::scan::string(const char *p,
+                         const char *const e)
+noexcept
+{
+	assert(*p == '"');
+	for(++p; (p = special(p, e)) < e; )
+	{
+		if(likely(*p == '"'))
+			return p + 1;
+
+		// control character
+		if(unlikely(*p != '\\'))
+			return nullptr;
+
+		if(unlikely(++p >= e))
+			return nullptr;
+
+		switch(*p)
+		{
+			case '"':
+			case '\\':
+			case '/':
+			case 'b':
+			case 'f':
+			case 'n':
+			case 'r':
+			case 't':
+			case '0':
+				++p;
+				continue;
+
+			case 'u':
+				if(unlikely(e - p < 5 || !std::all_of(p + 1, p + 5, []
+				(const char &c)
+				{
+					return (c >= '0' && c <= '9')
+					    || (c >= 'a' && c <= 'f')
+					    || (c >= 'A' && c <= 'F');
+				})))
+					return nullptr;
+
+				p += 5;
+				continue;
+
+			default:
+				return nullptr;
+		}
+	}
+
+	return nullptr;
+}
+
+const char *
+ircd::json::scan::ws(const char *p,
+                     const char *const e)
+noexcept
+{
+	while(p < e && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+		++p;
+
+	return p;
+}
+
+/// Find the first quote, escape or control character at or after p; e if
+/// there is none.
+#if defined(IRCD_SIMD) && defined(__SSE2__)
+const char *
+ircd::json::scan::special(const char *p,
+                          const char *const e)
+noexcept
+{
+	#if defined(__AVX2__)
+	for(; p + sizeof(u256x1) <= e; p += sizeof(u256x1))
+	{
+		const u256x1 in        { _mm256_loadu_si256(reinterpret_cast<const u256x1_u *>(p)) };
+		const u256x1 quote     { _mm256_cmpeq_epi8(in, _mm256_set1_epi8('"'))              };
+		const u256x1 escape    { _mm256_cmpeq_epi8(in, _mm256_set1_epi8('\\'))             };
+		const u256x1 low       { _mm256_min_epu8(in, _mm256_set1_epi8(0x1f))                };
+		const u256x1 control   { _mm256_cmpeq_epi8(low, in)                                 };
+		const u256x1 any       { _mm256_or_si256(_mm256_or_si256(quote, escape), control)  };
+		const u32 mask         ( _mm256_movemask_epi8(any)                                  );
+		if(mask)
+			return p + __builtin_ctz(mask);
+	}
+	#endif
+
+	for(; p + sizeof(u128x1) <= e; p += sizeof(u128x1))
+	{
+		const u128x1 in        { _mm_loadu_si128(reinterpret_cast<const u128x1_u *>(p))     };
+		const u128x1 quote     { _mm_cmpeq_epi8(in, _mm_set1_epi8('"'))                     };
+		const u128x1 escape    { _mm_cmpeq_epi8(in, _mm_set1_epi8('\\'))                    };
+		const u128x1 low       { _mm_min_epu8(in, _mm_set1_epi8(0x1f))                       };
+		const u128x1 control   { _mm_cmpeq_epi8(low, in)                                     };
+		const u128x1 any       { _mm_or_si128(_mm_or_si128(quote, escape), control)         };
+		const u32 mask         ( _mm_movemask_epi8(any)                                      );
+		if(mask)
+			return p + __builtin_ctz(mask);
+	}
+
+	while(p < e && *p != '"' && *p != '\\' && uint8_t(*p) >= 0x20)
+		++p;
+
+	return p;
+}
+#else
+const char *
+ircd::json::scan::special(const char *p,
+                          const char *const e)
+noexcept
+{
+	while(p < e && *p != '"' && *p != '\\' && uint8_t(*p) >= 0x20)
+		++p;
+
+	return p;
+}
+#endif
+
+/// Find the first byte which is not ASCII at or after p; e if there is none.
+#if defined(IRCD_SIMD) && defined(__SSE2__)
+const char *
+ircd::json::scan::ascii(const char *p,
+                        const char *const e)
+noexcept
+{
+	#if defined(__AVX2__)
+	for(; p + sizeof(u256x1) <= e; p += sizeof(u256x1))
+	{
+		const u256x1 in        { _mm256_loadu_si256(reinterpret_cast<const u256x1_u *>(p)) };
+		const u32 mask         ( _mm256_movemask_epi8(in)                                   );
+		if(mask)
+			return p + __builtin_ctz(mask);
+	}
+	#endif
+
+	for(; p + sizeof(u128x1) <= e; p += sizeof(u128x1))
+	{
+		const u128x1 in        { _mm_loadu_si128(reinterpret_cast<const u128x1_u *>(p))     };
+		const u32 mask         ( _mm_movemask_epi8(in)                                       );
+		if(mask)
+			return p + __builtin_ctz(mask);
+	}
+
+	while(p < e && uint8_t(*p) < 0x80)
+		++p;
+
+	return p;
+}
+#else
+const char *
+ircd::json::scan::ascii(const char *p,
+                        const char *const e)
+noexcept
+{
+	while(p < e && uint8_t(*p) < 0x80)
+		++p;
+
+	return p;
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // json/tool.h
@@ -2655,9 +3060,31 @@ const try
 		string_view::begin(), string_view::end()
 	};
 
-	if(!string_view{*this}.empty())
-		qi::parse(ret.start, ret.stop, eps > parse_begin, ret.state);
+	if(string_view{*this}.empty())
+		return ret;
+
+	if(likely(scan_enable))
+	{
+		const char *p(scan::ws(ret.start, ret.stop));
+		if(likely(p < ret.stop && *p == '{'))
+		{
+			p = scan::ws(p + 1, ret.stop);
+			if(p < ret.stop && *p == '}')
+			{
+				ret.start = scan::ws(p + 1, ret.stop);
+				return ret;
+			}
+
+			if(likely((p = scan::member(p, ret.stop, ret.state))))
+			{
+				ret.start = scan::ws(p, ret.stop);
+				return ret;
+			}
+		}
+	}
 
+	ret.state = {};
+	qi::parse(ret.start, ret.stop, eps > parse_begin, ret.state);
 	return ret;
 }
 catch(const qi::expectation_failure<const char *> &e)
@@ -2747,6 +3174,24 @@ try
 		,"next object member or end"
 	};
 
+	if(likely(scan_enable && start < stop))
+	{
+		if(*start == '}')
+		{
+			state = {};
+			start = scan::ws(start + 1, stop);
+			return *this;
+		}
+
+		const char *p;
+		if(likely(*start == ','))
+			if(likely((p = scan::member(scan::ws(start + 1, stop), stop, state))))
+			{
+				start = scan::ws(p, stop);
+				return *this;
+			}
+	}
+
 	state.first = string_view{};
 	state.second = string_view{};
 	qi::parse(start, stop, eps > parse_next, state);
@@ -2881,6 +3326,97 @@ ircd::json::operator>(const object::member &a, const object::member &b)
 	return a.first > b.first;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// json/index.h
+//
+
+ircd::json::index::index(const json::object &object,
+                         const vector_view<entry> &buf)
+:object
+{
+	object
+}
+{
+	assert(size(object) <= std::numeric_limits<uint32_t>::max());
+
+	size_t i(0);
+	auto it(object.begin());
+	for(; it != object.end() && i < buf.size(); ++it, ++i)
+	{
+		const auto &[key, val]
+		{
+			*it
+		};
+
+		buf[i] = entry
+		{
+			name_hash(key),
+			uint32_t(key.data() - object.data()),
+			uint32_t(size(key)),
+			uint32_t(val.data() - object.data()),
+			uint32_t(size(val)),
+		};
+	}
+
+	complete = it == object.end();
+
+	// Stable so members with the same name remain in order of appearance.
+	std::stable_sort(buf.data(), buf.data() + i, []
+	(const entry &a, const entry &b)
+	{
+		return a.hash < b.hash;
+	});
+
+	entries =
+	{
+		buf.data(), i
+	};
+}
+
+/// When no key is given the name is not confirmed; the first member with the
+/// hash is found, as with json::object::find(name_hash_t).
+ircd::string_view
+ircd::json::index::find(const name_hash_t &hash,
+                        const string_view &key)
+const
+{
+	const auto *it
+	{
+		std::lower_bound(begin(entries), end(entries), hash, []
+		(const entry &a, const name_hash_t &hash)
+		{
+			return a.hash < hash;
+		})
+	};
+
+	for(; it != end(entries) && it->hash == hash; ++it)
+	{
+		const string_view name
+		{
+			object.data() + it->key_off, it->key_len
+		};
+
+		if(!key.data() || name == key)
+			return string_view
+			{
+				object.data() + it->val_off, it->val_len
+			};
+	}
+
+	if(likely(complete))
+		return {};
+
+	// The member may be among those beyond the capacity of the index.
+	auto oit(object.begin());
+	std::advance(oit, entries.size());
+	for(; oit != object.end(); ++oit)
+		if(key.data()? oit->first == key : name_hash(oit->first) == hash)
+			return oit->second;
+
+	return {};
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // json/array.h
@@ -3048,9 +3584,32 @@ const try
 		string_view::begin(), string_view::end()
 	};
 
-	if(!string_view{*this}.empty())
-		qi::parse(ret.start, ret.stop, eps > parse_begin, ret.state);
+	if(string_view{*this}.empty())
+		return ret;
+
+	if(likely(scan_enable))
+	{
+		const char *p(scan::ws(ret.start, ret.stop));
+		if(likely(p < ret.stop && *p == '['))
+		{
+			p = scan::ws(p + 1, ret.stop);
+			if(p < ret.stop && *p == ']')
+			{
+				ret.start = scan::ws(p + 1, ret.stop);
+				return ret;
+			}
+
+			const char *const val(p);
+			if(likely((p = scan::value(val, ret.stop, 0))))
+			{
+				ret.state = string_view{val, p};
+				ret.start = scan::ws(p, ret.stop);
+				return ret;
+			}
+		}
+	}
 
+	qi::parse(ret.start, ret.stop, eps > parse_begin, ret.state);
 	return ret;
 }
 catch(const qi::expectation_failure<const char *> &e)
@@ -3152,6 +3711,25 @@ try
 		,"next array element or end"
 	};
 
+	if(likely(scan_enable && start < stop))
+	{
+		if(*start == ']')
+		{
+			state = {};
+			start = scan::ws(start + 1, stop);
+			return *this;
+		}
+
+		const char *val, *p;
+		if(likely(*start == ','))
+			if(likely((p = scan::value(val = scan::ws(start + 1, stop), stop, 0))))
+			{
+				state = string_view{val, p};
+				start = scan::ws(p, stop);
+				return *this;
+			}
+	}
+
 	state = string_view{};
 	qi::parse(start, stop, eps > parse_next, state);
 	return *this;
@@ -3356,28 +3934,503 @@ ircd::json::operator==(const member &a, const string_view &b)
 // json/string.h
 //
 
+namespace ircd::json
+{
+	static uint32_t unescape_hex(const char *&, const char *const &);
+	static size_t unescape_utf8(char *const &, const uint32_t &) noexcept;
+
+	extern const std::array<string_view, 256> escape_table;
+}
+
+/// The printer's escape sequences indexed by character; empty for characters
+/// printed as themselves.
+decltype(ircd::json::escape_table)
+ircd::json::escape_table{[]
+{
+	std::array<string_view, 256> ret;
+	for(const auto &[c, seq] : printer.escapes)
+		ret[uint8_t(c)] = seq;
+
+	return ret;
+}()};
+
 ircd::const_buffer
 ircd::json::unescape(const mutable_buffer &buf,
                      const string &in)
 {
-	throw ircd::not_implemented{};
+	char *out(begin(buf));
+	const auto put{[&buf, &in, &out]
+	(const char *const &src, const size_t &len)
+	{
+		if(unlikely(size_t(end(buf) - out) < len))
+			throw print_error
+			{
+				"Insufficient buffer of %zu bytes to unescape %zu bytes.",
+				size(buf),
+				size(in),
+			};
+
+		memcpy(out, src, len);
+		out += len;
+	}};
+
+	const char *p(begin(in)), *const e(end(in));
+	while(p < e)
+	{
+		// Everything up to the next escape is copied as a run; the scanner
+		// also stops at quotes and controls which are copied as they are.
+		const char *const q(scan::special(p, e));
+		put(p, q - p);
+		if((p = q) == e)
+			break;
+
+		if(*p != '\\')
+		{
+			put(p++, 1);
+			continue;
+		}
+
+		if(unlikely(++p == e))
+			throw parse_error
+			{
+				"Incomplete escape sequence at end of string."
+			};
+
+		char c(*p++);
+		switch(c)
+		{
+			case '"':
+			case '\\':
+			case '/':                    break;
+			case 'b':    c = '\b';       break;
+			case 'f':    c = '\f';       break;
+			case 'n':    c = '\n';       break;
+			case 'r':    c = '\r';       break;
+			case 't':    c = '\t';       break;
+			case '0':    c = '\0';       break;
+			case 'u':
+			{
+				char utf8[4];
+				uint32_t cp(unescape_hex(p, e));
+				if(cp >= 0xdc00 && cp <= 0xdfff)
+					throw parse_error
+					{
+						"Unpaired UTF-16 low surrogate \\u%04X.", cp
+					};
+
+				if(cp >= 0xd800 && cp <= 0xdbff)
+				{
+					if(unlikely(e - p < 2 || p[0] != '\\' || p[1] != 'u'))
+						throw parse_error
+						{
+							"Unpaired UTF-16 high surrogate \\u%04X.", cp
+						};
+
+					p += 2;
+					const uint32_t lo(unescape_hex(p, e));
+					if(unlikely(lo < 0xdc00 || lo > 0xdfff))
+						throw parse_error
+						{
+							"Invalid UTF-16 low surrogate \\u%04X.", lo
+						};
+
+					cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+				}
+
+				put(utf8, unescape_utf8(utf8, cp));
+				continue;
+			}
+
+			default:
+				throw parse_error
+				{
+					"Invalid escape sequence '\\%c'.", c
+				};
+		}
+
+		put(&c, 1);
+	}
+
+	return const_buffer
+	{
+		begin(buf), out
+	};
 }
 
 ircd::json::string
 ircd::json::escape(const mutable_buffer &buf,
                    const string_view &in)
+{
+	mutable_buffer out{buf};
+	print_escaped(out, in);
+	return string_view
+	{
+		data(buf), data(out)
+	};
+}
+
+/// Prints the characters of the string as a quoted JSON string.
+void
+ircd::json::print_string(mutable_buffer &buf,
+                         const string_view &in)
+{
+	if(!scan_enable)
+	{
+		printer(buf, printer.string, in);
+		return;
+	}
+
+	if(unlikely(size(buf) < 2))
+		throw print_panic
+		{
+			"Failed to print string (%zu bytes in buffer)", size(buf)
+		};
+
+	*begin(buf) = '"';
+	consume(buf, 1);
+	const mutable_buffer inner
+	{
+		data(buf), size(buf) - 1
+	};
+
+	mutable_buffer out{inner};
+	print_escaped(out, in);
+	consume(buf, size(inner) - size(out));
+	*begin(buf) = '"';
+	consume(buf, 1);
+}
+
+/// Prints the characters of the string escaped for JSON. Runs without any
+/// character requiring an escape are found by the scanner and copied whole.
+void
+ircd::json::print_escaped(mutable_buffer &buf,
+                          const string_view &in)
 {
 	static const printer::rule<string_view> characters
 	{
 		*(printer.character)
 	};
 
-	mutable_buffer out{buf};
-	printer(out, characters, in);
-	return string_view
+	if(!scan_enable)
 	{
-		data(buf), data(out)
+		printer(buf, characters, in);
+		return;
+	}
+
+	const auto put{[&buf](const string_view &s)
+	{
+		if(unlikely(size(buf) < size(s)))
+			throw print_panic
+			{
+				"Failed to print string (%zu bytes in buffer)", size(buf)
+			};
+
+		consume(buf, copy(buf, s));
+	}};
+
+	const char *p(begin(in)), *const e(end(in));
+	while(p < e)
+	{
+		const char *const q(scan::special(p, e));
+		put(string_view{p, q});
+		if(q == e)
+			break;
+
+		assert(!empty(escape_table[uint8_t(*q)]));
+		put(escape_table[uint8_t(*q)]);
+		p = q + 1;
+	}
+}
+
+/// Size of the characters of the string once escaped, without printing.
+size_t
+ircd::json::escaped_size(const string_view &in)
+noexcept
+{
+	size_t ret(size(in));
+	const char *p(begin(in)), *const e(end(in));
+	while((p = scan::special(p, e)) != e)
+		ret += size(escape_table[uint8_t(*p++)]) - 1;
+
+	return ret;
+}
+
+/// Reads the four hex digits of a \u escape into a code point.
+uint32_t
+ircd::json::unescape_hex(const char *&p,
+                         const char *const &e)
+{
+	if(unlikely(e - p < 4))
+		throw parse_error
+		{
+			"Incomplete \\u escape sequence."
+		};
+
+	uint32_t ret(0);
+	for(const char *const stop(p + 4); p < stop; ++p)
+	{
+		const char c(*p);
+		ret <<= 4;
+		if(c >= '0' && c <= '9')
+			ret |= c - '0';
+		else if(c >= 'a' && c <= 'f')
+			ret |= c - 'a' + 10;
+		else if(c >= 'A' && c <= 'F')
+			ret |= c - 'A' + 10;
+		else
+			throw parse_error
+			{
+				"Invalid hex digit '%c' in \\u escape sequence.", c
+			};
+	}
+
+	return ret;
+}
+
+/// Encodes the code point as UTF-8; returns the number of bytes.
+size_t
+ircd::json::unescape_utf8(char *const &out,
+                          const uint32_t &cp)
+noexcept
+{
+	if(cp < 0x80)
+	{
+		out[0] = cp;
+		return 1;
+	}
+
+	if(cp < 0x800)
+	{
+		out[0] = 0xc0 | (cp >> 6);
+		out[1] = 0x80 | (cp & 0x3f);
+		return 2;
+	}
+
+	if(cp < 0x10000)
+	{
+		out[0] = 0xe0 | (cp >> 12);
+		out[1] = 0x80 | ((cp >> 6) & 0x3f);
+		out[2] = 0x80 | (cp & 0x3f);
+		return 3;
+	}
+
+	assert(cp <= 0x10ffff);
+	out[0] = 0xf0 | (cp >> 18);
+	out[1] = 0x80 | ((cp >> 12) & 0x3f);
+	out[2] = 0x80 | ((cp >> 6) & 0x3f);
+	out[3] = 0x80 | (cp & 0x3f);
+	return 4;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// json/canonical.h
+//
+
+namespace ircd::json
+{
+	thread_local std::array<object::member, 8192> canonical_pool;
+	thread_local size_t canonical_pool_pos;
+}
+
+/// Output gathered between calls to the sink.
+struct ircd::json::canonical::window
+{
+	const canonical::sink &sink;
+	size_t len {0};
+	char buf[1_KiB];
+
+	void flush();
+	void operator()(const string_view &);
+};
+
+decltype(ircd::json::canonical::pool_size)
+ircd::json::canonical::pool_size
+{
+	canonical_pool.size()
+};
+
+ircd::json::canonical::canonical(const string_view &value,
+                                 const sink &sink,
+                                 const filter &filter)
+{
+	const ctx::critical_assertion ca;
+	window out
+	{
+		sink
+	};
+
+	const string_view in
+	{
+		scan::ws(begin(value), end(value)), end(value)
+	};
+
+	if(filter && startswith(in, '{'))
+		object(out, in, 0, &filter);
+	else
+		canonical::value(out, in, 0);
+
+	out.flush();
+}
+
+void
+ircd::json::canonical::value(window &out,
+                             const string_view &in,
+                             const uint &depth)
+{
+	if(unlikely(empty(in)))
+		return out(empty_string);
+
+	switch(in[0])
+	{
+		case '{':
+			return object(out, in, depth, nullptr);
+
+		case '[':
+			return array(out, in, depth);
+
+		case '"':
+		case 't':
+		case 'f':
+		case 'n':
+			return out(in);
+
+		case '-':
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+			return out(strip(in, ' '));
+	}
+
+	// Characters which are not a JSON value are written as a string.
+	out("\"");
+	const char *p(begin(in)), *const e(end(in));
+	while(p < e)
+	{
+		const char *const q(scan::special(p, e));
+		out(string_view{p, q});
+		if(q == e)
+			break;
+
+		out(escape_table[uint8_t(*q)]);
+		p = q + 1;
+	}
+
+	out("\"");
+}
+
+void
+ircd::json::canonical::object(window &out,
+                              const json::object &object,
+                              const uint &depth,
+                              const filter *const &filter)
+{
+	if(unlikely(depth >= json::object::max_recursion_depth))
+		throw recursion_limit
+		{
+			"Exceeded maximum depth of %u for canonical JSON.",
+			json::object::max_recursion_depth,
+		};
+
+	// The members of this object occupy the pool after those of its parents
+	// until it has been written.
+	const size_t start(canonical_pool_pos);
+	const scope_restore pool_pos
+	{
+		canonical_pool_pos, start
 	};
+
+	size_t i(start);
+	for(const auto &member : object)
+	{
+		if(filter && !(*filter)(member.first))
+			continue;
+
+		if(unlikely(i >= canonical_pool.size() || i - start >= object::max_sorted_members))
+			throw print_error
+			{
+				"Too many members (%zu) for canonical JSON object.",
+				i - start,
+			};
+
+		canonical_pool[i++] = member;
+	}
+
+	canonical_pool_pos = i;
+	const auto b(canonical_pool.data() + start), e(canonical_pool.data() + i);
+	std::sort(b, e, []
+	(const object::member &a, const object::member &b) noexcept
+	{
+		return a.first < b.first;
+	});
+
+	out("{");
+	for(auto it(b); it != e; ++it)
+	{
+		if(it != b)
+			out(",");
+
+		out("\"");
+		out(it->first);
+		out("\":");
+		value(out, it->second, depth + 1);
+	}
+
+	out("}");
+}
+
+void
+ircd::json::canonical::array(window &out,
+                             const json::array &array,
+                             const uint &depth)
+{
+	if(unlikely(depth >= json::array::max_recursion_depth))
+		throw recursion_limit
+		{
+			"Exceeded maximum depth of %u for canonical JSON.",
+			json::array::max_recursion_depth,
+		};
+
+	out("[");
+	auto it(begin(array));
+	for(const auto b(it); it != end(array); ++it)
+	{
+		if(it != b)
+			out(",");
+
+		value(out, *it, depth + 1);
+	}
+
+	out("]");
+}
+
+//
+// canonical::window
+//
+
+void
+ircd::json::canonical::window::operator()(const string_view &s)
+{
+	if(len + size(s) > sizeof(buf))
+	{
+		flush();
+
+		// Large strings go to the sink directly rather than through here.
+		if(size(s) >= sizeof(buf))
+			return sink(s);
+	}
+
+	memcpy(buf + len, data(s), size(s));
+	len += size(s);
+}
+
+void
+ircd::json::canonical::window::flush()
+{
+	if(!len)
+		return;
+
+	sink(const_buffer{buf, len});
+	len = 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -3459,7 +4512,7 @@ ircd::json::stringify(mutable_buffer &buf,
 				break;
 			}
 
-			printer(buf, printer.string, sv);
+			print_string(buf, sv);
 			break;
 		}
 
@@ -3599,8 +4652,11 @@ ircd::json::serialized(const value &v)
 			if(v.serial)
 				return v.len;
 
-			thread_local char test_buffer[value::max_string_size];
 			const string_view sv{v.string, v.len};
+			if(likely(scan_enable))
+				return 1 + escaped_size(sv) + 1;
+
+			thread_local char test_buffer[value::max_string_size];
 			mutable_buffer buf{test_buffer};
 			printer(buf, printer.string, sv);
 			return begin(buf) - test_buffer;
@@ -4148,6 +5204,9 @@ noexcept try
 	};
 
 	const char *start(begin(s)), *const stop(end(s));
+	if(likely(scan_enable && scan::value(start, stop, 0) == stop))
+		return true;
+
 	return qi::parse(start, stop, validator);
 }
 catch(...)
@@ -4165,6 +5224,9 @@ try
 	};
 
 	const char *start(begin(s)), *const stop(end(s));
+	if(likely(scan_enable && scan::value(start, stop, 0) == stop))
+		return;
+
 	qi::parse(start, stop, validator);
 }
 catch(const qi::expectation_failure<const char *> &e)
@@ -4175,6 +5237,49 @@ catch(const qi::expectation_failure<const char *> &e)
 	};
 }
 
+/// Runs of ASCII are skipped a vector at a time; each multi-byte sequence is
+/// checked for its length, continuation bytes, overlong forms, surrogates and
+/// the upper bound of Unicode.
+bool
+ircd::json::valid_utf8(const string_view &s)
+noexcept
+{
+	const char *p(begin(s)), *const e(end(s));
+	while((p = scan::ascii(p, e)) != e)
+	{
+		const uint8_t c(*p);
+		const size_t len
+		{
+			c >= 0xc2 && c <= 0xdf?  2U:
+			(c & 0xf0) == 0xe0?      3U:
+			c >= 0xf0 && c <= 0xf4?  4U:
+			                         0U
+		};
+
+		if(unlikely(!len || size_t(e - p) < len))
+			return false;
+
+		uint32_t cp(c & (0x7f >> len));
+		for(size_t i(1); i < len; ++i)
+		{
+			if(unlikely((uint8_t(p[i]) & 0xc0) != 0x80))
+				return false;
+
+			cp = (cp << 6) | (uint8_t(p[i]) & 0x3f);
+		}
+
+		if(len == 3 && unlikely(cp < 0x800 || (cp >= 0xd800 && cp <= 0xdfff)))
+			return false;
+
+		if(len == 4 && unlikely(cp < 0x10000 || cp > 0x10ffff))
+			return false;
+
+		p += len;
+	}
+
+	return true;
+}
+
 void
 ircd::json::valid_output(const string_view &sv,
                          const size_t &expected)
@@ -8,15 +8,41 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include "net_iou.h"
+
 namespace ircd::net
 {
 	ctx::dock dock;
 	std::optional<dns::init> _dns_;
 
+	static int ssl_socket_idx {-1};              // SSL ex_data: net::socket *
+	static int ssl_acceptor_idx {-1};            // SSL_CTX ex_data: net::acceptor *
+
 	static void init_ipv6();
 	static void wait_close_sockets();
 }
 
+/// Worker threads executing the steps of offloaded TLS handshakes.
+namespace ircd::net::handshake_pool
+{
+	using function = std::function<void ()>;
+
+	static std::mutex mutex;
+	static std::condition_variable cond;
+	static std::deque<function> queue;
+	static std::vector<std::thread> threads;
+	static bool termination;
+
+	static void push(function &&);
+	static void worker() noexcept;
+	static void fini() noexcept;
+}
+
+static int
+ircd_net_socket_handle_session(SSL *const s,
+                               SSL_SESSION *const sess)
+noexcept;
+
 void
 ircd::net::wait_close_sockets()
 {
@@ -71,6 +97,14 @@ ircd::net::init::init()
 	init_ipv6();
 	sslv23_client.set_verify_mode(asio::ssl::verify_peer);
 	sslv23_client.set_default_verify_paths();
+
+	ssl_socket_idx = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+	ssl_acceptor_idx = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+
+	// Sessions are cached externally by the owner of the open_opts; the
+	// internal store would have no key to find them by.
+	SSL_CTX_set_session_cache_mode(sslv23_client.native_handle(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(sslv23_client.native_handle(), ircd_net_socket_handle_session);
 	_dns_.emplace();
 }
 
@@ -80,6 +114,7 @@ noexcept
 {
 	_dns_.reset();
 	wait_close_sockets();
+	handshake_pool::fini();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -143,6 +178,21 @@ ircd::net::peer_cert_der_sha256(const mutable_buffer &buf,
 	};
 }
 
+/// The protocol selected with ALPN during the handshake, or empty if none.
+ircd::string_view
+ircd::net::alpn(const socket &socket)
+noexcept
+{
+	const SSL &ssl(socket);
+	const unsigned char *proto {nullptr};
+	unsigned int len {0};
+	SSL_get0_alpn_selected(&ssl, &proto, &len);
+	return string_view
+	{
+		reinterpret_cast<const char *>(proto), len
+	};
+}
+
 ircd::const_buffer
 ircd::net::peer_cert_der(const mutable_buffer &buf,
                          const socket &socket)
@@ -233,7 +283,7 @@ noexcept
 {
 	const ip::tcp::socket &sd(socket);
 	boost::system::error_code ec;
-	return sd.available(ec);
+	return sd.available(ec) + (socket.iou? socket.iou->pending() : 0UL);
 }
 
 size_t
@@ -242,7 +292,7 @@ ircd::net::readable(const socket &socket)
 	ip::tcp::socket &sd(const_cast<net::socket &>(socket));
 	ip::tcp::socket::bytes_readable command{true};
 	sd.io_control(command);
-	return command.get();
+	return command.get() + (socket.iou? socket.iou->pending() : 0UL);
 }
 
 bool
@@ -1234,6 +1284,142 @@ ircd::net::acceptor::ssl_cipher_blacklist
 	{ "default",  string_view{ircd::net::ssl_cipher_blacklist} },
 };
 
+decltype(ircd::net::acceptor::alpn_h2)
+ircd::net::acceptor::alpn_h2
+{
+	{ "name",     "ircd.net.acceptor.alpn.h2" },
+	{ "default",  false                       },
+	{ "help",
+
+	"Select HTTP/2 when offered by the client during the TLS handshake. Only"
+	" applies to connections accepted after this is changed."
+
+	},
+};
+
+decltype(ircd::net::acceptor::ssl_session_tickets)
+ircd::net::acceptor::ssl_session_tickets
+{
+	{ "name",     "ircd.net.acceptor.ssl.session.tickets" },
+	{ "default",  true                                    },
+	{ "help",
+
+	"Issue stateless session tickets (RFC 5077) so clients can resume without"
+	" a full handshake. Overridden by ssl_session_tickets in the listener."
+
+	},
+};
+
+decltype(ircd::net::acceptor::ssl_session_ticket_rotate)
+ircd::net::acceptor::ssl_session_ticket_rotate
+{
+	{ "name",     "ircd.net.acceptor.ssl.session.ticket_rotate" },
+	{ "default",  3600L                                         },
+	{ "help",
+
+	"Seconds a ticket key is used to issue new tickets. The previous key is"
+	" still accepted for one more period. Overridden by"
+	" ssl_session_ticket_rotate in the listener."
+
+	},
+};
+
+decltype(ircd::net::acceptor::ssl_session_cache_size)
+ircd::net::acceptor::ssl_session_cache_size
+{
+	{ "name",     "ircd.net.acceptor.ssl.session.cache_size" },
+	{ "default",  long(16_KiB)                               },
+	{ "help",
+
+	"Number of sessions kept in the server-side session cache; zero disables"
+	" it. Overridden by ssl_session_cache_size in the listener."
+
+	},
+};
+
+decltype(ircd::net::acceptor::ssl_session_timeout)
+ircd::net::acceptor::ssl_session_timeout
+{
+	{ "name",     "ircd.net.acceptor.ssl.session.timeout" },
+	{ "default",  7200L                                   },
+	{ "help",
+
+	"Seconds a session can be resumed after it was established. Overridden by"
+	" ssl_session_timeout in the listener."
+
+	},
+};
+
+decltype(ircd::net::acceptor::handshakes_full)
+ircd::net::acceptor::handshakes_full
+{
+	{ "name", "ircd.net.acceptor.handshake.full"                        },
+	{ "desc", "Number of incoming TLS handshakes without resumption"    },
+};
+
+decltype(ircd::net::acceptor::handshakes_resumed)
+ircd::net::acceptor::handshakes_resumed
+{
+	{ "name", "ircd.net.acceptor.handshake.resumed"                     },
+	{ "desc", "Number of incoming TLS handshakes resuming a session"    },
+};
+
+decltype(ircd::net::acceptor::handshake_offload_threads)
+ircd::net::acceptor::handshake_offload_threads
+{
+	{ "name",     "ircd.net.acceptor.handshake.offload.threads" },
+	{ "default",  2L                                            },
+	{ "help",
+
+	"Maximum number of threads executing TLS handshakes off the main thread."
+	" Zero keeps all handshakes on the main thread. Threads are created on"
+	" demand and lowering this does not stop threads already running."
+
+	},
+};
+
+decltype(ircd::net::acceptor::handshake_offload_min)
+ircd::net::acceptor::handshake_offload_min
+{
+	{ "name",     "ircd.net.acceptor.handshake.offload.min" },
+	{ "default",  32L                                       },
+	{ "help",
+
+	"Number of concurrent handshakes on a listener beyond which new handshakes"
+	" are offloaded. Below this the handshake stays on the main thread where"
+	" it avoids the cross-thread latency."
+
+	},
+};
+
+decltype(ircd::net::acceptor::handshake_offload_steps)
+ircd::net::acceptor::handshake_offload_steps
+{
+	{ "name", "ircd.net.acceptor.handshake.offload.steps"                    },
+	{ "desc", "Number of handshake steps executed on the offload threads"    },
+};
+
+decltype(ircd::net::acceptor::handshake_offload_queued)
+ircd::net::acceptor::handshake_offload_queued
+{
+	{ "name", "ircd.net.acceptor.handshake.offload.queued"                   },
+	{ "desc", "Number of handshake steps waiting for an offload thread"      },
+};
+
+decltype(ircd::net::acceptor::handshake_offload_queue_time)
+ircd::net::acceptor::handshake_offload_queue_time
+{
+	{ "name", "ircd.net.acceptor.handshake.offload.queue_time"               },
+	{ "desc", "Total nanoseconds handshake steps waited for an offload thread" },
+};
+
+decltype(ircd::net::acceptor::handshake_offload_queue_max)
+ircd::net::acceptor::handshake_offload_queue_max
+{
+	{ "name", "ircd.net.acceptor.handshake.offload.queue_max"                },
+	{ "desc", "Longest nanoseconds a handshake step waited for an offload thread" },
+};
+
 bool
 ircd::net::stop(acceptor &a)
 {
@@ -1641,6 +1827,22 @@ noexcept try
 	};
 
 	sock->set_timeout(milliseconds(timeout));
+
+	// The handshake callbacks may run on the offload pool where they can't
+	// read the conf; what they need is taken here on the main thread.
+	h2.store(bool(alpn_h2), std::memory_order_relaxed);
+
+	// During a storm the asymmetric crypto of each handshake would stall the
+	// main thread; past the threshold the handshake is driven from the pool.
+	const bool offload
+	{
+		size_t(handshake_offload_threads) > 0 &&
+		handshaking.size() > size_t(handshake_offload_min)
+	};
+
+	if(offload)
+		return handshake_offload(sock, it);
+
 	sock->ssl.async_handshake(handshake_type, ios::handle(desc, std::move(handshake)));
 }
 catch(const ctx::interrupted &e)
@@ -1799,10 +2001,12 @@ noexcept try
 	handshaking.erase(it);
 	check_handshake_error(ec, *sock);
 	sock->cancel_timeout();
+	++(SSL_session_reused(sock->ssl.native_handle())? handshakes_resumed : handshakes_full);
 	assert(bool(cb));
 
 	// Toggles the behavior of non-async functions; see func comment
 	blocking(*sock, false);
+	sock->iou = iou::attach(*sock);
 	cb(*listener_, sock);
 }
 catch(const ctx::interrupted &e)
@@ -1853,6 +2057,171 @@ catch(const std::exception &e)
 /// whether or not the handler should return or continue processing the
 /// result.
 ///
+/// Drives the server handshake with each SSL_do_handshake() executed on the
+/// handshake pool. For the duration the SSL is given a socket BIO on the
+/// non-blocking descriptor so a step reads and writes the kernel buffers
+/// directly; readiness is awaited on the main thread between steps. asio's
+/// BIO pair is restored before handshake() is called as usual.
+void
+ircd::net::acceptor::handshake_offload(std::shared_ptr<socket> sock,
+                                       const decltype(handshaking)::const_iterator it)
+{
+	auto *const ssl
+	{
+		sock->ssl.native_handle()
+	};
+
+	BIO *const bio
+	{
+		SSL_get_rbio(ssl)
+	};
+
+	assert(bio == SSL_get_wbio(ssl));
+	BIO *const sbio
+	{
+		BIO_new_socket(sock->sd.native_handle(), BIO_NOCLOSE)
+	};
+
+	if(unlikely(!sbio))
+		throw error
+		{
+			"Failed to allocate socket BIO for handshake."
+		};
+
+	// SSL_set_bio() releases the reference held by the SSL; the one taken
+	// here is given back to the SSL when the handshake is finished.
+	BIO_up_ref(bio);
+	SSL_set_bio(ssl, sbio, sbio);
+	SSL_set_accept_state(ssl);
+	sock->sd.native_non_blocking(true);
+	handshake_step(std::move(sock), it, bio);
+}
+
+void
+ircd::net::acceptor::handshake_step(std::shared_ptr<socket> sock,
+                                    const decltype(handshaking)::const_iterator it,
+                                    BIO *const bio)
+{
+	++handshake_offload_queued;
+	const auto queued
+	{
+		now<steady_point>()
+	};
+
+	handshake_pool::push([this, sock(std::move(sock)), it, bio, queued]
+	() mutable
+	{
+		const auto started
+		{
+			now<steady_point>()
+		};
+
+		// The error queue is thread-local; it's converted to an error_code
+		// here and must be left empty for the next step on this thread.
+		auto *const ssl(sock->ssl.native_handle());
+		ERR_clear_error();
+		const int ret(SSL_do_handshake(ssl));
+		const int err(ret == 1? SSL_ERROR_NONE : SSL_get_error(ssl, ret));
+		const int sys(errno);
+		error_code ec; switch(err)
+		{
+			case SSL_ERROR_NONE:
+				break;
+
+			case SSL_ERROR_WANT_READ:
+				ec = asio::error::would_block;
+				break;
+
+			case SSL_ERROR_WANT_WRITE:
+				ec = asio::error::try_again;
+				break;
+
+			case SSL_ERROR_SSL:
+				ec = error_code(ERR_get_error(), asio::error::get_ssl_category());
+				break;
+
+			case SSL_ERROR_SYSCALL:
+				if(sys)
+				{
+					ec = error_code(sys, boost::system::system_category());
+					break;
+				}
+				[[fallthrough]];
+
+			default:
+				ec = asio::error::eof;
+				break;
+		}
+
+		ERR_clear_error();
+
+		// The socket is moved into the closure; its last reference must
+		// never be released on this thread. This is a plain post: an
+		// ios::descriptor's stats and allocator belong to the main thread.
+		boost::asio::post(ios::get(), [this, sock(std::move(sock)), it, bio, ec, queued(started - queued)]
+		() mutable
+		{
+			handshake_stepped(std::move(sock), it, bio, ec, queued);
+		});
+	});
+}
+
+void
+ircd::net::acceptor::handshake_stepped(std::shared_ptr<socket> sock,
+                                       const decltype(handshaking)::const_iterator it,
+                                       BIO *const bio,
+                                       const error_code &ec,
+                                       const nanoseconds &queued)
+noexcept
+{
+	static ios::descriptor desc
+	{
+		"ircd::net::acceptor handshake_wait"
+	};
+
+	--handshake_offload_queued;
+	++handshake_offload_steps;
+	handshake_offload_queue_time += queued.count();
+	if(queued.count() > stats::get(handshake_offload_queue_max))
+		handshake_offload_queue_max = queued.count();
+
+	const bool want_read(ec == asio::error::would_block);
+	const bool want_write(ec == asio::error::try_again);
+	const bool canceled(interrupting || sock->timedout);
+	if((want_read || want_write) && !canceled)
+	{
+		const auto type
+		{
+			want_read?
+				ip::tcp::socket::wait_read:
+				ip::tcp::socket::wait_write
+		};
+
+		auto &sd(sock->sd);
+		sd.async_wait(type, ios::handle(desc, [this, sock(std::move(sock)), it, bio]
+		(const error_code &ec)
+		{
+			if(likely(!ec))
+				return handshake_step(sock, it, bio);
+
+			SSL_set_bio(sock->ssl.native_handle(), bio, bio);
+			handshake(ec, sock, it);
+		}));
+
+		return;
+	}
+
+	SSL_set_bio(sock->ssl.native_handle(), bio, bio);
+	const error_code &ret
+	{
+		canceled?
+			make_error_code(boost::system::errc::operation_canceled):
+			ec
+	};
+
+	handshake(ret, std::move(sock), it);
+}
+
 void
 ircd::net::acceptor::check_handshake_error(const error_code &ec,
                                            socket &sock)
@@ -1882,6 +2251,9 @@ const
 	__builtin_unreachable();
 }
 
+/// The handshake callbacks may be called on a handshake_pool thread; they
+/// only log on the main thread and take their configuration from members
+/// set when the socket was accepted.
 ircd::string_view
 ircd::net::acceptor::handle_alpn(SSL &ssl,
                                  const vector_view<const string_view> &in)
@@ -1889,15 +2261,16 @@ ircd::net::acceptor::handle_alpn(SSL &ssl,
 	if(empty(in))
 		return {};
 
-	log::debug
-	{
-		log, "%s offered %zu ALPN protocols",
-		loghead(*this),
-		size(in),
-	};
+	if(is_main_thread())
+		log::debug
+		{
+			log, "%s offered %zu ALPN protocols",
+			loghead(*this),
+			size(in),
+		};
 
 	#ifdef IRCD_NET_ACCEPTOR_DEBUG_ALPN
-	for(size_t i(0); i < size(in); ++i)
+	for(size_t i(0); i < size(in) && is_main_thread(); ++i)
 	{
 		log::debug
 		{
@@ -1910,7 +2283,22 @@ ircd::net::acceptor::handle_alpn(SSL &ssl,
 	}
 	#endif IRCD_NET_ACCEPTOR_DEBUG_ALPN
 
-	return {};
+	// The selection must point into the offer; the client's preference
+	// order is not considered, only whether h2 was offered at all.
+	const auto it
+	{
+		std::find(begin(in), end(in), "h2"_sv)
+	};
+
+	if(h2.load(std::memory_order_relaxed) && it != end(in))
+		return *it;
+
+	const auto http11
+	{
+		std::find(begin(in), end(in), "http/1.1"_sv)
+	};
+
+	return http11 != end(in)? *http11 : string_view{};
 }
 
 static int
@@ -1937,7 +2325,7 @@ noexcept try
 	while(i < inlen && p < PROTOS_MAX)
 	{
 		const uint8_t &len(in[i++]);
-		if(unlikely(!len || i + len >= inlen))
+		if(unlikely(!len || i + len > inlen))
 			break;
 
 		protos[p++] = ircd::string_view
@@ -2006,44 +2394,48 @@ try
 
 	if(!accepts)
 	{
-		log::dwarning
-		{
-			log, "%s unrecognized SNI '%s' offered.",
-			loghead(*this),
-			name,
-		};
+		if(is_main_thread())
+			log::dwarning
+			{
+				log, "%s unrecognized SNI '%s' offered.",
+				loghead(*this),
+				name,
+			};
 
 		return false;
 	}
 
-	log::debug
-	{
-		log, "%s offered SNI '%s'",
-		loghead(*this),
-		name
-	};
+	if(is_main_thread())
+		log::debug
+		{
+			log, "%s offered SNI '%s'",
+			loghead(*this),
+			name
+		};
 
 	return true;
 }
 catch(const sni_warning &e)
 {
-	log::warning
-	{
-		log, "%s during SNI :%s",
-		loghead(*this),
-		e.what()
-	};
+	if(is_main_thread())
+		log::warning
+		{
+			log, "%s during SNI :%s",
+			loghead(*this),
+			e.what()
+		};
 
 	throw;
 }
 catch(const std::exception &e)
 {
-	log::error
-	{
-		log, "%s during SNI :%s",
-		loghead(*this),
-		e.what()
-	};
+	if(is_main_thread())
+		log::error
+		{
+			log, "%s during SNI :%s",
+			loghead(*this),
+			e.what()
+		};
 
 	throw;
 }
@@ -2089,68 +2481,297 @@ catch(...)
 	__builtin_unreachable();
 }
 
-void
-ircd::net::acceptor::configure(const json::object &opts)
+/// The key is copied out under the lock because another handshake may
+/// rotate the keys as soon as it's released. Returns 1 for the current key,
+/// 2 for the previous key and 0 when there's no key for the name.
+int
+ircd::net::acceptor::handle_ticket_key(ticket_key &out,
+                                       SSL &ssl,
+                                       const const_buffer &name)
 {
-	log::debug
+	const std::lock_guard lock
 	{
-		log, "%s preparing listener socket configuration...",
-		loghead(*this)
+		ticket_keys_mutex
 	};
 
-	configure_password(opts);
-	configure_flags(opts);
-	configure_ciphers(opts);
-	configure_curves(opts);
-	configure_certs(opts);
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
 
-	SSL_CTX_set_alpn_select_cb(ssl.native_handle(), ircd_net_acceptor_handle_alpn, this);
-	SSL_CTX_set_tlsext_servername_callback(ssl.native_handle(), ircd_net_acceptor_handle_sni);
-	SSL_CTX_set_tlsext_servername_arg(ssl.native_handle(), this);
-}
+	// An empty name requests the key for issuing a new ticket. The key is
+	// rotated lazily here; the previous key remains for decryption only.
+	if(empty(name))
+	{
+		if(ticket_keys.empty() || now - ticket_keys.front().created >= ticket_rotate)
+		{
+			ticket_key key;
+			key.created = now;
+			if(unlikely(RAND_bytes(key.name.data(), key.name.size()) != 1))
+				throw error
+				{
+					"Failed to generate session ticket key."
+				};
 
-void
-ircd::net::acceptor::configure_flags(const json::object &opts)
-{
-	ulong flags(0);
+			if(unlikely(RAND_bytes(key.aes.data(), key.aes.size()) != 1))
+				throw error
+				{
+					"Failed to generate session ticket key."
+				};
 
-	if(opts.get<bool>("ssl_default_workarounds", false))
-		flags |= ssl.default_workarounds;
+			if(unlikely(RAND_bytes(key.hmac.data(), key.hmac.size()) != 1))
+				throw error
+				{
+					"Failed to generate session ticket key."
+				};
 
-	if(opts.get<bool>("ssl_single_dh_use", false))
-		flags |= ssl.single_dh_use;
+			ticket_keys.emplace_front(key);
+			while(ticket_keys.size() > 2)
+				ticket_keys.pop_back();
 
-	if(opts.get<bool>("ssl_no_sslv2", false))
-		flags |= ssl.no_sslv2;
+			if(is_main_thread())
+				log::debug
+				{
+					log, "%s rotated session ticket key (%zu held)",
+					loghead(*this),
+					ticket_keys.size(),
+				};
+		}
 
-	if(opts.get<bool>("ssl_no_sslv3", false))
-		flags |= ssl.no_sslv3;
+		out = ticket_keys.front();
+		return 1;
+	}
 
-	if(opts.get<bool>("ssl_no_tlsv1", false))
-		flags |= ssl.no_tlsv1;
+	if(unlikely(size(name) != sizeof(ticket_key::name)))
+		return 0;
 
-	if(opts.get<bool>("ssl_no_tlsv1_1", false))
-		flags |= ssl.no_tlsv1_1;
+	for(auto it(begin(ticket_keys)); it != end(ticket_keys); ++it)
+	{
+		if(!std::equal(begin(it->name), end(it->name), reinterpret_cast<const uint8_t *>(data(name))))
+			continue;
 
-	if(opts.get<bool>("ssl_no_tlsv1_2", false))
-		flags |= ssl.no_tlsv1_2;
+		if(now - it->created >= ticket_rotate * 2)
+			return 0;
 
-	ssl.set_options(flags);
+		out = *it;
+		return it == begin(ticket_keys)? 1 : 2;
+	}
+
+	return 0;
 }
 
-void
-ircd::net::acceptor::configure_ciphers(const json::object &opts)
+/// Returns 1 when the ticket was handled with a current key, 2 when it was
+/// decrypted with the previous key and should be renewed, 0 when the ticket
+/// is unknown (a full handshake follows) and -1 on error.
+static int
+ircd_net_acceptor_handle_ticket(SSL *const s,
+                                unsigned char *const key_name,
+                                unsigned char *const iv,
+                                EVP_CIPHER_CTX *const ctx,
+                                #if OPENSSL_VERSION_NUMBER >= 0x30000000L
+                                EVP_MAC_CTX *const hctx,
+                                #else
+                                HMAC_CTX *const hctx,
+                                #endif
+                                const int enc)
+noexcept try
 {
-	if(!empty(unquote(opts["ssl_cipher_list"])))
+	auto *const acceptor
 	{
-		const json::string &list
-		{
-			opts["ssl_cipher_list"]
-		};
+		static_cast<ircd::net::acceptor *>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(s), ircd::net::ssl_acceptor_idx))
+	};
 
-		assert(ssl.native_handle());
-		openssl::set_cipher_list(*ssl.native_handle(), list);
-	}
+	if(unlikely(!acceptor))
+		return -1;
+
+	const ircd::const_buffer name
+	{
+		enc?
+			ircd::const_buffer{}:
+			ircd::const_buffer{reinterpret_cast<const char *>(key_name), 16}
+	};
+
+	ircd::net::acceptor::ticket_key key;
+	const int found
+	{
+		acceptor->handle_ticket_key(key, *s, name)
+	};
+
+	if(!found)
+		return 0;
+
+	const auto cipher
+	{
+		EVP_aes_256_cbc()
+	};
+
+	if(enc)
+	{
+		std::copy(begin(key.name), end(key.name), key_name);
+		if(unlikely(RAND_bytes(iv, EVP_CIPHER_iv_length(cipher)) != 1))
+			return -1;
+	}
+
+	#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	char digest[] {"SHA256"};
+	const OSSL_PARAM params[]
+	{
+		OSSL_PARAM_construct_octet_string("key", const_cast<uint8_t *>(key.hmac.data()), key.hmac.size()),
+		OSSL_PARAM_construct_utf8_string("digest", digest, 0),
+		OSSL_PARAM_construct_end(),
+	};
+
+	if(unlikely(!EVP_MAC_CTX_set_params(hctx, params)))
+		return -1;
+	#else
+	if(unlikely(!HMAC_Init_ex(hctx, key.hmac.data(), key.hmac.size(), EVP_sha256(), nullptr)))
+		return -1;
+	#endif
+
+	const int ok
+	{
+		enc?
+			EVP_EncryptInit_ex(ctx, cipher, nullptr, key.aes.data(), iv):
+			EVP_DecryptInit_ex(ctx, cipher, nullptr, key.aes.data(), iv)
+	};
+
+	if(unlikely(!ok))
+		return -1;
+
+	return enc? 1 : found;
+}
+catch(const std::exception &e)
+{
+	if(ircd::is_main_thread())
+		ircd::log::error
+		{
+			ircd::net::acceptor::log, "Session ticket callback :%s",
+			e.what()
+		};
+
+	return -1;
+}
+
+void
+ircd::net::acceptor::configure(const json::object &opts)
+{
+	log::debug
+	{
+		log, "%s preparing listener socket configuration...",
+		loghead(*this)
+	};
+
+	configure_password(opts);
+	configure_flags(opts);
+	configure_ciphers(opts);
+	configure_curves(opts);
+	configure_certs(opts);
+	configure_sessions(opts);
+
+	SSL_CTX_set_alpn_select_cb(ssl.native_handle(), ircd_net_acceptor_handle_alpn, this);
+	SSL_CTX_set_tlsext_servername_callback(ssl.native_handle(), ircd_net_acceptor_handle_sni);
+	SSL_CTX_set_tlsext_servername_arg(ssl.native_handle(), this);
+}
+
+void
+ircd::net::acceptor::configure_sessions(const json::object &opts)
+{
+	auto *const ctx
+	{
+		ssl.native_handle()
+	};
+
+	const bool tickets
+	{
+		opts.get<bool>("ssl_session_tickets", bool(ssl_session_tickets))
+	};
+
+	const long cache_size
+	{
+		opts.get<long>("ssl_session_cache_size", long(size_t(ssl_session_cache_size)))
+	};
+
+	const seconds timeout
+	{
+		opts.get<long>("ssl_session_timeout", seconds(ssl_session_timeout).count())
+	};
+
+	ticket_rotate = seconds
+	{
+		opts.get<long>("ssl_session_ticket_rotate", seconds(ssl_session_ticket_rotate).count())
+	};
+
+	// The session ID context scopes resumption to this listener.
+	SSL_CTX_set_session_id_context(ctx, reinterpret_cast<const uint8_t *>(name.data()), std::min(name.size(), size_t(SSL_MAX_SID_CTX_LENGTH)));
+	SSL_CTX_set_session_cache_mode(ctx, cache_size > 0? SSL_SESS_CACHE_SERVER : SSL_SESS_CACHE_OFF);
+	SSL_CTX_sess_set_cache_size(ctx, std::max(cache_size, 0L));
+	SSL_CTX_set_timeout(ctx, timeout.count());
+	SSL_CTX_set_ex_data(ctx, ssl_acceptor_idx, this);
+
+	if(tickets && ticket_rotate > seconds(0))
+	{
+		#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, ircd_net_acceptor_handle_ticket);
+		#else
+		SSL_CTX_set_tlsext_ticket_key_cb(ctx, ircd_net_acceptor_handle_ticket);
+		#endif
+	}
+	else
+		SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+
+	log::debug
+	{
+		log, "%s session cache:%ld timeout:%ld$s tickets:%b rotate:%ld$s",
+		loghead(*this),
+		cache_size,
+		timeout.count(),
+		tickets,
+		ticket_rotate.count(),
+	};
+}
+
+void
+ircd::net::acceptor::configure_flags(const json::object &opts)
+{
+	ulong flags(0);
+
+	if(opts.get<bool>("ssl_default_workarounds", false))
+		flags |= ssl.default_workarounds;
+
+	if(opts.get<bool>("ssl_single_dh_use", false))
+		flags |= ssl.single_dh_use;
+
+	if(opts.get<bool>("ssl_no_sslv2", false))
+		flags |= ssl.no_sslv2;
+
+	if(opts.get<bool>("ssl_no_sslv3", false))
+		flags |= ssl.no_sslv3;
+
+	if(opts.get<bool>("ssl_no_tlsv1", false))
+		flags |= ssl.no_tlsv1;
+
+	if(opts.get<bool>("ssl_no_tlsv1_1", false))
+		flags |= ssl.no_tlsv1_1;
+
+	if(opts.get<bool>("ssl_no_tlsv1_2", false))
+		flags |= ssl.no_tlsv1_2;
+
+	ssl.set_options(flags);
+}
+
+void
+ircd::net::acceptor::configure_ciphers(const json::object &opts)
+{
+	if(!empty(unquote(opts["ssl_cipher_list"])))
+	{
+		const json::string &list
+		{
+			opts["ssl_cipher_list"]
+		};
+
+		assert(ssl.native_handle());
+		openssl::set_cipher_list(*ssl.native_handle(), list);
+	}
 	else if(!empty(string_view(ssl_cipher_list)))
 	{
 		assert(ssl.native_handle());
@@ -2649,6 +3270,199 @@ ircd::net::scope_timeout::release()
 	return s != nullptr;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// net/iou.h
+//
+
+decltype(ircd::net::iou::support)
+ircd::net::iou::support
+{
+	#if defined(IRCD_USE_IOU)
+		info::kernel_version[0] >= 6
+	#else
+		false
+	#endif
+};
+
+decltype(ircd::net::iou::enable)
+ircd::net::iou::enable
+{
+	{ "name",     "ircd.net.iou.enable"  },
+	{ "default",  false                  },
+	{ "persist",  false                  },
+	{ "help",
+	R"(
+	Read established sockets with an io_uring multishot recv rather than asio's
+	reactor. Takes effect for sockets established after the ring is created,
+	which happens at startup.
+	)"},
+};
+
+decltype(ircd::net::iou::entries)
+ircd::net::iou::entries
+{
+	{ "name",     "ircd.net.iou.entries"  },
+	{ "default",  1024L                   },
+	{ "persist",  false                   },
+};
+
+decltype(ircd::net::iou::buf_count)
+ircd::net::iou::buf_count
+{
+	{ "name",     "ircd.net.iou.buf.count"  },
+	{ "default",  4096L                     },
+	{ "persist",  false                     },
+	{ "help",     "Number of provided receive buffers; rounded down to a power of two." },
+};
+
+decltype(ircd::net::iou::buf_size)
+ircd::net::iou::buf_size
+{
+	{ "name",     "ircd.net.iou.buf.size"  },
+	{ "default",  long(16_KiB)             },
+	{ "persist",  false                    },
+};
+
+decltype(ircd::net::iou::pending_max)
+ircd::net::iou::pending_max
+{
+	{ "name",     "ircd.net.iou.pending.max"  },
+	{ "default",  long(256_KiB)               },
+	{ "help",     "Unread input at which a socket's multishot recv is paused." },
+};
+
+decltype(ircd::net::iou::enters)
+ircd::net::iou::enters
+{
+	{ "name", "ircd.net.iou.enters" },
+	{ "desc", "Number of io_uring_enter(2) calls." },
+};
+
+decltype(ircd::net::iou::submits)
+ircd::net::iou::submits
+{
+	{ "name", "ircd.net.iou.submits" },
+	{ "desc", "Number of submission queue entries consumed by the kernel." },
+};
+
+decltype(ircd::net::iou::completions)
+ircd::net::iou::completions
+{
+	{ "name", "ircd.net.iou.completions" },
+	{ "desc", "Number of recv completions reaped." },
+};
+
+decltype(ircd::net::iou::bytes)
+ircd::net::iou::bytes
+{
+	{ "name", "ircd.net.iou.bytes" },
+	{ "desc", "Number of bytes received on the ring." },
+};
+
+decltype(ircd::net::iou::arms)
+ircd::net::iou::arms
+{
+	{ "name", "ircd.net.iou.arms" },
+	{ "desc", "Number of multishot recv submitted." },
+};
+
+decltype(ircd::net::iou::nobufs)
+ircd::net::iou::nobufs
+{
+	{ "name", "ircd.net.iou.nobufs" },
+	{ "desc", "Number of times the provided buffers ran out." },
+};
+
+decltype(ircd::net::iou::system)
+ircd::net::iou::system;
+
+//
+// recv
+//
+
+size_t
+ircd::net::iou::recv::pending()
+const
+{
+	return bio? BIO_ctrl_pending(bio) : 0UL;
+}
+
+void
+ircd::net::iou::recv::notify(const std::error_code &ec)
+noexcept
+{
+	static ios::descriptor desc
+	{
+		"ircd::net::iou::recv notify"
+	};
+
+	dock.notify_all();
+	if(!waiter)
+		return;
+
+	auto waiter
+	{
+		std::move(this->waiter)
+	};
+
+	this->waiter = {};
+	ircd::post(desc, [waiter(std::move(waiter)), ec]
+	{
+		waiter(ec);
+	});
+}
+
+#ifndef IRCD_USE_IOU
+[[gnu::weak]]
+ircd::net::iou::init::init()
+{
+}
+
+[[gnu::weak]]
+ircd::net::iou::init::~init()
+noexcept
+{
+}
+
+[[gnu::weak]]
+std::shared_ptr<ircd::net::iou::recv>
+ircd::net::iou::attach(socket &)
+{
+	return {};
+}
+
+[[gnu::weak]]
+void
+ircd::net::iou::detach(socket &)
+noexcept
+{
+}
+
+[[gnu::weak]]
+void
+ircd::net::iou::resume(recv &)
+{
+}
+
+[[gnu::weak]]
+void
+ircd::net::iou::cancel(recv &)
+noexcept
+{
+}
+
+[[gnu::weak]]
+ircd::net::iou::bench::bench(const size_t &,
+                             const size_t &)
+{
+	throw not_implemented
+	{
+		"io_uring is not supported by this build."
+	};
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // net/socket.h
@@ -2717,6 +3531,129 @@ ircd::net::socket::total_calls_out
 	{ "desc", "The total number of write operations on all sockets"  },
 };
 
+decltype(ircd::net::socket::handshakes_full)
+ircd::net::socket::handshakes_full
+{
+	{ "name", "ircd.net.socket.handshake.full"                          },
+	{ "desc", "Number of outgoing TLS handshakes without resumption"    },
+};
+
+decltype(ircd::net::socket::handshakes_resumed)
+ircd::net::socket::handshakes_resumed
+{
+	{ "name", "ircd.net.socket.handshake.resumed"                       },
+	{ "desc", "Number of outgoing TLS handshakes resuming a session"    },
+};
+
+//
+// handshake_pool
+//
+
+void
+ircd::net::handshake_pool::push(function &&func)
+{
+	const std::lock_guard lock
+	{
+		mutex
+	};
+
+	if(unlikely(threads.size() < size_t(acceptor::handshake_offload_threads)))
+		threads.emplace_back(&worker);
+
+	queue.emplace_back(std::move(func));
+	cond.notify_one();
+}
+
+void
+ircd::net::handshake_pool::worker()
+noexcept
+{
+	while(1)
+	{
+		std::unique_lock lock
+		{
+			mutex
+		};
+
+		cond.wait(lock, []
+		{
+			return !queue.empty() || termination;
+		});
+
+		if(unlikely(termination))
+			return;
+
+		auto func
+		{
+			std::move(queue.front())
+		};
+
+		queue.pop_front();
+		lock.unlock();
+		func();
+	}
+}
+
+void
+ircd::net::handshake_pool::fini()
+noexcept
+{
+	std::unique_lock lock
+	{
+		mutex
+	};
+
+	termination = true;
+	cond.notify_all();
+	auto threads(std::move(handshake_pool::threads));
+	lock.unlock();
+
+	for(auto &thread : threads)
+		thread.join();
+
+	// Steps not yet taken hold sockets which must be released here.
+	queue.clear();
+	termination = false;
+}
+
+//
+// session
+//
+
+ircd::net::session::~session()
+noexcept
+{
+	if(ssl)
+		SSL_SESSION_free(ssl);
+}
+
+/// Called by OpenSSL with a session issued by the remote; for TLS 1.3 this
+/// happens after the handshake while reading. Returning 1 takes ownership.
+static int
+ircd_net_socket_handle_session(SSL *const s,
+                               SSL_SESSION *const sess)
+noexcept
+{
+	auto *const socket
+	{
+		static_cast<ircd::net::socket *>(SSL_get_ex_data(s, ircd::net::ssl_socket_idx))
+	};
+
+	if(!socket || !socket->session)
+		return 0;
+
+	if(!SSL_SESSION_is_resumable(sess))
+		return 0;
+
+	auto &session(*socket->session);
+	if(session.ssl)
+		SSL_SESSION_free(session.ssl);
+
+	session.ssl = sess;
+	++session.saved;
+	return 1;
+}
+
 //
 // socket
 //
@@ -2748,6 +3685,8 @@ noexcept try
 	if(unlikely(--instances == 0))
 		net::dock.notify_all();
 
+	iou::detach(*this);
+
 	if(unlikely(opened(*this)))
 		throw panic
 		{
@@ -2844,6 +3783,16 @@ ircd::net::socket::handshake(const open_opts &opts,
 	if(opts.send_sni && server_name(opts))
 		openssl::server_name(*this, server_name(opts));
 
+	// Offer the session saved from a prior connection to this remote; any
+	// session the remote issues on this connection is saved by the callback.
+	session = opts.session;
+	SSL_set_ex_data(ssl.native_handle(), ssl_socket_idx, this);
+	if(session && session->ssl)
+	{
+		SSL_set_session(ssl.native_handle(), session->ssl);
+		++session->offered;
+	}
+
 	ssl.set_verify_callback(std::move(verify_handler));
 	ssl.async_handshake(handshake_type::client, ios::handle(desc, std::move(handshake_handler)));
 }
@@ -2870,6 +3819,7 @@ try
 	};
 
 	cancel();
+	iou::detach(*this);
 	assert(!fini);
 	fini = true;
 
@@ -2942,6 +3892,8 @@ ircd::net::socket::cancel()
 noexcept
 {
 	cancel_timeout();
+	if(iou)
+		iou::cancel(*iou);
 
 	boost::system::error_code ec;
 	sd.cancel(ec);
@@ -2995,15 +3947,24 @@ try
 
 	switch(opts.type)
 	{
-		case ready::READ: continuation
+		case ready::READ:
 		{
-			continuation::asio_predicate, interruption, [this]
-			(auto &yield)
+			if(iou)
 			{
-				sd.async_wait(wait_type::wait_read, yield);
+				wait_iou();
+				break;
 			}
-		};
-		break;
+
+			continuation
+			{
+				continuation::asio_predicate, interruption, [this]
+				(auto &yield)
+				{
+					sd.async_wait(wait_type::wait_read, yield);
+				}
+			};
+			break;
+		}
 
 		case ready::WRITE: continuation
 		{
@@ -3089,6 +4050,25 @@ try
 				return;
 			}
 
+			// Input on the ring is signaled by its completions rather than
+			// by the reactor; a terminal error is reported at once.
+			if(iou)
+			{
+				if(iou->ec)
+				{
+					ircd::post(desc[1], [handle(std::move(handle)), ec(iou->ec)]
+					{
+						handle(ec);
+					});
+
+					return;
+				}
+
+				iou->canceled = false;
+				iou->waiter = std::move(handle);
+				return;
+			}
+
 			// The problem here is that the wait operation gives ec=success on both a
 			// socket error and when data is actually available. We then have to check
 			// using a non-blocking peek in the handler. By doing it this way here we
@@ -3151,6 +4131,9 @@ noexcept
 	if(SSL_peek(ssl.native_handle(), buf, sizeof(buf)) > 0)
 		return ret;
 
+	if(iou)
+		return iou->ec;
+
 	assert(!blocking(*this));
 	boost::system::error_code ec;
 	if(sd.receive(bufs, sd.message_peek, ec) > 0)
@@ -3188,7 +4171,14 @@ try
 		this->cancel();
 	}};
 
-	size_t ret; continuation
+	size_t ret(0);
+	if(iou) for(const size_t max(buffers::size(bufs)); ret < max; )
+	{
+		ret += read_iou(bufs, false, ret);
+		if(ret < max)
+			wait_iou();
+	}
+	else continuation
 	{
 		continuation::asio_predicate, interruption, [this, &ret, &bufs]
 		(auto &yield)
@@ -3227,7 +4217,10 @@ try
 		this->cancel();
 	}};
 
-	size_t ret; continuation
+	size_t ret(0);
+	if(iou) while(!(ret = read_iou(bufs, false)))
+		wait_iou();
+	else continuation
 	{
 		continuation::asio_predicate, interruption, [this, &ret, &bufs]
 		(auto &yield)
@@ -3265,6 +4258,9 @@ ircd::net::socket::read_any(iov&& bufs)
 
 	assert(!fini);
 	assert(!blocking(*this));
+	if(iou)
+		return read_iou(bufs, false);
+
 	boost::system::error_code ec;
 	const size_t ret
 	{
@@ -3293,6 +4289,9 @@ ircd::net::socket::read_one(iov&& bufs)
 {
 	assert(!fini);
 	assert(!blocking(*this));
+	if(iou)
+		return read_iou(bufs, true);
+
 	boost::system::error_code ec;
 	const size_t ret
 	{
@@ -3314,6 +4313,112 @@ ircd::net::socket::read_one(iov&& bufs)
 	__builtin_unreachable();
 }
 
+/// Reads plaintext from the SSL while its input is on the ring; never
+/// blocks. The first `offset` bytes of the buffers are skipped. With `one`
+/// at most one record is taken, as with asio's read_some(). Zero is returned
+/// when nothing is available; the terminal error of the input is thrown
+/// only once the SSL has been drained.
+size_t
+ircd::net::socket::read_iou(const vector_view<const mutable_buffer> &bufs,
+                            const bool &one,
+                            const size_t &offset)
+{
+	assert(iou);
+	auto *const ssl
+	{
+		this->ssl.native_handle()
+	};
+
+	size_t ret(0), skip(offset);
+	for(const auto &buf : bufs)
+	{
+		if(skip >= size(buf))
+		{
+			skip -= size(buf);
+			continue;
+		}
+
+		for(size_t off(skip); off < size(buf); )
+		{
+			const int len
+			{
+				SSL_read(ssl, data(buf) + off, int(std::min(size(buf) - off, size_t(INT_MAX))))
+			};
+
+			if(likely(len > 0))
+			{
+				off += len;
+				ret += len;
+				if(one)
+					goto done;
+
+				continue;
+			}
+
+			switch(SSL_get_error(ssl, len))
+			{
+				case SSL_ERROR_WANT_READ:
+					goto done;
+
+				case SSL_ERROR_ZERO_RETURN:
+					iou->ec = eof;
+					goto done;
+
+				case SSL_ERROR_SSL:
+					throw_system_error(boost::system::error_code
+					{
+						int(ERR_get_error()), asio::error::get_ssl_category()
+					});
+
+				default:
+					if(!iou->ec)
+						iou->ec = eof;
+
+					goto done;
+			}
+		}
+
+		skip = 0;
+	}
+
+	done:
+	iou::resume(*iou);
+	if(ret)
+	{
+		++in.calls;
+		in.bytes += ret;
+		++total_calls_in;
+		total_bytes_in += ret;
+	}
+	else if(iou->ec && !SSL_pending(ssl) && !iou->pending())
+		throw std::system_error
+		{
+			iou->ec
+		};
+
+	return ret;
+}
+
+/// Yields ircd::ctx until there is input for the SSL on the ring. A timeout
+/// or an interruption of the ctx arrives as cancel().
+void
+ircd::net::socket::wait_iou()
+{
+	assert(iou);
+	const auto r(iou);
+	r->canceled = false;
+	r->dock.wait([this, &r]
+	{
+		return r->pending() || SSL_pending(ssl.native_handle()) || r->ec || r->canceled || fini;
+	});
+
+	if(r->canceled && timedout)
+		throw_system_error(std::errc::timed_out);
+
+	if(r->canceled || fini)
+		throw_system_error(std::errc::operation_canceled);
+}
+
 /// Yields ircd::ctx until all buffers are sent.
 template<class iov>
 size_t
@@ -3540,6 +4645,9 @@ noexcept try
 			assert(timedout == false);
 			timedout = true;
 			sd.cancel();
+			if(iou)
+				iou::cancel(*iou);
+
 			break;
 		}
 
@@ -3770,10 +4878,25 @@ noexcept try
 	};
 	#endif
 
+	if(!ec)
+	{
+		const bool resumed
+		{
+			bool(SSL_session_reused(ssl.native_handle()))
+		};
+
+		++(resumed? handshakes_resumed : handshakes_full);
+		if(resumed && session)
+			++session->resumed;
+	}
+
 	// Toggles the behavior of non-async functions; see func comment
 	if(!ec)
 		blocking(*this, false);
 
+	if(!ec)
+		iou = iou::attach(*this);
+
 	// This is the end of the asynchronous call chain; the user is called
 	// back with or without error here.
 	call_user(callback, ec);
@@ -0,0 +1,888 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <RB_INC_SYS_MMAN_H
+#include "net_iou.h"
+
+//
+// init
+//
+
+ircd::net::iou::init::init()
+{
+	assert(!system);
+	if(!iou::enable || !iou::support)
+		return;
+
+	try
+	{
+		system = new struct iou::system
+		(
+			size_t(entries),
+			size_t(buf_count),
+			size_t(buf_size)
+		);
+	}
+	catch(const std::exception &e)
+	{
+		log::warning
+		{
+			log, "Socket input by io_uring is not available :%s",
+			e.what()
+		};
+	}
+}
+
+ircd::net::iou::init::~init()
+noexcept
+{
+	delete system;
+	system = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// net_iou.h
+//
+
+/// Moves the input side of an established socket onto the ring. The SSL is
+/// given a memory BIO for reading, which the completions fill; ciphertext
+/// asio already took off the socket is moved there first. asio's BIO pair
+/// remains the SSL's write BIO.
+std::shared_ptr<ircd::net::iou::recv>
+ircd::net::iou::attach(socket &socket)
+{
+	if(!system || !enable)
+		return {};
+
+	assert(!socket.iou);
+	auto *const ssl
+	{
+		socket.ssl.native_handle()
+	};
+
+	BIO *const asio_bio
+	{
+		SSL_get_rbio(ssl)
+	};
+
+	BIO *const bio
+	{
+		BIO_new(BIO_s_mem())
+	};
+
+	if(unlikely(!bio))
+		throw error
+		{
+			"Failed to allocate BIO for io_uring input."
+		};
+
+	// An empty memory BIO signals a retry rather than EOF; EOF is delivered
+	// out of band by the completion.
+	BIO_set_mem_eof_return(bio, -1);
+
+	int len;
+	char buf[4_KiB];
+	while((len = BIO_read(asio_bio, buf, sizeof(buf))) > 0)
+		BIO_write(bio, buf, len);
+
+	// The read and write BIO are the same object holding one reference for
+	// both; SSL_set0_rbio() releases one, so one is added for the write side
+	// and later given back at detach().
+	BIO_up_ref(asio_bio);
+	SSL_set0_rbio(ssl, bio);
+
+	auto ret
+	{
+		std::make_shared<recv>()
+	};
+
+	ret->id = ++system->recv_id;
+	ret->fd = socket.sd.native_handle();
+	ret->bio = bio;
+	ret->asio_bio = asio_bio;
+	system->recvs.emplace(ret->id, ret);
+	system->arm(*ret);
+	return ret;
+}
+
+/// Returns the input side of the socket to asio, e.g. for the SSL shutdown.
+/// The multishot is canceled and submitted immediately; the ring holds a
+/// reference to the file until the final completion, which is consumed and
+/// discarded by the system.
+void
+ircd::net::iou::detach(socket &socket)
+noexcept
+{
+	if(!socket.iou)
+		return;
+
+	const auto r
+	{
+		std::move(socket.iou)
+	};
+
+	assert(!r->detached);
+	r->detached = true;
+	if(system && r->armed) try
+	{
+		system->cancel(*r);
+		system->flush();
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			log, "socket:%lu cancel io_uring recv:%lu :%s",
+			socket.id,
+			r->id,
+			e.what(),
+		};
+	}
+	else if(system)
+		system->recvs.erase(r->id);
+
+	// Any unread ciphertext is discarded with the memory BIO.
+	SSL_set0_rbio(socket.ssl.native_handle(), r->asio_bio);
+	r->bio = nullptr;
+	r->asio_bio = nullptr;
+	r->canceled = true;
+	r->notify(make_error_code(std::errc::operation_canceled));
+}
+
+/// Called after input was consumed; re-arms a multishot which was paused
+/// because too much input was left unread.
+void
+ircd::net::iou::resume(recv &r)
+{
+	if(likely(!r.paused) || r.armed || r.detached)
+		return;
+
+	if(r.pending() >= size_t(pending_max) / 2)
+		return;
+
+	assert(system);
+	r.paused = false;
+	system->arm(r);
+}
+
+/// Releases anything waiting for input with operation_canceled; the
+/// multishot itself is unaffected.
+void
+ircd::net::iou::cancel(recv &r)
+noexcept
+{
+	r.canceled = true;
+	r.notify(make_error_code(std::errc::operation_canceled));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// system
+//
+
+decltype(ircd::net::iou::system::handle_descriptor)
+ircd::net::iou::system::handle_descriptor
+{
+	"ircd::net::iou eventfd"
+};
+
+decltype(ircd::net::iou::system::submit_descriptor)
+ircd::net::iou::system::submit_descriptor
+{
+	"ircd::net::iou submit"
+};
+
+ircd::net::iou::system::system(const size_t &entries,
+                               const size_t &buf_count,
+                               const size_t &buf_size)
+:p
+{
+	0
+}
+,fd
+{
+	int(syscall<__NR_io_uring_setup>(entries, &p))
+}
+,sq_len
+{
+	p.sq_off.array + p.sq_entries * sizeof(uint32_t)
+}
+,cq_len
+{
+	p.cq_off.cqes + p.cq_entries * sizeof(::io_uring_cqe)
+}
+,sqe_len
+{
+	p.sq_entries * sizeof(::io_uring_sqe)
+}
+,sq_p
+{
+	[this]
+	{
+		void *const map
+		{
+			::mmap(NULL, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING)
+		};
+
+		if(unlikely(map == MAP_FAILED))
+			throw_system_error(errno);
+
+		return reinterpret_cast<uint8_t *>(map);
+	}(),
+	[this](uint8_t *const ptr)
+	{
+		::munmap(ptr, sq_len);
+	}
+}
+,cq_p
+{
+	[this]
+	{
+		void *const map
+		{
+			::mmap(NULL, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING)
+		};
+
+		if(unlikely(map == MAP_FAILED))
+			throw_system_error(errno);
+
+		return reinterpret_cast<uint8_t *>(map);
+	}(),
+	[this](uint8_t *const ptr)
+	{
+		::munmap(ptr, cq_len);
+	}
+}
+,sqe_p
+{
+	[this]
+	{
+		void *const map
+		{
+			::mmap(NULL, sqe_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES)
+		};
+
+		if(unlikely(map == MAP_FAILED))
+			throw_system_error(errno);
+
+		return reinterpret_cast<uint8_t *>(map);
+	}(),
+	[this](uint8_t *const ptr)
+	{
+		::munmap(ptr, sqe_len);
+	}
+}
+,sq_head
+{
+	reinterpret_cast<uint32_t *>(sq_p.get() + p.sq_off.head)
+}
+,sq_tail
+{
+	reinterpret_cast<uint32_t *>(sq_p.get() + p.sq_off.tail)
+}
+,sq_mask
+{
+	reinterpret_cast<uint32_t *>(sq_p.get() + p.sq_off.ring_mask)
+}
+,sq_array
+{
+	reinterpret_cast<uint32_t *>(sq_p.get() + p.sq_off.array)
+}
+,cq_head
+{
+	reinterpret_cast<uint32_t *>(cq_p.get() + p.cq_off.head)
+}
+,cq_tail
+{
+	reinterpret_cast<uint32_t *>(cq_p.get() + p.cq_off.tail)
+}
+,cq_mask
+{
+	reinterpret_cast<uint32_t *>(cq_p.get() + p.cq_off.ring_mask)
+}
+,sqe
+{
+	reinterpret_cast<::io_uring_sqe *>(sqe_p.get())
+}
+,cqe
+{
+	reinterpret_cast<::io_uring_cqe *>(cq_p.get() + p.cq_off.cqes)
+}
+,buf_entries
+{
+	// The kernel requires a power of two no larger than 32768.
+	uint16_t(1U << (63 - __builtin_clzl(std::clamp(buf_count, 1UL, 32768UL))))
+}
+,buf_tail
+{
+	0
+}
+,buf_len
+{
+	buf_size
+}
+,buf_ring
+{
+	buf_entries * sizeof(::io_uring_buf), 4_KiB
+}
+,buf_data
+{
+	buf_entries * buf_len, 4_KiB
+}
+,ev_fd
+{
+	ios::get(), int(syscall(::eventfd, 0, EFD_CLOEXEC | EFD_NONBLOCK))
+}
+{
+	if(unlikely(!(p.features & IORING_FEAT_NODROP)))
+		throw error
+		{
+			"io_uring lacks IORING_FEAT_NODROP (linux 5.5)"
+		};
+
+	std::memset(data(buf_ring), 0x0, size(buf_ring));
+	for(uint16_t i(0); i < buf_entries; ++i)
+		buf_return(i);
+
+	::io_uring_buf_reg reg {0};
+	reg.ring_addr = uintptr_t(data(buf_ring));
+	reg.ring_entries = buf_entries;
+	reg.bgid = 0;
+	syscall<__NR_io_uring_register>(int(fd), IORING_REGISTER_PBUF_RING, &reg, 1);
+
+	const int efd(ev_fd.native_handle());
+	syscall<__NR_io_uring_register>(int(fd), IORING_REGISTER_EVENTFD, &efd, 1);
+
+	log::info
+	{
+		log, "Socket input by io_uring sq:%u cq:%u buffers:%u of %zu bytes (%s)",
+		p.sq_entries,
+		p.cq_entries,
+		buf_entries,
+		buf_len,
+		pretty(iec(size(buf_data))),
+	};
+
+	set_handle();
+}
+
+ircd::net::iou::system::~system()
+noexcept try
+{
+	const ctx::uninterruptible::nothrow ui;
+
+	// Closing the sockets canceled their recvs; the final completions are
+	// reaped before the ring goes away.
+	if(!recvs.empty())
+		log::dwarning
+		{
+			log, "Waiting for %zu io_uring recv to complete...",
+			recvs.size(),
+		};
+
+	if(!recvs.empty())
+		dock.wait_for(seconds(5), [this]
+		{
+			return recvs.empty();
+		});
+
+	interrupt();
+	wait();
+
+	boost::system::error_code ec;
+	ev_fd.close(ec);
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Error shutting down io_uring %p :%s",
+		(const void *)this,
+		e.what()
+	};
+}
+
+bool
+ircd::net::iou::system::interrupt()
+{
+	if(!ev_fd.is_open())
+		return false;
+
+	terminating = true;
+	if(handle_set)
+		ev_fd.cancel();
+
+	return true;
+}
+
+bool
+ircd::net::iou::system::wait()
+{
+	if(!ev_fd.is_open())
+		return false;
+
+	dock.wait([this]
+	{
+		return !handle_set;
+	});
+
+	return true;
+}
+
+/// Arms a multishot recv for the socket. The kernel selects a buffer from
+/// the group for each completion.
+void
+ircd::net::iou::system::arm(recv &r)
+{
+	assert(!r.armed);
+	assert(!r.detached);
+	auto &sqe(get());
+	sqe.opcode = IORING_OP_RECV;
+	sqe.fd = r.fd;
+	sqe.ioprio = IORING_RECV_MULTISHOT;
+	sqe.flags = IOSQE_BUFFER_SELECT;
+	sqe.buf_group = 0;
+	sqe.user_data = r.id;
+	submit();
+
+	r.armed = true;
+	++iou::arms;
+}
+
+void
+ircd::net::iou::system::cancel(recv &r)
+{
+	auto &sqe(get());
+	sqe.opcode = IORING_OP_ASYNC_CANCEL;
+	sqe.fd = -1;
+	sqe.addr = r.id;
+	sqe.user_data = 0;
+	submit();
+}
+
+/// Returns the next entry on the submission queue. The entry is published
+/// to the kernel now but only submitted by flush(). If the queue is full it
+/// is flushed first.
+::io_uring_sqe &
+ircd::net::iou::system::get()
+{
+	const uint32_t head
+	{
+		__atomic_load_n(sq_head, __ATOMIC_ACQUIRE)
+	};
+
+	if(unlikely(*sq_tail - head >= p.sq_entries))
+		flush();
+
+	const uint32_t tail(*sq_tail);
+	const uint32_t idx(tail & *sq_mask);
+	auto &ret(sqe[idx]);
+	std::memset(&ret, 0x0, sizeof(ret));
+	sq_array[idx] = idx;
+	__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++queued;
+	return ret;
+}
+
+/// Submissions made during this ios iteration are batched into a single
+/// io_uring_enter(2) which runs after the handlers already queued.
+void
+ircd::net::iou::system::submit()
+{
+	if(submit_set)
+		return;
+
+	submit_set = true;
+	ircd::defer(submit_descriptor, [this]
+	{
+		submit_set = false;
+		flush();
+	});
+}
+
+void
+ircd::net::iou::system::flush()
+{
+	if(!queued)
+		return;
+
+	const auto submitted
+	{
+		syscall_nointr<__NR_io_uring_enter>(int(fd), queued, 0U, 0U, nullptr, 0UL)
+	};
+
+	++iou::enters;
+	iou::submits += submitted;
+	assert(submitted <= queued);
+	queued -= submitted;
+}
+
+void
+ircd::net::iou::system::buf_return(const uint16_t &bid)
+noexcept
+{
+	auto *const ring
+	{
+		reinterpret_cast<::io_uring_buf_ring *>(data(buf_ring))
+	};
+
+	const uint16_t mask(buf_entries - 1);
+	auto &buf(ring->bufs[buf_tail & mask]);
+	buf.addr = uintptr_t(data(buf_data) + bid * buf_len);
+	buf.len = buf_len;
+	buf.bid = bid;
+	__atomic_store_n(&ring->tail, ++buf_tail, __ATOMIC_RELEASE);
+}
+
+void
+ircd::net::iou::system::set_handle()
+try
+{
+	assert(!handle_set);
+	handle_set = true;
+	ev_count = 0;
+
+	const asio::mutable_buffers_1 bufs
+	{
+		&ev_count, sizeof(ev_count)
+	};
+
+	auto handler
+	{
+		std::bind(&system::handle, this, ph::_1, ph::_2)
+	};
+
+	ev_fd.async_read_some(bufs, ios::handle(handle_descriptor, std::move(handler)));
+}
+catch(...)
+{
+	handle_set = false;
+	throw;
+}
+
+void
+ircd::net::iou::system::handle(const error_code &ec,
+                               const size_t bytes)
+noexcept try
+{
+	namespace errc = boost::system::errc;
+
+	assert(handle_set);
+	handle_set = false;
+	switch(ec.value())
+	{
+		case errc::success:
+			handle_events();
+			break;
+
+		case errc::interrupted:
+			break;
+
+		case errc::operation_canceled:
+			throw ctx::interrupted();
+
+		default:
+			throw_system_error(ec);
+	}
+
+	if(likely(!terminating))
+		set_handle();
+}
+catch(const ctx::interrupted &)
+{
+	log::debug
+	{
+		log, "io_uring %p interrupted", this
+	};
+
+	dock.notify_all();
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "io_uring %p handle :%s",
+		this,
+		e.what()
+	};
+
+	dock.notify_all();
+}
+
+void
+ircd::net::iou::system::handle_events()
+noexcept
+{
+	uint32_t head(*cq_head);
+	const uint32_t tail
+	{
+		__atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)
+	};
+
+	for(; head != tail; ++head)
+		handle_cqe(cqe[head & *cq_mask]);
+
+	__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+	// Wakes the destructor when the last canceled recv completes.
+	if(recvs.empty())
+		dock.notify_all();
+}
+
+void
+ircd::net::iou::system::handle_cqe(const ::io_uring_cqe &cqe)
+noexcept try
+{
+	// Completions of cancel requests carry no id.
+	if(!cqe.user_data)
+		return;
+
+	++iou::completions;
+	const bool more(cqe.flags & IORING_CQE_F_MORE);
+	const auto it
+	{
+		recvs.find(cqe.user_data)
+	};
+
+	if(unlikely(it == end(recvs)))
+	{
+		assert(0);
+		if(cqe.flags & IORING_CQE_F_BUFFER)
+			buf_return(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+		return;
+	}
+
+	auto &r(*it->second);
+	if(cqe.flags & IORING_CQE_F_BUFFER)
+	{
+		const uint16_t bid(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+		if(likely(cqe.res > 0 && !r.detached))
+		{
+			BIO_write(r.bio, data(buf_data) + bid * buf_len, cqe.res);
+			iou::bytes += cqe.res;
+		}
+
+		// The data is copied out so the buffer returns to the kernel at
+		// once; unread input never starves the other sockets of buffers.
+		buf_return(bid);
+	}
+
+	if(!more)
+		r.armed = false;
+
+	if(r.detached)
+	{
+		if(!more)
+			recvs.erase(it);
+
+		return;
+	}
+
+	if(cqe.res > 0)
+	{
+		if(r.pending() > size_t(pending_max) && r.armed && !r.paused)
+		{
+			r.paused = true;
+			cancel(r);
+		}
+
+		r.notify();
+		return;
+	}
+
+	if(cqe.res == 0)
+	{
+		r.ec = net::eof;
+		r.notify(r.ec);
+		return;
+	}
+
+	switch(-cqe.res)
+	{
+		// The buffer group ran dry in a burst; the multishot ended.
+		case ENOBUFS:
+			++iou::nobufs;
+			[[fallthrough]];
+
+		case EINTR:
+		case EAGAIN:
+			if(!r.armed)
+				arm(r);
+			break;
+
+		// Paused; re-armed if the reader caught up in the meantime.
+		case ECANCELED:
+			if(!r.armed)
+				resume(r);
+			break;
+
+		default:
+			r.ec = make_error_code(std::errc(-cqe.res));
+			r.notify(r.ec);
+			break;
+	}
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "io_uring completion id:%lu res:%d flags:%u :%s",
+		cqe.user_data,
+		cqe.res,
+		cqe.flags,
+		e.what(),
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// bench
+//
+
+/// Streams `bytes` over a loopback TCP connection from a writer thread and
+/// reads it on this ctx; first by asio's reactor as sockets are read without
+/// the ring, then by a multishot recv. TLS is not involved in either path.
+ircd::net::iou::bench::bench(const size_t &bytes,
+                             const size_t &chunk)
+:bytes
+{
+	bytes
+}
+{
+	if(!system)
+		throw error
+		{
+			"Socket input by io_uring is not enabled."
+		};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		std::max(chunk, 1UL)
+	};
+
+	const auto pair{[]
+	{
+		ip::tcp::acceptor a
+		{
+			ios::get(), ip::tcp::endpoint{ip::address_v4::loopback(), 0}
+		};
+
+		ip::tcp::socket w{ios::get()}, r{ios::get()};
+		w.connect(a.local_endpoint());
+		a.accept(r);
+		r.non_blocking(true);
+		return std::make_pair(std::move(w), std::move(r));
+	}};
+
+	const auto writer{[&bytes, &buf](ip::tcp::socket &w)
+	{
+		return std::thread{[&w, &bytes, &buf]
+		{
+			boost::system::error_code ec;
+			for(size_t sent(0); sent < bytes && !ec; )
+				sent += w.send(asio::const_buffer(data(buf), std::min(size(buf), bytes - sent)), 0, ec);
+
+			w.shutdown(ip::tcp::socket::shutdown_send, ec);
+		}};
+	}};
+
+	// asio
+	{
+		auto [w, r] {pair()};
+		auto thread(writer(w));
+		const unwind join{[&thread]
+		{
+			thread.join();
+		}};
+
+		const auto start(now<steady_point>());
+		for(size_t recvd(0); recvd < bytes; ++reactor_reads)
+		{
+			size_t got; continuation
+			{
+				continuation::asio_predicate, [&r](ctx::ctx *const &)
+				{
+					r.cancel();
+				},
+				[&r, &buf, &got](auto &yield)
+				{
+					got = r.async_read_some(asio::mutable_buffer(data(buf), size(buf)), yield);
+				}
+			};
+
+			recvd += got;
+		}
+
+		reactor = now<steady_point>() - start;
+	}
+
+	// io_uring
+	{
+		auto [w, r] {pair()};
+		auto thread(writer(w));
+		const unwind join{[&thread]
+		{
+			thread.join();
+		}};
+
+		BIO *const bio(BIO_new(BIO_s_mem()));
+		const unwind free{[&bio]
+		{
+			BIO_free(bio);
+		}};
+
+		const auto rcv(std::make_shared<recv>());
+		rcv->id = ++system->recv_id;
+		rcv->fd = r.native_handle();
+		rcv->bio = bio;
+		system->recvs.emplace(rcv->id, rcv);
+		const unwind detach{[this, &rcv]
+		{
+			rcv->detached = true;
+			if(rcv->armed)
+			{
+				system->cancel(*rcv);
+				system->flush();
+			}
+			else system->recvs.erase(rcv->id);
+
+			rcv->bio = nullptr;
+		}};
+
+		const auto enters_(uint64_t(stats::get(iou::enters)));
+		const auto completions_(uint64_t(stats::get(iou::completions)));
+		const auto start(now<steady_point>());
+		system->arm(*rcv);
+		for(size_t recvd(0); recvd < bytes; )
+		{
+			rcv->dock.wait([&rcv]
+			{
+				return rcv->pending() || rcv->ec;
+			});
+
+			int got;
+			while((got = BIO_read(bio, data(buf), size(buf))) > 0)
+				recvd += got;
+
+			if(rcv->ec && !rcv->pending())
+				break;
+
+			resume(*rcv);
+		}
+
+		ring = now<steady_point>() - start;
+		ring_enters = uint64_t(stats::get(iou::enters)) - enters_;
+		ring_cqes = uint64_t(stats::get(iou::completions)) - completions_;
+	}
+}
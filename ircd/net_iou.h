@@ -0,0 +1,102 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_NET_IOU_H
+
+#ifdef IRCD_USE_IOU
+	#include <linux/io_uring.h>
+#endif
+
+namespace ircd::net::iou
+{
+	using error_code = boost::system::error_code;
+
+	std::shared_ptr<recv> attach(socket &);
+	void detach(socket &) noexcept;
+	void resume(recv &);
+	void cancel(recv &) noexcept;
+}
+
+/// The receive side of one socket on the ring. This is shared between the
+/// socket and the system; the system's reference is held until the final
+/// completion of the multishot, which can outlive the socket.
+struct ircd::net::iou::recv
+{
+	uint64_t id {0};
+	int fd {-1};
+	BIO *bio {nullptr};                          // ciphertext; owned by the SSL
+	BIO *asio_bio {nullptr};                     // asio's BIO pair; restored at detach
+	ctx::dock dock;                              // ctx waiting for input
+	socket::ec_handler waiter;                   // callback waiting for input
+	std::error_code ec;                          // eof or terminal error
+	bool armed {false};                          // multishot is active
+	bool paused {false};                         // canceled while pending is full
+	bool canceled {false};                       // waiters released by socket::cancel()
+	bool detached {false};
+
+	size_t pending() const;
+	void notify(const std::error_code & = {}) noexcept;
+};
+
+#ifdef IRCD_USE_IOU
+struct ircd::net::iou::system
+{
+	static ios::descriptor handle_descriptor;
+	static ios::descriptor submit_descriptor;
+
+	::io_uring_params p;
+	fs::fd fd;
+	size_t sq_len, cq_len, sqe_len;
+	custom_ptr<uint8_t> sq_p, cq_p, sqe_p;
+	uint32_t *sq_head, *sq_tail, *sq_mask, *sq_array;
+	uint32_t *cq_head, *cq_tail, *cq_mask;
+	::io_uring_sqe *sqe;
+	::io_uring_cqe *cqe;
+
+	// Provided buffers; the ring shares its first slot with the tail.
+	uint16_t buf_entries, buf_tail;
+	size_t buf_len;
+	unique_buffer<mutable_buffer> buf_ring;
+	unique_buffer<mutable_buffer> buf_data;
+
+	std::map<uint64_t, std::shared_ptr<recv>> recvs;
+	uint64_t recv_id {0};
+	uint32_t queued {0};
+	bool submit_set {false};
+
+	uint64_t ev_count {0};
+	asio::posix::stream_descriptor ev_fd;
+	bool handle_set {false};
+	bool terminating {false};
+	ctx::dock dock;
+
+	::io_uring_sqe &get();
+	void submit();
+	void flush();
+	void buf_return(const uint16_t &bid) noexcept;
+	void arm(recv &);
+	void cancel(recv &);
+	void handle_cqe(const ::io_uring_cqe &) noexcept;
+	void handle_events() noexcept;
+	void handle(const error_code &, const size_t bytes) noexcept;
+	void set_handle();
+	bool interrupt();
+	bool wait();
+
+	system(const size_t &entries,
+	       const size_t &buf_count,
+	       const size_t &buf_size);
+
+	system(system &&) = delete;
+	system(const system &) = delete;
+	~system() noexcept;
+};
+#endif IRCD_USE_IOU
@@ -328,6 +328,54 @@ namespace ircd
 	static void cache_warm_origin(const string_view &origin);
 }
 
+decltype(ircd::resource::method::admit_enable)
+ircd::resource::method::admit_enable
+{
+	{ "name",     "ircd.resource.admission.enable" },
+	{ "default",  true                             },
+};
+
+decltype(ircd::resource::method::admit_queue_max)
+ircd::resource::method::admit_queue_max
+{
+	{ "name",     "ircd.resource.admission.queue_max" },
+	{ "default",  5000L                               },
+	{ "help",
+	R"(
+	Milliseconds a request may have waited for a request context after which
+	it is refused with 503 rather than handled; the client has likely given
+	up by then. Never more than the method's own timeout.
+	)"},
+};
+
+decltype(ircd::resource::method::admit_queue_max_interactive)
+ircd::resource::method::admit_queue_max_interactive
+{
+	{ "name",     "ircd.resource.admission.queue_max.interactive" },
+	{ "default",  15000L                                          },
+	{ "help",     "queue_max for INTERACTIVE methods."            },
+};
+
+decltype(ircd::resource::method::admit_queue_max_expensive)
+ircd::resource::method::admit_queue_max_expensive
+{
+	{ "name",     "ircd.resource.admission.queue_max.expensive" },
+	{ "default",  1000L                                         },
+	{ "help",     "queue_max for EXPENSIVE methods."            },
+};
+
+decltype(ircd::resource::method::admit_expensive_share)
+ircd::resource::method::admit_expensive_share
+{
+	{ "name",     "ircd.resource.admission.expensive_share" },
+	{ "default",  50L                                       },
+	{ "help",
+	R"(
+	Percentage of the request pool one EXPENSIVE method may occupy while
+	requests are queued for the pool; beyond this it is refused with 429.
+	)"},
+};
+
 decltype(ircd::resource::method::idle_dock)
 ircd::resource::method::idle_dock;
 
@@ -429,6 +477,10 @@ try
 		stats->pending
 	};
 
+	// Refuse the request before any work when it can't be served in time.
+	stats->queue_time += client.queue_time.count();
+	admit(client);
+
 	// Bail out if the method limited the amount of content and it was exceeded.
 	if(head.content_length > opts->payload_max)
 		throw http::error
@@ -455,14 +507,21 @@ try
 	// This timer will keep the request from hanging forever for whatever
 	// reason. The resource method may want to do its own timing and can
 	// disable this in its options structure.
+	// HTTP/2 streams share the socket and its single timer with others on
+	// the connection, so the timer is not available to them here.
 	const net::scope_timeout timeout
 	{
-		*client.sock, opts->timeout, [this, &client]
-		(const bool &timed_out)
-		{
-			if(timed_out)
-				this->handle_timeout(client);
-		}
+		client.stream?
+			net::scope_timeout{}:
+			net::scope_timeout
+			{
+				*client.sock, opts->timeout, [this, &client]
+				(const bool &timed_out)
+				{
+					if(timed_out)
+						this->handle_timeout(client);
+				}
+			}
 	};
 
 	// Content that hasn't yet arrived is remaining
@@ -558,6 +617,88 @@ catch(...)
 	throw;
 }
 
+/// Admission control. A request which already waited for a request context
+/// longer than its class allows is refused with 503; it would be served after
+/// its client gave up. While requests are queued for the pool, an EXPENSIVE
+/// method occupying more than its share of the pool is refused with 429 so the
+/// cheaper requests behind it make progress. Both carry a Retry-After.
+void
+ircd::resource::method::admit(client &client)
+const
+{
+	if(!admit_enable)
+		return;
+
+	const milliseconds class_max
+	{
+		opts->flags & INTERACTIVE?
+			milliseconds(admit_queue_max_interactive):
+		opts->flags & EXPENSIVE?
+			milliseconds(admit_queue_max_expensive):
+			milliseconds(admit_queue_max)
+	};
+
+	const milliseconds limit
+	{
+		opts->timeout > 0s?
+			std::min(class_max, duration_cast<milliseconds>(opts->timeout)):
+			class_max
+	};
+
+	const auto queued
+	{
+		duration_cast<milliseconds>(client.queue_time)
+	};
+
+	const size_t share
+	{
+		client::pool.size() * size_t(admit_expensive_share) / 100
+	};
+
+	const bool overfull
+	{
+		opts->flags & EXPENSIVE
+		&& client::pool.queued()
+		&& stats->pending > std::max(share, 1UL)
+	};
+
+	if(likely(queued <= limit && !overfull))
+		return;
+
+	++stats->shed;
+	const auto retry_after
+	{
+		std::max(duration_cast<seconds>(queued), 1s)
+	};
+
+	char buf[24];
+	const http::header headers[]
+	{
+		{ "Retry-After", lex_cast(retry_after.count(), buf) },
+	};
+
+	log::dwarning
+	{
+		log, "%s shed %s `%s' queued:%ld pending:%lu pool:%zu:%zu",
+		client.loghead(),
+		name,
+		resource->path,
+		queued.count(),
+		stats->pending,
+		client::pool.queued(),
+		client::pool.size(),
+	};
+
+	throw http::error
+	{
+		overfull?
+			http::TOO_MANY_REQUESTS:
+			http::SERVICE_UNAVAILABLE,
+		std::string{},
+		headers,
+	};
+}
+
 ircd::resource::response
 ircd::resource::method::call_handler(client &client,
                                      resource::request &request)
@@ -683,6 +824,58 @@ ircd::resource::response::chunked::default_buffer_size
 	{ "default", long(128_KiB)                                },
 };
 
+decltype(ircd::resource::response::chunked::encoding_enable)
+ircd::resource::response::chunked::encoding_enable
+{
+	{ "name",    "ircd.resource.response.chunked.encoding.enable" },
+	{ "default", true                                             },
+	{ "help",    "Compress chunked responses for clients accepting gzip." },
+};
+
+decltype(ircd::resource::response::chunked::encoding_level)
+ircd::resource::response::chunked::encoding_level
+{
+	{ "name",    "ircd.resource.response.chunked.encoding.level" },
+	{ "default", 4L                                              },
+	{ "help",    "Compression level 1-9; -1 for the library default." },
+};
+
+decltype(ircd::resource::response::chunked::encoding_buffer_size)
+ircd::resource::response::chunked::encoding_buffer_size
+{
+	{ "name",    "ircd.resource.response.chunked.encoding.buffer_size" },
+	{ "default", long(32_KiB)                                          },
+};
+
+decltype(ircd::resource::response::chunked::encoding_offload_min)
+ircd::resource::response::chunked::encoding_offload_min
+{
+	{ "name",    "ircd.resource.response.chunked.encoding.offload_min" },
+	{ "default", long(64_KiB)                                          },
+	{ "help",    "Compress writes at least this large on an offload thread; 0 to disable." },
+};
+
+decltype(ircd::resource::response::chunked::encoding_bytes_in)
+ircd::resource::response::chunked::encoding_bytes_in
+{
+	{ "name", "ircd.resource.response.chunked.encoding.bytes_in"  },
+	{ "desc", "Number of content bytes given to the compressor"  },
+};
+
+decltype(ircd::resource::response::chunked::encoding_bytes_out)
+ircd::resource::response::chunked::encoding_bytes_out
+{
+	{ "name", "ircd.resource.response.chunked.encoding.bytes_out" },
+	{ "desc", "Number of compressed bytes sent by the compressor" },
+};
+
+decltype(ircd::resource::response::chunked::encoding_count)
+ircd::resource::response::chunked::encoding_count
+{
+	{ "name", "ircd.resource.response.chunked.encoding.count"     },
+	{ "desc", "Number of chunked responses which were compressed" },
+};
+
 ircd::resource::response::chunked::chunked(client &client,
                                            const http::code &code,
                                            const string_view &content_type,
@@ -690,7 +883,30 @@ ircd::resource::response::chunked::chunked(client &client,
                                            const size_t &buffer_size)
 :response
 {
-	client, code, content_type, size_t(-1), headers
+	client, code, content_type, size_t(-1), [&client, &content_type, &headers]
+	{
+		if(!chunked_encoding(client, content_type))
+			return headers;
+
+		// Different buffer than the one which may be passed in as headers
+		// by the delegating constructor; the same caveats apply.
+		thread_local char buffer[4_KiB];
+		window_buffer sb{buffer};
+		sb([&headers](const mutable_buffer &buf)
+		{
+			return copy(buf, headers);
+		});
+
+		const http::header encoding[]
+		{
+			{ "Content-Encoding",  "gzip"             },
+			{ "Vary",              "Accept-Encoding"  },
+		};
+
+		http::write(sb, encoding);
+
+		return string_view{sb.completed()};
+	}()
 }
 ,c
 {
@@ -700,8 +916,86 @@ ircd::resource::response::chunked::chunked(client &client,
 {
 	buffer_size
 }
+,encoder
+{
+	chunked_encoding(client, content_type)?
+		std::make_unique<zlib::deflate>(int(encoding_level)):
+		nullptr
+}
+,encoder_buf
+{
+	encoder?
+		size_t(encoding_buffer_size):
+		0UL
+}
 {
 	assert(!empty(content_type));
+	encoding_count += bool(encoder);
+}
+
+/// Whether the response to this client with this content type is compressed.
+/// This must be stable for the duration of the constructor.
+bool
+ircd::resource::response::chunked::chunked_encoding(const client &client,
+                                                    const string_view &content_type)
+{
+	if(!zlib::available || !encoding_enable)
+		return false;
+
+	// Only content which will benefit.
+	const bool compressible
+	{
+		startswith(content_type, "application/json") ||
+		startswith(content_type, "text/")
+	};
+
+	if(!compressible)
+		return false;
+
+	// An explicit gzip token takes precedence over the wildcard; the latter
+	// only applies when gzip isn't listed.
+	bool gzip{false}, listed{false}, any{false};
+	tokens(client.request.head.accept_encoding, ',', [&gzip, &listed, &any]
+	(const string_view &token)
+	{
+		const auto &[coding, params]
+		{
+			split(token, ';')
+		};
+
+		const string_view &name
+		{
+			strip(coding)
+		};
+
+		const bool explicit_gzip
+		{
+			iequals(name, "gzip"_sv) || iequals(name, "x-gzip"_sv)
+		};
+
+		if(!explicit_gzip && name != "*")
+			return;
+
+		// The coding is refused if its qvalue is zero.
+		const auto &[key, qvalue]
+		{
+			split(strip(params), '=')
+		};
+
+		const bool accepted
+		{
+			key != "q" || qvalue.find_first_not_of("0.") != qvalue.npos
+		};
+
+		if(explicit_gzip)
+		{
+			gzip |= accepted;
+			listed = true;
+		}
+		else any = accepted;
+	});
+
+	return listed? gzip : any;
 }
 
 ircd::resource::response::chunked::~chunked()
@@ -747,15 +1041,18 @@ ircd::resource::response::chunked::flush(const const_buffer &buf)
 		write(buf, true)
 	};
 
-	assert(wrote > 0 || empty(buf));
+	// The compressor consumes all of the input even if it produces nothing.
+	assert(wrote > 0 || empty(buf) || encoder);
 	const size_t flushed
 	{
-		std::min(size(buf), wrote)
+		encoder?
+			size(buf):
+			std::min(size(buf), wrote)
 	};
 
 	assert(flushed <= size(buf));
 	this->flushed += flushed;
-	assert(this->flushed <= this->wrote);
+	assert(this->flushed <= this->wrote || encoder);
 	return const_buffer
 	{
 		data(buf), flushed
@@ -765,9 +1062,74 @@ ircd::resource::response::chunked::flush(const const_buffer &buf)
 size_t
 ircd::resource::response::chunked::write(const const_buffer &chunk,
                                          const bool &ignore_empty)
+{
+	if(!c)
+		return 0UL;
+
+	if(empty(chunk) && ignore_empty)
+		return 0UL;
+
+	if(encoder)
+		return write_encoded(chunk, empty(chunk));
+
+	return write_chunk(chunk, ignore_empty);
+}
+
+/// Feed the content to the compressor and send whatever it produces, which
+/// is flushed through to the end of the content; when finishing, the
+/// remainder is drained and the terminating chunk is sent.
+/// Large inputs are compressed on an offload thread; the socket writes are
+/// always made from this ctx.
+size_t
+ircd::resource::response::chunked::write_encoded(const const_buffer &chunk,
+                                                 const bool &finish)
+{
+	assert(encoder);
+	assert(!finished);
+	const bool offload
+	{
+		size_t(encoding_offload_min) &&
+		size(chunk) >= size_t(encoding_offload_min)
+	};
+
+	size_t ret(0);
+	const_buffer in(chunk);
+	do
+	{
+		const_buffer out;
+		const auto compress{[this, &out, &in, &finish]
+		{
+			out = (*encoder)(encoder_buf, in, finish);
+		}};
+
+		if(offload)
+			ctx::offload{compress};
+		else
+			compress();
+
+		const size_t wrote
+		{
+			write_chunk(out, true)
+		};
+
+		encoding_bytes_out += size(out);
+		ret += wrote;
+	}
+	while(!empty(in) || !encoder->flushed || (finish && !encoder->finished));
+
+	encoding_bytes_in += size(chunk);
+	if(finish)
+		ret += write_chunk(const_buffer{}, false);
+
+	return ret;
+}
+
+size_t
+ircd::resource::response::chunked::write_chunk(const const_buffer &chunk,
+                                               const bool &ignore_empty)
 try
 {
-	assert(size(chunk) <= size(this->buf) || empty(this->buf));
+	assert(size(chunk) <= size(this->buf) || empty(this->buf) || encoder);
 	assert(!finished);
 	if(!c)
 		return 0UL;
@@ -775,12 +1137,22 @@ try
 	if(empty(chunk) && ignore_empty)
 		return 0UL;
 
-	char headbuf[32];
 	const size_t wrote
 	{
 		this->wrote
 	};
 
+	// HTTP/2 streams have their own framing; the end of the stream takes
+	// the place of the terminating chunk.
+	if(c->stream)
+	{
+		this->wrote += !empty(chunk)? c->write_all(chunk) : 0UL;
+		finished |= empty(chunk);
+		count++;
+		return this->wrote - wrote;
+	}
+
+	char headbuf[32];
 	//TODO: bring iov from net::socket -> net::write_() -> client::write_()
 	const auto head
 	{
@@ -18,6 +18,7 @@ namespace ircd::server
 	template<class F> static size_t accumulate_links(F&&);
 	template<class F> static size_t accumulate_tags(F&&);
 	static string_view canonize(const hostport &); // TLS buffer
+	template<class T> static T ewma(const T &avg, const T &sample);
 
 	// Internal control
 	static decltype(ircd::server::peers)::iterator
@@ -309,6 +310,22 @@ ircd::server::tag_count()
 	});
 }
 
+/// Exponentially weighted moving average with a weight of 1/8 for the new
+/// sample; the first sample is taken as-is. The difference is always taken
+/// as a magnitude so an unsigned T can't wrap around.
+template<class T>
+T
+ircd::server::ewma(const T &avg,
+                   const T &sample)
+{
+	if(!(avg > T{0}))
+		return sample;
+
+	return sample < avg?
+		avg - (avg - sample) / 8:
+		avg + (sample - avg) / 8;
+}
+
 template<class F>
 size_t
 ircd::server::accumulate_tags(F&& closure)
@@ -643,6 +660,9 @@ ircd::server::peer::peer(const net::hostport &hostport,
 		};
 
 	this->open_opts.ipport = this->remote;
+
+	// Sessions are resumed across this peer's links; each peer has its own.
+	this->open_opts.session = std::make_shared<net::session>();
 }
 
 ircd::server::peer::~peer()
@@ -784,7 +804,9 @@ catch(const std::exception &e)
 
 /// Dispatch algorithm here; finds the best link to place this request on,
 /// or creates a new link entirely. There are a number of factors: foremost
-/// if any special needs are indicated,
+/// if any special needs are indicated. Once the peer's round-trip time has
+/// been measured, links are compared by the expected completion time of the
+/// request, and a new link is opened when that beats all existing links.
 //
 ircd::server::link *
 ircd::server::peer::link_get(const request &request)
@@ -802,16 +824,29 @@ ircd::server::peer::link_get(const request &request)
 		links.size() >= link_max()
 	};
 
+	// Whether completion time estimates are available for this peer.
+	const bool measured
+	{
+		rtt.count() > 0
+	};
+
 	link *best{nullptr};
+	microseconds best_ect {0};
 	for(auto &cand : links)
 	{
 		// Don't want a link that's shutting down or marked for exclusion
 		if(cand.op_fini || cand.exclude)
 			continue;
 
+		const auto cand_ect
+		{
+			measured? expected(&cand) : 0us
+		};
+
 		if(!best)
 		{
 			best = &cand;
+			best_ect = cand_ect;
 			continue;
 		}
 
@@ -830,12 +865,24 @@ ircd::server::peer::link_get(const request &request)
 		if(best_maxed && !cand_maxed)
 		{
 			best = &cand;
+			best_ect = cand_ect;
 			continue;
 		}
 
 		if(!best_maxed && cand_maxed)
 			continue;
 
+		if(measured)
+		{
+			if(cand_ect < best_ect)
+			{
+				best = &cand;
+				best_ect = cand_ect;
+			}
+
+			continue;
+		}
+
 		// Candidates's queue has less or same backlog of unsent requests, but
 		// now measure if candidate will take longer to process at least the
 		// write-side of those requests.
@@ -882,9 +929,11 @@ ircd::server::peer::link_get(const request &request)
 		return best;
 	}
 
-	// If the best has room in its pipe we give it a shot.
+	// If the best has room in its pipe we give it a shot, unless opening
+	// another link is expected to complete the request sooner.
 	if(best->tag_committed() < best->tag_commit_max())
-		return best;
+		if(!measured || best_ect <= expected(nullptr))
+			return best;
 
 	// Otherwise create a new link.
 	best = &link_add();
@@ -1076,6 +1125,27 @@ noexcept try
 		};
 	}
 
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	if(tag.state.queued != steady_point{})
+		link.latency = ewma(link.latency, duration_cast<microseconds>(now - tag.state.queued));
+
+	link.done_ts = now;
+	read_avg = ewma(read_avg, tag.read_completed());
+
+	// Throughput is only sampled from responses large enough for the
+	// transfer to outweigh the timer resolution and the round trip.
+	const auto transfer
+	{
+		duration_cast<microseconds>(now - tag.state.head)
+	};
+
+	if(tag.state.head != steady_point{} && tag.state.content_read >= 16_KiB && transfer >= 1ms)
+		rate = ewma(rate, tag.state.content_read / (transfer.count() / 1e6));
+
 	if(link.tag_committed() >= link.tag_commit_max())
 		link.wait_writable();
 }
@@ -1098,7 +1168,25 @@ ircd::server::peer::handle_link_done(link &link)
 {
 	assert(link.tag_count() == 0);
 
-	if(link_ready() > link_min())
+	// An idle link beyond the minimum is kept open while the other links are
+	// backlogged beyond what opening it again would cost.
+	const auto backlog
+	{
+		std::accumulate(begin(links), end(links), microseconds::max(), [this, &link]
+		(const auto &ret, const auto &other)
+		{
+			return &other != &link && other.ready()?
+				std::min(ret, expected(&other)):
+				ret;
+		})
+	};
+
+	const bool backlogged
+	{
+		rtt.count() && backlog != microseconds::max() && backlog > expected(nullptr)
+	};
+
+	if(link_ready() > link_min() && !backlogged)
 	{
 		link.close();
 		return;
@@ -1115,6 +1203,18 @@ ircd::server::peer::handle_head_recv(const link &link,
                                      const tag &tag,
                                      const http::response::head &head)
 {
+	// The round trip of a pipelined request starts when the remote could
+	// begin on it: once it was written and the response ahead of it was done.
+	if(tag.state.sent != steady_point{})
+	{
+		const auto start
+		{
+			std::max(tag.state.sent, link.done_ts)
+		};
+
+		rtt = ewma(rtt, duration_cast<microseconds>(tag.state.head - start));
+	}
+
 	// Learn the software version of the remote peer so we can shape
 	// requests more effectively.
 	if(!server_version && head.server)
@@ -1551,6 +1651,47 @@ const
 	return write_bytes;
 }
 
+/// Estimate the time until a request placed on the link now would complete.
+/// With a null link the estimate is for a new link, which must first connect
+/// and handshake. The estimate is made from the round-trip time and transfer
+/// rate measured on this peer; zero is returned until there is a measurement.
+ircd::microseconds
+ircd::server::peer::expected(const link *const link)
+const
+{
+	if(!rtt.count())
+		return 0us;
+
+	// TCP and TLS handshakes cost about two round trips before the request.
+	if(!link)
+		return rtt * 3;
+
+	// Responses ahead of us which haven't given a content-length yet are
+	// assumed to be of the average size.
+	const size_t bytes
+	{
+		link->write_remaining() + link->accumulate_tags([this]
+		(const auto &tag)
+		{
+			return tag.state.content_length?
+				tag.read_remaining():
+				read_avg;
+		})
+	};
+
+	const microseconds transfer
+	{
+		rate > 0.0?
+			microseconds(int64_t(bytes / rate * 1e6)):
+			0us
+	};
+
+	return
+		(link->ready()? 0us : rtt * 2) +
+		rtt * (link->tag_count() + 1) +
+		transfer;
+}
+
 size_t
 ircd::server::peer::read_remaining()
 const
@@ -1820,6 +1961,8 @@ ircd::server::link::submit(request &request)
 		request.tag? queue.emplace(end(queue), std::move(*request.tag)):
 		             queue.emplace(end(queue), request)
 	};
+
+	it->state.queued = now<steady_point>();
 /*
 	log::debug
 	{
@@ -2897,6 +3040,8 @@ ircd::server::tag::wrote_buffer(const const_buffer &buffer)
 	assert(request);
 	const auto &req{*request};
 	state.written += size(buffer);
+	if(state.written == write_size())
+		state.sent = now<steady_point>();
 
 	if(state.written <= size(req.out.head))
 	{
@@ -3124,6 +3269,7 @@ ircd::server::tag::read_head(const const_buffer &buffer,
 	// Proffer the HTTP head to the peer instance which owns the link working
 	// this tag so it can learn from any header data.
 	assert(link.peer);
+	state.head = now<steady_point>();
 	link.peer->handle_head_recv(link, *this, head);
 
 	if(contiguous)
@@ -230,6 +230,51 @@ const
 	};
 }
 
+namespace ircd::ed25519
+{
+	extern conf::item<size_t> verify_offload_min;
+}
+
+decltype(ircd::ed25519::verify_offload_min)
+ircd::ed25519::verify_offload_min
+{
+	{ "name",    "ircd.ed25519.verify.offload_min" },
+	{ "default", 16L                               },
+	{ "help",    "Verify batches at least this large on an offload thread; 0 to disable." },
+};
+
+/// Verify each item; valid[i] is the result for items[i]. Returns the number
+/// which are valid. Large batches are verified on an offload thread so the
+/// main thread serves other contexts meanwhile.
+size_t
+ircd::ed25519::verify_batch(const vector_view<const verify_item> &items,
+                            const vector_view<bool> &valid)
+{
+	assert(valid.size() >= items.size());
+	const auto verify{[&items, &valid]
+	{
+		for(size_t i(0); i < items.size(); ++i)
+		{
+			assert(items[i].key && items[i].sig);
+			valid[i] = items[i].key->verify(items[i].msg, *items[i].sig);
+		}
+	}};
+
+	const bool offload
+	{
+		ctx::current &&
+		size_t(verify_offload_min) &&
+		items.size() >= size_t(verify_offload_min)
+	};
+
+	if(offload)
+		ctx::offload{verify};
+	else
+		verify();
+
+	return std::count(begin(valid), begin(valid) + items.size(), true);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // Internal
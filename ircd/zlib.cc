@@ -0,0 +1,160 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#if defined(HAVE_ZLIB_H)
+	#include <RB_INC_ZLIB_H
+	#define IRCD_USE_ZLIB
+#else
+	struct z_stream_s {};
+#endif
+
+decltype(ircd::zlib::available)
+ircd::zlib::available
+{
+	#if defined(IRCD_USE_ZLIB)
+		true
+	#else
+		false
+	#endif
+};
+
+decltype(ircd::zlib::version_api)
+ircd::zlib::version_api
+{
+	"zlib", info::versions::API,
+	#if defined(IRCD_USE_ZLIB)
+		ZLIB_VERNUM,
+		{ ZLIB_VER_MAJOR, ZLIB_VER_MINOR, ZLIB_VER_REVISION },
+		ZLIB_VERSION
+	#else
+		0
+	#endif
+};
+
+decltype(ircd::zlib::version_abi)
+ircd::zlib::version_abi
+{
+	"zlib", info::versions::ABI, 0, {0},
+	#if defined(IRCD_USE_ZLIB)
+		::zlibVersion()
+	#else
+		string_view{}
+	#endif
+};
+
+//
+// deflate
+//
+
+#if defined(IRCD_USE_ZLIB)
+
+ircd::zlib::deflate::deflate(const int &level,
+                             const bool &gzip)
+:z
+{
+	std::make_unique<z_stream_s>()
+}
+{
+	// windowBits 15 is the maximum window; adding 16 selects the gzip
+	// wrapper rather than the zlib wrapper.
+	const int window_bits
+	{
+		15 + (gzip? 16 : 0)
+	};
+
+	const int ret
+	{
+		::deflateInit2(z.get(), level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY)
+	};
+
+	if(unlikely(ret != Z_OK))
+		throw error
+		{
+			"deflateInit2(level:%d) :%s",
+			level,
+			z->msg?: "failed",
+		};
+}
+
+ircd::zlib::deflate::~deflate()
+noexcept
+{
+	if(z)
+		::deflateEnd(z.get());
+}
+
+ircd::const_buffer
+ircd::zlib::deflate::operator()(const mutable_buffer &out,
+                                const_buffer &in,
+                                const bool &finish)
+{
+	assert(!finished);
+	assert(size(out) > 0);
+	z->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data(in)));
+	z->avail_in = size(in);
+	z->next_out = reinterpret_cast<Bytef *>(data(out));
+	z->avail_out = size(out);
+
+	// The sync flush is only complete once deflate() returns with output
+	// space left over; until then it has to be called again with the same
+	// flush value and more space.
+	const int ret
+	{
+		::deflate(z.get(), finish? Z_FINISH : Z_SYNC_FLUSH)
+	};
+
+	if(unlikely(ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR))
+		throw error
+		{
+			"deflate() :%s",
+			z->msg?: "failed",
+		};
+
+	const size_t consumed(size(in) - z->avail_in);
+	const size_t produced(size(out) - z->avail_out);
+	consume(in, consumed);
+	this->consumed += consumed;
+	this->produced += produced;
+	finished = ret == Z_STREAM_END;
+	flushed = finished || z->avail_out > 0;
+	return const_buffer
+	{
+		data(out), produced
+	};
+}
+
+#else // IRCD_USE_ZLIB
+
+ircd::zlib::deflate::deflate(const int &level,
+                             const bool &gzip)
+{
+	throw error
+	{
+		"zlib is not available in this build."
+	};
+}
+
+ircd::zlib::deflate::~deflate()
+noexcept
+{
+}
+
+ircd::const_buffer
+ircd::zlib::deflate::operator()(const mutable_buffer &out,
+                                const_buffer &in,
+                                const bool &finish)
+{
+	throw error
+	{
+		"zlib is not available in this build."
+	};
+}
+
+#endif // IRCD_USE_ZLIB
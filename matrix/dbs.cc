@@ -127,6 +127,7 @@ ircd::m::dbs::init::init(const string_view &servername,
 	room_joined = db::domain{*events, desc::room_joined.name};
 	room_state = db::domain{*events, desc::room_state.name};
 	room_state_space = db::domain{*events, desc::room_state_space.name};
+	ephemeral = db::domain{*events, desc::ephemeral.name};
 }
 
 /// Shuts down the m::dbs subsystem; closes the events database. The extern
@@ -529,6 +529,10 @@ ircd::m::dbs::desc::events
 	// Mapping of all current head events for a room.
 	room_head,
 
+	// (space, key) => (expires, value)
+	// Values outside of the event graph, dropped when expired.
+	ephemeral,
+
 	//
 	// These columns are legacy; they have been dropped from the schema.
 	//
@@ -0,0 +1,170 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+decltype(ircd::m::dbs::ephemeral)
+ircd::m::dbs::ephemeral;
+
+decltype(ircd::m::dbs::desc::ephemeral__block__size)
+ircd::m::dbs::desc::ephemeral__block__size
+{
+	{ "name",     "ircd.m.dbs._ephemeral.block.size" },
+	{ "default",  long(4_KiB)                        },
+};
+
+decltype(ircd::m::dbs::desc::ephemeral__meta_block__size)
+ircd::m::dbs::desc::ephemeral__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._ephemeral.meta_block.size" },
+	{ "default",  long(4_KiB)                             },
+};
+
+decltype(ircd::m::dbs::desc::ephemeral__cache__size)
+ircd::m::dbs::desc::ephemeral__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._ephemeral.cache.size" },
+		{ "default",  long(8_MiB)                        },
+	}, []
+	{
+		const size_t &value{ephemeral__cache__size};
+		db::capacity(db::cache(dbs::ephemeral), value);
+	}
+};
+
+/// prefix transform for space,key in space
+///
+const ircd::db::prefix_transform
+ircd::m::dbs::desc::ephemeral__pfx
+{
+	"_ephemeral",
+
+	[](const string_view &key)
+	{
+		return has(key, "\0"_sv);
+	},
+
+	[](const string_view &key)
+	{
+		return split(key, "\0"_sv).first;
+	}
+};
+
+/// Expired values are dropped when compaction comes across them; nothing
+/// else has to visit the column to clean it.
+const ircd::db::compactor
+ircd::m::dbs::desc::ephemeral__cmp
+{
+	[](const db::compactor::args &a) -> db::op
+	{
+		if(unlikely(size(a.val) < sizeof(int64_t)))
+			return db::op::DELETE;
+
+		const milliseconds expires
+		{
+			byte_view<int64_t>(a.val.substr(0, sizeof(int64_t)))
+		};
+
+		return expires < ircd::now<system_point>().time_since_epoch()?
+			db::op::DELETE:
+			db::op::GET;
+	}
+};
+
+/// This column stores values which are not events.
+///
+const ircd::db::descriptor
+ircd::m::dbs::desc::ephemeral
+{
+	// name
+	"_ephemeral",
+
+	// explanation
+	R"(Ephemeral values.
+
+	[space | key => expires, value]
+
+	The key is a space and key concatenation. The space is an arbitrary name
+	for a set of values, and can be iterated. The value is prefixed with the
+	milliseconds since the epoch when it expires, after which it is treated
+	as absent and is removed by the compactor.
+
+	This is written directly rather than by evaluating events; it does not
+	consume event_idx sequence numbers, run hooks or notify sync. It is used
+	for internal caches whose contents can be lost without consequence.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	ephemeral__pfx,
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	0, //no compresed cache
+
+	// bloom filter bits
+	0, //table too ephemeral for bloom generation/usefulness
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(ephemeral__block__size),
+
+	// meta_block size
+	size_t(ephemeral__meta_block__size),
+
+	// compression
+	"kLZ4Compression;kSnappyCompression"s,
+
+	// compactor
+	ephemeral__cmp,
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+// key
+//
+
+std::pair<ircd::string_view, ircd::string_view>
+ircd::m::dbs::ephemeral_key(const string_view &amalgam)
+{
+	return split(amalgam, "\0"_sv);
+}
+
+ircd::string_view
+ircd::m::dbs::ephemeral_key(const mutable_buffer &out_,
+                            const string_view &space,
+                            const string_view &key)
+{
+	assert(!has(space, "\0"_sv));
+	mutable_buffer out{out_};
+	consume(out, copy(out, space));
+	consume(out, copy(out, "\0"_sv));
+	consume(out, copy(out, key));
+	return { data(out_), data(out) };
+}
@@ -58,6 +58,64 @@ ircd::m::dbs::desc::event_json__bloom__bits
 	{ "default",  9L                                  },
 };
 
+decltype(ircd::m::dbs::desc::event_json__pack)
+ircd::m::dbs::desc::event_json__pack
+{
+	{ "name",     "ircd.m.dbs._event_json.pack" },
+	{ "default",  false                         },
+	{ "help",
+
+	R"(
+	Store events with a header locating each property so fetching an event
+	does not tokenize its JSON. New events are written packed, and existing
+	values are rewritten as compaction comes across them. Values of either
+	form are always readable; disabling this leaves packed values in place.
+	)"}
+};
+
+/// Existing values are packed as compaction comes across them when enabled;
+/// this is the migration, there is no offline conversion.
+const ircd::db::compactor
+ircd::m::dbs::desc::event_json__cmp
+{
+	[](const db::compactor::args &a) -> db::op
+	{
+		try
+		{
+			if(!bool(event_json__pack))
+				return db::op::GET;
+
+			if(empty(a.val) || event_json_packed(a.val))
+				return db::op::GET;
+
+			assert(a.replace);
+			a.replace->resize(size(a.val) + sizeof(event_json_header) + event::size() * sizeof(event_json_header::loc));
+			const string_view packed
+			{
+				event_json_pack(mutable_buffer{*a.replace}, json::object{a.val})
+			};
+
+			// Value was not packable; left as it is.
+			if(!event_json_packed(packed))
+				return db::op::GET;
+
+			a.replace->resize(size(packed));
+			return db::op::SET;
+		}
+		catch(const std::exception &e)
+		{
+			log::error
+			{
+				log, "_event_json compaction of event_idx:%lu :%s",
+				byte_view<uint64_t>(a.key),
+				e.what(),
+			};
+
+			return db::op::GET;
+		}
+	}
+};
+
 const ircd::db::descriptor
 ircd::m::dbs::desc::event_json
 {
@@ -110,7 +168,7 @@ ircd::m::dbs::desc::event_json
 	"kLZ4Compression;kSnappyCompression"s,
 
 	// compactor
-	{},
+	event_json__cmp,
 
 	// compaction priority algorithm
 	"kOldestLargestSeqFirst"s,
@@ -176,13 +234,220 @@ ircd::m::dbs::_index_event_json(db::txn &txn,
 		string_view{}
 	};
 
+	thread_local char pbuf[m::event::MAX_SIZE + sizeof(event_json_header) + event::size() * sizeof(event_json_header::loc)];
+	const string_view &packed
+	{
+		opts.op == db::op::SET && bool(desc::event_json__pack)?
+			event_json_pack(mutable_buffer{pbuf}, json::object{val}):
+			val
+	};
+
 	db::txn::append
 	{
 		txn, event_json,
 		{
 			opts.op,   // db::op
 			key,       // key
-			val,       // val
+			packed,    // val
 		}
 	};
 }
+
+//
+// packed
+//
+
+/// Pack the JSON of an event for storage. Each top-level member naming an
+/// m::event property is located; the last of duplicate members is the one
+/// assigned, as with the tuple's object constructor. If the JSON can't be
+/// located by 16-bit offsets the JSON itself is returned unpacked.
+ircd::string_view
+ircd::m::dbs::event_json_pack(const mutable_buffer &buf,
+                              const json::object &source)
+{
+	static_assert(event::size() <= sizeof(event_json_header::present) * 8);
+	using loc = event_json_header::loc;
+
+	if(unlikely(size(source) > std::numeric_limits<uint16_t>::max()))
+		return string_view
+		{
+			data(buf), copy(buf, string_view{source})
+		};
+
+	event_json_header header;
+	loc locs[event::size()];
+	for(const auto &[key, val] : source)
+	{
+		const auto idx
+		{
+			json::indexof<event>(key)
+		};
+
+		if(idx >= event::size())
+			continue;
+
+		header.present |= (1U << idx);
+		locs[idx].off = data(val) - data(string_view{source});
+		locs[idx].len = size(val);
+	}
+
+	for(size_t i(0); i < event::size(); ++i)
+		header.count += bool(header.present & (1U << i));
+
+	const size_t required
+	{
+		sizeof(header) + header.count * sizeof(loc) + size(string_view{source})
+	};
+
+	if(unlikely(required > size(buf)))
+		throw panic
+		{
+			"Insufficient buffer of %zu to pack event requiring %zu bytes.",
+			size(buf),
+			required,
+		};
+
+	mutable_buffer out(buf);
+	consume(out, copy(out, const_buffer
+	{
+		reinterpret_cast<const char *>(&header), sizeof(header)
+	}));
+
+	for(size_t i(0); i < event::size(); ++i)
+		if(header.present & (1U << i))
+			consume(out, copy(out, const_buffer
+			{
+				reinterpret_cast<const char *>(locs + i), sizeof(loc)
+			}));
+
+	consume(out, copy(out, string_view{source}));
+	return string_view
+	{
+		data(buf), required
+	};
+}
+
+/// Assign the event from a packed value without tokenizing the JSON. The
+/// event is cleared first; event.source is the JSON and event.event_id is
+/// left for the caller.
+void
+ircd::m::dbs::event_json_unpack(m::event &event,
+                                const string_view &val,
+                                const m::event::keys &keys)
+{
+	using loc = event_json_header::loc;
+
+	assert(event_json_packed(val));
+	const auto &header
+	{
+		*reinterpret_cast<const event_json_header *>(data(val))
+	};
+
+	const auto locs
+	{
+		reinterpret_cast<const loc *>(data(val) + sizeof(header))
+	};
+
+	const string_view source
+	{
+		event_json_source(val)
+	};
+
+	event = m::event{};
+	event.source = source;
+	for(size_t i(0), j(0); i < m::event::size(); ++i)
+	{
+		if(!(header.present & (1U << i)))
+			continue;
+
+		const auto &l(locs[j++]);
+		const string_view key
+		{
+			json::key<m::event>(i)
+		};
+
+		if(unlikely(l.off + l.len > size(source)))
+			throw json::parse_error
+			{
+				"Packed event property '%s' out of range.",
+				key,
+			};
+
+		if(keys.has(key))
+			json::set(event, key, source.substr(l.off, l.len));
+	}
+}
+
+/// Value of the top-level member in either form of stored value. For a
+/// packed value and a key which is an event property this is a lookup.
+ircd::string_view
+ircd::m::dbs::event_json_get(const string_view &val,
+                             const string_view &key)
+{
+	using loc = event_json_header::loc;
+
+	const json::object source
+	{
+		event_json_source(val)
+	};
+
+	const auto idx
+	{
+		json::indexof<event>(key)
+	};
+
+	if(!event_json_packed(val) || idx >= event::size())
+		return source.get(key);
+
+	const auto &header
+	{
+		*reinterpret_cast<const event_json_header *>(data(val))
+	};
+
+	if(!(header.present & (1U << idx)))
+		return {};
+
+	const auto locs
+	{
+		reinterpret_cast<const loc *>(data(val) + sizeof(header))
+	};
+
+	const auto &l
+	{
+		locs[__builtin_popcount(header.present & ((1U << idx) - 1))]
+	};
+
+	return string_view{source}.substr(l.off, l.len);
+}
+
+/// The JSON of the event in either form of stored value.
+ircd::json::object
+ircd::m::dbs::event_json_source(const string_view &val)
+noexcept
+{
+	if(!event_json_packed(val))
+		return val;
+
+	const auto &header
+	{
+		*reinterpret_cast<const event_json_header *>(data(val))
+	};
+
+	const size_t offset
+	{
+		sizeof(header) + header.count * sizeof(event_json_header::loc)
+	};
+
+	return offset <= size(val)?
+		val.substr(offset):
+		string_view{};
+}
+
+bool
+ircd::m::dbs::event_json_packed(const string_view &val)
+noexcept
+{
+	return size(val) >= sizeof(event_json_header) &&
+	       uint8_t(val[0]) == event_json_header::MAGIC &&
+	       uint8_t(val[1]) == event_json_header::FORMAT;
+}
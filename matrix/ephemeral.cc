@@ -0,0 +1,312 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::ephemeral
+{
+	struct entry;
+
+	static milliseconds now();
+	static std::shared_ptr<const entry> find(const string_view &key);
+	static std::shared_ptr<const entry> fetch(const string_view &key);
+	static void remember(const string_view &key, std::shared_ptr<const entry>);
+	static void forget(const string_view &key);
+
+	extern std::map<std::string, std::shared_ptr<const entry>, std::less<>> mem;
+	extern std::set<std::pair<milliseconds, string_view>> mem_expiry;
+}
+
+/// Memory-resident value; shared with any closure reading it so it can be
+/// replaced while the closure is running.
+struct ircd::m::ephemeral::entry
+{
+	milliseconds expires;
+	std::string val;
+};
+
+decltype(ircd::m::ephemeral::mem_max)
+ircd::m::ephemeral::mem_max
+{
+	{ "name",     "ircd.m.ephemeral.mem.max" },
+	{ "default",  long(64_KiB)               },
+	{ "help",
+	R"(
+	Number of values kept in memory in front of the database.
+	)"},
+};
+
+decltype(ircd::m::ephemeral::mem_hits)
+ircd::m::ephemeral::mem_hits
+{
+	{ "name", "ircd.m.ephemeral.mem.hits"                 },
+	{ "desc", "Reads served from memory"                  },
+};
+
+decltype(ircd::m::ephemeral::mem_misses)
+ircd::m::ephemeral::mem_misses
+{
+	{ "name", "ircd.m.ephemeral.mem.misses"               },
+	{ "desc", "Reads which went to the database"          },
+};
+
+decltype(ircd::m::ephemeral::writes)
+ircd::m::ephemeral::writes
+{
+	{ "name", "ircd.m.ephemeral.writes"                   },
+	{ "desc", "Values written to the database"            },
+};
+
+decltype(ircd::m::ephemeral::mem)
+ircd::m::ephemeral::mem;
+
+/// Index of mem in the order of expiration, so the next value to go is at
+/// the front; the keys are views of those in mem.
+decltype(ircd::m::ephemeral::mem_expiry)
+ircd::m::ephemeral::mem_expiry;
+
+bool
+ircd::m::ephemeral::del(const string_view &space,
+                        const string_view &key_)
+{
+	char buf[dbs::EPHEMERAL_KEY_MAX_SIZE];
+	const string_view key
+	{
+		dbs::ephemeral_key(buf, space, key_)
+	};
+
+	const bool ret
+	{
+		mem.count(key) || db::has(dbs::ephemeral, key)
+	};
+
+	forget(key);
+
+	db::del(dbs::ephemeral, key);
+	return ret;
+}
+
+void
+ircd::m::ephemeral::set(const string_view &space,
+                        const string_view &key_,
+                        const string_view &val,
+                        const seconds &ttl)
+{
+	char buf[dbs::EPHEMERAL_KEY_MAX_SIZE];
+	const string_view key
+	{
+		dbs::ephemeral_key(buf, space, key_)
+	};
+
+	const int64_t expires
+	{
+		(now() + ttl).count()
+	};
+
+	const unique_mutable_buffer value
+	{
+		sizeof(expires) + size(val)
+	};
+
+	mutable_buffer out{value};
+	consume(out, copy(out, byte_view<string_view>(expires)));
+	consume(out, copy(out, val));
+	db::write(dbs::ephemeral, key, value);
+	++writes;
+
+	remember(key, std::make_shared<const entry>(entry
+	{
+		milliseconds(expires), std::string(val)
+	}));
+}
+
+bool
+ircd::m::ephemeral::has(const string_view &space,
+                        const string_view &key)
+{
+	return get(std::nothrow, space, key, nullptr);
+}
+
+void
+ircd::m::ephemeral::get(const string_view &space,
+                        const string_view &key,
+                        const closure &closure)
+{
+	if(!get(std::nothrow, space, key, closure))
+		throw m::NOT_FOUND
+		{
+			"No ephemeral value for '%s' in '%s'",
+			key,
+			space,
+		};
+}
+
+bool
+ircd::m::ephemeral::get(std::nothrow_t,
+                        const string_view &space,
+                        const string_view &key_,
+                        const closure &closure)
+{
+	char buf[dbs::EPHEMERAL_KEY_MAX_SIZE];
+	const string_view key
+	{
+		dbs::ephemeral_key(buf, space, key_)
+	};
+
+	const auto entry
+	{
+		fetch(key)
+	};
+
+	if(!entry || entry->expires < now())
+		return false;
+
+	if(closure)
+		closure(entry->val);
+
+	return true;
+}
+
+bool
+ircd::m::ephemeral::for_each(const string_view &space,
+                             const closure_bool &closure)
+{
+	const auto now
+	{
+		ephemeral::now()
+	};
+
+	for(auto it(dbs::ephemeral.begin(space)); bool(it); ++it)
+	{
+		const auto &[space_, key]
+		{
+			dbs::ephemeral_key(it->first)
+		};
+
+		const string_view &value
+		{
+			it->second
+		};
+
+		if(unlikely(size(value) < sizeof(int64_t)))
+			continue;
+
+		const milliseconds expires
+		{
+			byte_view<int64_t>(value.substr(0, sizeof(int64_t)))
+		};
+
+		if(expires < now)
+			continue;
+
+		if(!closure(key, value.substr(sizeof(int64_t))))
+			return false;
+	}
+
+	return true;
+}
+
+//
+// internal
+//
+
+std::shared_ptr<const ircd::m::ephemeral::entry>
+ircd::m::ephemeral::fetch(const string_view &key)
+{
+	if(auto ret{find(key)})
+	{
+		++mem_hits;
+		return ret;
+	}
+
+	++mem_misses;
+	bool found;
+	std::string value
+	{
+		db::read(dbs::ephemeral, key, found)
+	};
+
+	if(!found || size(value) < sizeof(int64_t))
+		return {};
+
+	const milliseconds expires
+	{
+		byte_view<int64_t>(string_view(value).substr(0, sizeof(int64_t)))
+	};
+
+	value.erase(0, sizeof(int64_t));
+	auto ret
+	{
+		std::make_shared<const entry>(entry
+		{
+			expires, std::move(value)
+		})
+	};
+
+	// Another context may have set a newer value while this one was reading
+	// the database; that value wins.
+	if(auto newer{find(key)})
+		return newer;
+
+	remember(key, ret);
+	return ret;
+}
+
+std::shared_ptr<const ircd::m::ephemeral::entry>
+ircd::m::ephemeral::find(const string_view &key)
+{
+	const auto it(mem.find(key));
+	return it != end(mem)?
+		it->second:
+		nullptr;
+}
+
+/// Place the value in memory. To make room the value closest to expiring
+/// goes, which is any expired value first.
+void
+ircd::m::ephemeral::remember(const string_view &key,
+                             std::shared_ptr<const entry> ent)
+{
+	if(!mem_max)
+		return;
+
+	auto it(mem.lower_bound(key));
+	if(it != end(mem) && it->first == key)
+	{
+		mem_expiry.erase({it->second->expires, it->first});
+		mem_expiry.emplace(ent->expires, it->first);
+		it->second = std::move(ent);
+		return;
+	}
+
+	while(mem.size() >= size_t(mem_max) && !mem_expiry.empty())
+		forget(begin(mem_expiry)->second);
+
+	it = mem.emplace_hint(it, key, std::move(ent));
+	mem_expiry.emplace(it->second->expires, it->first);
+}
+
+void
+ircd::m::ephemeral::forget(const string_view &key)
+{
+	const auto it(mem.find(key));
+	if(it == end(mem))
+		return;
+
+	mem_expiry.erase({it->second->expires, it->first});
+	mem.erase(it);
+}
+
+ircd::milliseconds
+ircd::m::ephemeral::now()
+{
+	return duration_cast<milliseconds>
+	(
+		ircd::now<system_point>().time_since_epoch()
+	);
+}
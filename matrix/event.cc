@@ -11,6 +11,7 @@
 namespace ircd::m
 {
 	static json::object make_hashes(const mutable_buffer &out, const sha256::buf &hash);
+	static string_view canonical(const mutable_buffer &out, const json::object &);
 }
 
 /// The maximum size of an event we will create. This may also be used in
@@ -62,41 +63,66 @@ ircd::m::make_hashes(const mutable_buffer &out,
 	return json::stringify(mutable_buffer{out}, hashes);
 }
 
+/// Canonical JSON of the object written into the buffer for the signature
+/// functions, which need the whole message.
+ircd::string_view
+ircd::m::canonical(const mutable_buffer &buf,
+                   const json::object &object)
+{
+	mutable_buffer out{buf};
+	json::canonical
+	{
+		object, [&buf, &out](const const_buffer &in)
+		{
+			if(unlikely(size(in) > size(out)))
+				throw m::BAD_JSON
+				{
+					"Canonical JSON exceeds %zu bytes.", size(buf)
+				};
+
+			consume(out, copy(out, in));
+		}
+	};
+
+	return string_view
+	{
+		data(buf), data(out)
+	};
+}
+
 ircd::sha256::buf
 ircd::m::event::hash(const json::object &event)
 try
 {
-	static const size_t iov_max{json::iov::max_size};
-	thread_local std::array<json::object::member, iov_max> member;
-
-	size_t i(0);
-	for(const auto &m : event)
+	static const json::canonical::filter filter{[]
+	(const string_view &name)
 	{
-		if(m.first == "signatures" ||
-		   m.first == "hashes" ||
-		   m.first == "unsigned" ||
-		   m.first == "age_ts" ||
-		   m.first == "outlier" ||
-		   m.first == "destinations")
-			continue;
-
-		member.at(i++) = m;
-	}
+		return true
+		&& name != "signatures"
+		&& name != "hashes"
+		&& name != "unsigned"
+		&& name != "age_ts"
+		&& name != "outlier"
+		&& name != "destinations";
+	}};
 
-	thread_local char buf[event::MAX_SIZE];
-	const string_view reimage
+	sha256 hash;
+	json::canonical
 	{
-		json::stringify(buf, member.data(), member.data() + i)
+		event, [&hash](const const_buffer &buf)
+		{
+			hash.update(buf);
+		},
+		filter
 	};
 
-	return sha256{reimage};
+	return hash;
 }
-catch(const std::out_of_range &e)
+catch(const json::print_error &e)
 {
 	throw m::BAD_JSON
 	{
-		"Object has more than %zu member properties.",
-		json::iov::max_size
+		"%s", e.what()
 	};
 }
 
@@ -372,11 +398,10 @@ ircd::ed25519::sig
 ircd::m::event::sign(const json::object &event,
                      const ed25519::sk &sk)
 {
-	//TODO: skip rewrite
 	thread_local char buf[event::MAX_SIZE];
 	const string_view preimage
 	{
-		stringify(buf, event)
+		canonical(buf, event)
 	};
 
 	return sign(preimage, sk);
@@ -529,7 +554,7 @@ ircd::m::event::verify(const json::object &event,
 	thread_local char buf[event::MAX_SIZE];
 	const string_view preimage
 	{
-		stringify(buf, event)
+		canonical(buf, event)
 	};
 
 	return pk.verify(preimage, sig);
@@ -844,7 +869,7 @@ ircd::m::make_id(const event &event,
 	{
 		const id::event ret
 		{
-			buf, b64tob64url(readable, b64encode_unpadded(readable, hash)), at<"origin"_>(event)
+			buf, b64urlencode_unpadded(readable, hash), at<"origin"_>(event)
 		};
 
 		buf.assigned(ret);
@@ -863,7 +888,7 @@ ircd::m::make_id(const event &event,
 
 	const id::event ret
 	{
-		buf, b64tob64url(readable, b64encode_unpadded(readable, hash)), string_view{}
+		buf, b64urlencode_unpadded(readable, hash), string_view{}
 	};
 
 	buf.assigned(ret);
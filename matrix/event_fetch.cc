@@ -253,21 +253,28 @@ try
 	};
 
 	assert(_json.valid(key));
-	const json::object source
+	const string_view val
 	{
 		_json.val()
 	};
 
+	const json::object source
+	{
+		dbs::event_json_source(val)
+	};
+
 	assert(!empty(source));
-	const bool source_event_id
+	const string_view source_event_id
 	{
-		!event_id_buf && source.has("event_id")
+		!event_id_buf?
+			dbs::event_json_get(val, "event_id"):
+			string_view{}
 	};
 
 	const auto event_id
 	{
 		source_event_id?
-			id(json::string(source.at("event_id"))):
+			id(json::string(source_event_id)):
 		event_id_buf?
 			id(event_id_buf):
 			m::event_id(event_idx, event_id_buf, std::nothrow)
@@ -275,7 +282,12 @@ try
 
 	assert(fopts);
 	assert(event_id);
-	event =
+	if(dbs::event_json_packed(val))
+	{
+		dbs::event_json_unpack(event, val, event::keys{fopts->keys});
+		event.event_id = event_id;
+	}
+	else event =
 	{
 		source, event_id, event::keys{fopts->keys}
 	};
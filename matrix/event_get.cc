@@ -206,11 +206,11 @@ ircd::m::get(std::nothrow_t,
 	// fall back to fetching the full JSON and closing over the property.
 	bool ret{false};
 	dbs::event_json(column_key, std::nothrow, [&closure, &key, &ret]
-	(const json::object &event)
+	(const string_view &val)
 	{
 		string_view value
 		{
-			event[key]
+			dbs::event_json_get(val, key)
 		};
 
 		if(!value)
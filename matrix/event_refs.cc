@@ -50,7 +50,7 @@ ircd::m::event::refs::rebuild()
 			byte_view<m::event::idx>(it->first)
 		};
 
-		std::string event{it->second};
+		std::string event{dbs::event_json_source(it->second)};
 		pool([&txn, &dock, &i, &j, event(std::move(event)), event_idx]
 		{
 			m::dbs::write_opts wopts;
@@ -116,7 +116,7 @@ ircd::m::events::dump__file(const string_view &filename)
 
 		const string_view source
 		{
-			it->second
+			dbs::event_json_source(it->second)
 		};
 
 		const auto remain
@@ -1517,52 +1517,25 @@ try
 		"well-known.matrix.server"
 	};
 
-	const m::room::id::buf room_id
+	// The store only presents values which haven't expired.
+	json::object content;
+	m::ephemeral::get(std::nothrow, type, origin, [&buf, &content]
+	(const string_view &value)
 	{
-		"dns", m::my_host()
-	};
-
-	const m::room room
-	{
-		room_id
-	};
-
-	const m::event::idx event_idx
-	{
-		room.get(std::nothrow, type, origin)
-	};
-
-	const milliseconds origin_server_ts
-	{
-		m::get<time_t>(std::nothrow, event_idx, "origin_server_ts", time_t(0))
-	};
-
-	const json::object content
-	{
-		origin_server_ts > 0ms?
-			m::get(std::nothrow, event_idx, "content", buf):
-			const_buffer{}
-	};
+		content = string_view
+		{
+			data(buf), copy(buf, value)
+		};
+	});
 
 	const json::string cached
 	{
 		content["m.server"]
 	};
 
-	const seconds ttl
-	{
-		content.get<time_t>("ttl", time_t(0))
-	};
-
-	const system_point expires
-	{
-		origin_server_ts + ttl
-	};
-
 	const bool expired
 	{
-		ircd::now<system_point>() > expires
-		|| empty(cached)
+		empty(cached)
 	};
 
 	// Crucial value that will provide us with a return string for this
@@ -1588,14 +1561,11 @@ try
 	// Branch on valid cache hit to return result.
 	if(!expired)
 	{
-		thread_local char tmbuf[48];
 		log::debug
 		{
-			well_known_log, "%s found in cache delegated to %s event_idx:%u expires %s",
+			well_known_log, "%s found in cache delegated to %s",
 			origin,
 			delegated,
-			event_idx,
-			timef(tmbuf, expires, localtime),
 		};
 
 		return delegated;
@@ -1612,24 +1582,24 @@ try
 			seconds(well_known_cache_default).count()
 	};
 
-	// Write our record to the cache room; note that this doesn't really
-	// match the format of other DNS records in this room since it's a bit
-	// simpler, but we don't share the ircd.dns.rr type prefix anyway.
-	const auto cache_id
+	// Write our record to the ephemeral store; the ttl is kept with it for
+	// reference since the store doesn't present it.
+	const json::strung value
 	{
-		m::send(room, m::me(), type, origin, json::members
+		json::members
 		{
 			{ "ttl",       cache_ttl  },
 			{ "m.server",  delegated  },
-		})
+		}
 	};
 
+	m::ephemeral::set(type, origin, value, seconds(cache_ttl));
 	log::debug
 	{
-		well_known_log, "%s caching delegation to %s to cache in %s",
+		well_known_log, "%s caching delegation to %s for %ld seconds",
 		origin,
 		delegated,
-		string_view{cache_id},
+		cache_ttl,
 	};
 
 	return delegated;
@@ -840,9 +840,11 @@ ircd::m::id::event::v4::v4(const mutable_buffer &out,
 	};
 
 	out[0] = '$';
-	string_view hashb64;
-	hashb64 = b64encode_unpadded(out + 1, hash);
-	hashb64 = b64tob64url(out + 1, hashb64);
+	const string_view hashb64
+	{
+		b64urlencode_unpadded(out + 1, hash)
+	};
+
 	return string_view
 	{
 		ircd::data(out), 1 + ircd::size(hashb64)
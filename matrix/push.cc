@@ -39,6 +39,7 @@ namespace ircd::m::push
 	static bool contains_user_mxid(const event &, const cond &, const match::opts &);
 	static bool room_member_count(const event &, const cond &, const match::opts &);
 	static bool event_match(const event &, const cond &, const match::opts &);
+	static string_view content(const event &, const match::opts &, const string_view &key);
 }
 
 decltype(ircd::m::push::match::cond_kind)
@@ -143,13 +144,22 @@ try
 		json::get(event, top, json::object{})
 	};
 
-	tokens(path, ".", token_view_bool{[&value]
+	bool indexed
+	{
+		top == "content" && opts.content
+	};
+
+	tokens(path, ".", token_view_bool{[&event, &opts, &value, &indexed]
 	(const string_view &key)
 	{
 		if(json::type(value, std::nothrow) != json::OBJECT)
 			return false;
 
-		value = json::object(value)[key];
+		value = indexed?
+			content(event, opts, key):
+			json::object(value)[key];
+
+		indexed = false;
 		if(likely(json::type(value, std::nothrow) != json::STRING))
 			return true;
 
@@ -193,14 +203,9 @@ try
 	if(unlikely(!opts.user_id))
 		return false;
 
-	const json::object &content
-	{
-		json::get<"content"_>(event)
-	};
-
 	const json::string &body
 	{
-		content["body"]
+		content(event, opts, "body")
 	};
 
 	if(has(body, opts.user_id))
@@ -208,7 +213,7 @@ try
 
 	const json::string &formatted_body
 	{
-		content["formatted_body"]
+		content(event, opts, "formatted_body")
 	};
 
 	if(has(formatted_body, opts.user_id))
@@ -272,14 +277,9 @@ try
 {
 	assert(json::get<"kind"_>(cond) == "contains_display_name");
 
-	const json::object &content
-	{
-		json::get<"content"_>(event)
-	};
-
 	const json::string &body
 	{
-		content["body"]
+		content(event, opts, "body")
 	};
 
 	if(!body)
@@ -507,6 +507,23 @@ ircd::m::push::unknown_condition_kind(const event &event,
 	return false;
 }
 
+ircd::string_view
+ircd::m::push::content(const event &event,
+                       const match::opts &opts,
+                       const string_view &key)
+{
+	const json::object &content
+	{
+		json::get<"content"_>(event)
+	};
+
+	if(!opts.content)
+		return content[key];
+
+	assert(opts.content->object.data() == content.data());
+	return (*opts.content)[key];
+}
+
 //
 // rule
 //
@@ -19,6 +19,39 @@ namespace ircd::m
 	static void cache_warm_origin(const resource::request &);
 }
 
+/// Token buckets for RATE_LIMITED methods. A bucket is kept for each method
+/// and requester, hashed together into one key. The requester is the user of
+/// an access token, otherwise the origin of a federation request, otherwise
+/// the remote IP; requests by a user are not limited by IP because many
+/// users can share one address (i.e. a reverse proxy or a bridge). Behind a
+/// reverse proxy every remote IP is the proxy's, so its address has to be
+/// listed in ircd.m.ratelimit.proxies for the forwarded address to be used.
+namespace ircd::m::ratelimit
+{
+	struct bucket
+	{
+		float tokens;
+		steady_point last;                   // last refill
+		steady_point full;                   // refilled to the burst by
+	};
+
+	extern conf::item<bool> enable;
+	extern conf::item<float> rate;
+	extern conf::item<size_t> burst;
+	extern conf::item<seconds> sweep_interval;
+	extern conf::item<std::string> proxies;
+	extern stats::item limited;
+
+	static std::unordered_map<uint64_t, bucket> buckets;
+	extern context sweeper_context;
+	extern const run::changed sweeper_terminate;
+
+	static void sweep(const steady_point &now) noexcept;
+	static void sweeper();
+	static net::ipaddr remote(const client &, const resource::request &);
+	static milliseconds take(const resource::method &, const string_view &scope, const string_view &requester);
+}
+
 decltype(ircd::m::cache_warmup_time)
 ircd::m::cache_warmup_time
 {
@@ -40,6 +73,56 @@ ircd::m::x_matrix_verify_destination
 	{ "default",  true                                 },
 };
 
+decltype(ircd::m::ratelimit::enable)
+ircd::m::ratelimit::enable
+{
+	{ "name",     "ircd.m.ratelimit.enable" },
+	{ "default",  true                      },
+};
+
+decltype(ircd::m::ratelimit::rate)
+ircd::m::ratelimit::rate
+{
+	{ "name",     "ircd.m.ratelimit.rate" },
+	{ "default",  5.0                     },
+	{ "help",     "Default requests per second for a RATE_LIMITED method." },
+};
+
+decltype(ircd::m::ratelimit::burst)
+ircd::m::ratelimit::burst
+{
+	{ "name",     "ircd.m.ratelimit.burst" },
+	{ "default",  30L                      },
+	{ "help",     "Default burst of requests for a RATE_LIMITED method." },
+};
+
+decltype(ircd::m::ratelimit::sweep_interval)
+ircd::m::ratelimit::sweep_interval
+{
+	{ "name",     "ircd.m.ratelimit.sweep_interval" },
+	{ "default",  15L                               },
+};
+
+decltype(ircd::m::ratelimit::proxies)
+ircd::m::ratelimit::proxies
+{
+	{ "name",     "ircd.m.ratelimit.proxies" },
+	{ "default",  ""                         },
+	{ "help",
+	R"(
+	Space-separated addresses of reverse proxies trusted to append the
+	client's address to X-Forwarded-For; unauthenticated requests through
+	them are limited by that address rather than the proxy's.
+	)"},
+};
+
+decltype(ircd::m::ratelimit::limited)
+ircd::m::ratelimit::limited
+{
+	{ "name", "ircd.m.ratelimit.limited" },
+	{ "desc", "Number of requests refused with M_LIMIT_EXCEEDED." },
+};
+
 //
 // m::resource::method
 //
@@ -77,6 +160,18 @@ try
 		*this, client, request_
 	};
 
+	if(opts->flags & RATE_LIMITED)
+		rate_limit(client, request);
+
+	// JSON in Matrix is UTF-8; content which isn't is refused before any
+	// handler reads it.
+	if(startswith(request.head.content_type, "application/json"))
+		if(unlikely(!json::valid_utf8(request.content)))
+			throw json::parse_error
+			{
+				"Content is not valid UTF-8."
+			};
+
 	if(request.origin)
 	{
 		// If we have an error cached from previously not being able to
@@ -322,6 +417,243 @@ catch(const std::exception &e)
 	};
 }
 
+/// Takes a token from the requester's bucket for the method or throws
+/// M_LIMIT_EXCEEDED with the time until one is available. This is called
+/// for RATE_LIMITED methods before the handler; a handler serving several
+/// paths may instead call it for some of them, each scope with its own
+/// bucket.
+void
+ircd::m::resource::method::rate_limit(const client &client,
+                                      const request &request,
+                                      const string_view &scope)
+const
+{
+	if(!ratelimit::enable)
+		return;
+
+	// The address is keyed in its binary form.
+	const auto ip
+	{
+		host6(ratelimit::remote(client, request))
+	};
+
+	const string_view requester
+	{
+		request.user_id?
+			string_view{request.user_id}:
+		request.origin?
+			request.origin:
+			string_view{reinterpret_cast<const char *>(&ip), sizeof(ip)}
+	};
+
+	const auto retry_after
+	{
+		ratelimit::take(*this, scope, requester)
+	};
+
+	if(likely(retry_after == 0ms))
+		return;
+
+	++ratelimit::limited;
+	log::dwarning
+	{
+		resource::log, "%s rate limited %s `%s' %s %s for %ld ms",
+		client.loghead(),
+		name,
+		resource->path,
+		scope,
+		request.user_id?
+			string_view{request.user_id}:
+			request.origin,
+		retry_after.count(),
+	};
+
+	char secbuf[24];
+	const http::header headers[]
+	{
+		{ "Retry-After", lex_cast((retry_after.count() + 999) / 1000, secbuf) },
+	};
+
+	// The error's headers are amended on the way out; it can't be copied.
+	try
+	{
+		throw m::error
+		{
+			http::TOO_MANY_REQUESTS, json::members
+			{
+				{ "errcode",         "M_LIMIT_EXCEEDED"       },
+				{ "error",           "Too many requests."     },
+				{ "retry_after_ms",  retry_after.count()      },
+			}
+		};
+	}
+	catch(m::error &e)
+	{
+		e.headers += http::strung(headers);
+		throw;
+	}
+}
+
+/// Returns zero after taking a token, otherwise the time until a token is
+/// available. A bucket refilled to its burst is the same as no bucket; these
+/// are swept out periodically so the map only holds recent requesters.
+ircd::milliseconds
+ircd::m::ratelimit::take(const resource::method &method,
+                         const string_view &scope,
+                         const string_view &requester)
+{
+	const float rate
+	{
+		method.opts->rate > 0.0f?
+			method.opts->rate:
+			float(ratelimit::rate)
+	};
+
+	const float burst
+	{
+		method.opts->burst?
+			float(method.opts->burst):
+			float(size_t(ratelimit::burst))
+	};
+
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	const uint64_t key
+	{
+		std::hash<string_view>{}(requester) ^
+		((uintptr_t(&method) ^ std::hash<string_view>{}(scope)) * 0x9e3779b97f4a7c15UL)
+	};
+
+	auto &b
+	{
+		buckets.try_emplace(key, bucket{burst, now, now}).first->second
+	};
+
+	const float elapsed
+	{
+		duration_cast<microseconds>(now - b.last).count() / 1e6f
+	};
+
+	b.tokens = std::min(burst, b.tokens + elapsed * rate);
+	b.last = now;
+	if(b.tokens >= 1.0f)
+	{
+		b.tokens -= 1.0f;
+		b.full = now + microseconds(long((burst - b.tokens) / rate * 1e6f));
+		return 0ms;
+	}
+
+	return milliseconds
+	{
+		long(std::ceil((1.0f - b.tokens) / rate * 1e3f))
+	};
+}
+
+/// The requester's address, which is the remote's unless the remote is a
+/// trusted proxy: then it's the last X-Forwarded-For entry, the one the
+/// proxy appended; entries before it are whatever the client claimed.
+ircd::net::ipaddr
+ircd::m::ratelimit::remote(const client &client,
+                           const resource::request &request)
+try
+{
+	const net::ipaddr ip
+	{
+		host6(ircd::remote(client))
+	};
+
+	if(likely(empty(string_view(proxies))))
+		return ip;
+
+	bool proxied {false};
+	tokens(string_view(proxies), ' ', [&ip, &proxied]
+	(const string_view &proxy)
+	{
+		proxied |= net::ipaddr(proxy) == ip;
+	});
+
+	const string_view forwarded
+	{
+		http::headers(request.head.headers)["X-Forwarded-For"]
+	};
+
+	if(!proxied || !forwarded)
+		return ip;
+
+	const string_view last
+	{
+		strip(rsplit(forwarded, ',').second?: forwarded, ' ')
+	};
+
+	return net::ipaddr
+	{
+		last
+	};
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		resource::log, "%s rate limit requester :%s",
+		client.loghead(),
+		e.what(),
+	};
+
+	return net::ipaddr
+	{
+		host6(ircd::remote(client))
+	};
+}
+
+/// Buckets are swept from their own context rather than by a request, so a
+/// large map isn't walked on the request path.
+decltype(ircd::m::ratelimit::sweeper_context)
+ircd::m::ratelimit::sweeper_context
+{
+	"m.ratelimit",
+	128_KiB,
+	context::POST,
+	sweeper
+};
+
+decltype(ircd::m::ratelimit::sweeper_terminate)
+ircd::m::ratelimit::sweeper_terminate
+{
+	run::level::QUIT, []
+	{
+		sweeper_context.terminate();
+	}
+};
+
+void
+ircd::m::ratelimit::sweeper()
+try
+{
+	while(1)
+	{
+		ctx::sleep(seconds(sweep_interval));
+		sweep(ircd::now<steady_point>());
+	}
+}
+catch(const ctx::terminated &)
+{
+	return;
+}
+
+void
+ircd::m::ratelimit::sweep(const steady_point &now)
+noexcept
+{
+	for(auto it(begin(buckets)); it != end(buckets); )
+		if(it->second.full <= now)
+			it = buckets.erase(it);
+		else
+			++it;
+}
+
 /// We can smoothly warmup some memory caches after daemon startup as the
 /// requests trickle in from remote servers. This function is invoked after
 /// a remote contacts and reveals its identity with the X-Matrix verification.
@@ -433,3 +433,979 @@ const
 {
 	return this->instance_multimap::it->first;
 }
+
+//
+// cache
+//
+
+namespace ircd::m::sync::cache
+{
+	struct entry;
+	struct room;
+
+	static bool splice(data &, const string_view &json);
+	static std::pair<bool, std::string> compose(data &, const closure &);
+	static room *find(const m::room::id &);
+	static entry *find(room &, const string_view &key);
+	static size_t invalidate(room &);
+	static void evict();
+	static void handle_notify(const m::event &, vm::eval &);
+
+	extern std::map<std::string, room, std::less<>> rooms;
+	extern ctx::dock dock;
+	extern uint64_t ticks;
+	extern hookfn<vm::eval &> notified;
+}
+
+struct ircd::m::sync::cache::entry
+{
+	std::string key;
+	std::shared_ptr<const std::string> json;
+	bool ret {false};
+	bool pending {true};
+	bool discard {false};
+};
+
+struct ircd::m::sync::cache::room
+{
+	event::idx head {0};
+	uint64_t tick {0};
+	size_t bytes {0};
+	std::list<entry> fragments;
+};
+
+decltype(ircd::m::sync::cache::enable)
+ircd::m::sync::cache::enable
+{
+	{ "name",     "ircd.m.sync.cache.enable" },
+	{ "default",  true                       },
+};
+
+decltype(ircd::m::sync::cache::max_bytes)
+ircd::m::sync::cache::max_bytes
+{
+	{ "name",     "ircd.m.sync.cache.max_bytes" },
+	{ "default",  long(128_MiB)                 },
+};
+
+decltype(ircd::m::sync::cache::max_fragment)
+ircd::m::sync::cache::max_fragment
+{
+	{ "name",     "ircd.m.sync.cache.max_fragment" },
+	{ "default",  long(4_MiB)                      },
+};
+
+decltype(ircd::m::sync::cache::hits)
+ircd::m::sync::cache::hits
+{
+	{ "name", "ircd.m.sync.cache.hits"                                       },
+	{ "desc", "Number of room fragments spliced from the sync cache"         },
+};
+
+decltype(ircd::m::sync::cache::misses)
+ircd::m::sync::cache::misses
+{
+	{ "name", "ircd.m.sync.cache.misses"                                     },
+	{ "desc", "Number of room fragments composed for the sync cache"         },
+};
+
+decltype(ircd::m::sync::cache::waits)
+ircd::m::sync::cache::waits
+{
+	{ "name", "ircd.m.sync.cache.waits"                                      },
+	{ "desc", "Number of times a request waited for another to compose"      },
+};
+
+decltype(ircd::m::sync::cache::bytes)
+ircd::m::sync::cache::bytes
+{
+	{ "name", "ircd.m.sync.cache.bytes"                                      },
+	{ "desc", "Total size of the room fragments held by the sync cache"      },
+};
+
+decltype(ircd::m::sync::cache::rooms)
+ircd::m::sync::cache::rooms;
+
+decltype(ircd::m::sync::cache::dock)
+ircd::m::sync::cache::dock;
+
+decltype(ircd::m::sync::cache::ticks)
+ircd::m::sync::cache::ticks;
+
+decltype(ircd::m::sync::cache::notified)
+ircd::m::sync::cache::notified
+{
+	handle_notify,
+	{
+		{ "_site",  "vm.notify" },
+	}
+};
+
+/// Compose the members of the room item object which is open on the stack
+/// by calling the closure, or splice them from the cache. The closure is
+/// only called on a miss, with data.out redirected to a private stack; it
+/// must not rely on anything in data which is not reflected by the key.
+/// Another request composing the same key concurrently is waited on rather
+/// than duplicated. The return value is that of the closure.
+bool
+ircd::m::sync::cache::fragment(data &data,
+                               const string_view &name,
+                               const string_view &vclass,
+                               const closure &closure)
+{
+	if(!enable || data.phased || !data.room || !data.room_head)
+		return closure(data);
+
+	char keybuf[384];
+	const string_view key
+	{
+		fmt::sprintf
+		{
+			keybuf, "%s %s %zu",
+			name,
+			vclass,
+			std::hash<string_view>{}(data.filter_buf),
+		}
+	};
+
+	const auto &room_id
+	{
+		data.room->room_id
+	};
+
+	const auto fragment_ready{[&room_id, &key]
+	{
+		auto *const room(find(room_id));
+		auto *const fragment(room? find(*room, key) : nullptr);
+		return !fragment || !fragment->pending;
+	}};
+
+	// This request has an older view of the room than the cache; we can't
+	// use it and we're not going to invalidate it.
+	auto *room(find(room_id));
+	if(room && room->head > data.room_head)
+		return closure(data);
+
+	if(room && room->head < data.room_head)
+	{
+		invalidate(*room);
+		room->head = data.room_head;
+	}
+
+	auto *fragment(room? find(*room, key) : nullptr);
+	if(room)
+		room->tick = ++ticks;
+
+	if(fragment && fragment->pending)
+	{
+		++waits;
+		dock.wait(fragment_ready);
+		return cache::fragment(data, name, vclass, closure);
+	}
+
+	if(fragment)
+	{
+		// The entry may be dropped while the splice yields to flush.
+		const auto json(fragment->json);
+		++hits;
+		return fragment->ret?
+			splice(data, *json):
+			false;
+	}
+
+	// The room's entry is made here for the pending fragment other requests
+	// wait on; it's removed again below if nothing ends up stored.
+	++misses;
+	if(!room)
+	{
+		room = &rooms.emplace(std::string(room_id), cache::room{}).first->second;
+		room->head = data.room_head;
+		room->tick = ++ticks;
+	}
+
+	room->fragments.emplace_back();
+	room->fragments.back().key = key;
+	const unwind done{[&room_id, &key]
+	{
+		const auto it(rooms.find(room_id));
+		auto *const room(it != end(rooms)? &it->second : nullptr);
+		auto *const fragment(room? find(*room, key) : nullptr);
+		if(fragment && fragment->pending)
+			room->fragments.remove_if([&key](const auto &fragment)
+			{
+				return fragment.pending && fragment.key == key;
+			});
+
+		if(room && room->fragments.empty())
+			rooms.erase(it);
+
+		dock.notify_all();
+	}};
+
+	auto [ret, composed]
+	{
+		compose(data, closure)
+	};
+
+	const auto json
+	{
+		std::make_shared<const std::string>(std::move(composed))
+	};
+
+	room = find(room_id);
+	fragment = room? find(*room, key) : nullptr;
+	const bool store
+	{
+		fragment
+		&& fragment->pending
+		&& !fragment->discard
+		&& room->head == data.room_head
+		&& json->size() <= size_t(max_fragment)
+	};
+
+	if(store)
+	{
+		room->bytes += json->size();
+		bytes += json->size();
+		fragment->ret = ret;
+		fragment->json = json;
+		fragment->pending = false;
+		evict();
+	}
+
+	return ret?
+		splice(data, *json):
+		false;
+}
+
+size_t
+ircd::m::sync::cache::clear()
+{
+	size_t ret(0);
+	for(auto &[room_id, room] : rooms)
+		ret += invalidate(room);
+
+	return ret;
+}
+
+size_t
+ircd::m::sync::cache::clear(const m::room::id &room_id)
+{
+	auto *const room
+	{
+		find(room_id)
+	};
+
+	return room?
+		invalidate(*room):
+		0UL;
+}
+
+/// Compose the fragment with the closure into a private stack, flushing it
+/// into a string as it grows.
+std::pair<bool, std::string>
+ircd::m::sync::cache::compose(data &data,
+                              const closure &closure)
+{
+	std::string ret;
+	const auto flusher{[&ret]
+	(const const_buffer &buf)
+	{
+		ret.append(buffer::data(buf), buffer::size(buf));
+		return buf;
+	}};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		// must be at least worst-case size of m::event plus some.
+		256_KiB
+	};
+
+	json::stack out
+	{
+		buf, flusher, 64_KiB
+	};
+
+	const scope_restore their_out
+	{
+		data.out, &out
+	};
+
+	bool ok;
+	{
+		json::stack::object top
+		{
+			out
+		};
+
+		ok = closure(data);
+	}
+
+	out.flush(true);
+	return
+	{
+		ok, std::move(ret)
+	};
+}
+
+/// Append the members of the cached fragment to the object open on the
+/// request's stack.
+bool
+ircd::m::sync::cache::splice(data &data,
+                             const string_view &fragment)
+{
+	assert(data.out);
+	for(const auto &[name, value] : json::object{fragment})
+		json::stack::member
+		{
+			*data.out, name, json::value{value}
+		};
+
+	return true;
+}
+
+/// Drop rooms least recently used until the cache is under three quarters
+/// of its maximum. Rooms with a fragment being composed are not dropped.
+void
+ircd::m::sync::cache::evict()
+{
+	if(ircd::stats::get(bytes) <= long(max_bytes))
+		return;
+
+	std::vector<std::pair<uint64_t, decltype(rooms)::iterator>> order;
+	order.reserve(rooms.size());
+	for(auto it(begin(rooms)); it != end(rooms); ++it)
+		order.emplace_back(it->second.tick, it);
+
+	std::sort(begin(order), end(order), []
+	(const auto &a, const auto &b)
+	{
+		return a.first < b.first;
+	});
+
+	for(const auto &[tick, it] : order)
+	{
+		if(ircd::stats::get(bytes) <= long(max_bytes) / 4 * 3)
+			break;
+
+		auto &room(it->second);
+		invalidate(room);
+		if(room.fragments.empty())
+			rooms.erase(it);
+	}
+}
+
+/// Drop the fragments of the room; any being composed will be discarded
+/// by their composer.
+size_t
+ircd::m::sync::cache::invalidate(room &room)
+{
+	size_t ret(0);
+	auto it(begin(room.fragments));
+	while(it != end(room.fragments))
+	{
+		if(it->pending)
+		{
+			it->discard = true;
+			++it;
+			continue;
+		}
+
+		it = room.fragments.erase(it);
+		++ret;
+	}
+
+	bytes -= room.bytes;
+	room.bytes = 0;
+	return ret;
+}
+
+ircd::m::sync::cache::room *
+ircd::m::sync::cache::find(const m::room::id &room_id)
+{
+	const auto it
+	{
+		rooms.find(room_id)
+	};
+
+	return it != end(rooms)?
+		&it->second:
+		nullptr;
+}
+
+ircd::m::sync::cache::entry *
+ircd::m::sync::cache::find(room &room,
+                           const string_view &key)
+{
+	const auto it
+	{
+		std::find_if(begin(room.fragments), end(room.fragments), [&key]
+		(const auto &fragment)
+		{
+			return fragment.key == key;
+		})
+	};
+
+	return it != end(room.fragments)?
+		&(*it):
+		nullptr;
+}
+
+/// The head of the room moves with every event, so the fragments are
+/// dropped here rather than waiting for a request to find them stale.
+void
+ircd::m::sync::cache::handle_notify(const m::event &event,
+                                    vm::eval &eval)
+{
+	const auto &room_id
+	{
+		json::get<"room_id"_>(event)
+	};
+
+	if(!room_id)
+		return;
+
+	const auto it
+	{
+		rooms.find(room_id)
+	};
+
+	if(it == end(rooms))
+		return;
+
+	auto &room(it->second);
+	invalidate(room);
+	room.head = 0;
+	if(room.fragments.empty())
+		rooms.erase(it);
+}
+
+//
+// members
+//
+
+namespace ircd::m::sync::members
+{
+	struct device;
+
+	static string_view make_key(const mutable_buffer &, const user::id &, const string_view &);
+	static void evict();
+
+	extern std::map<std::string, device, std::less<>> devices;
+	extern uint64_t ticks;
+}
+
+struct ircd::m::sync::members::device
+{
+	uint64_t tick {0};
+	std::set<event::idx> idx;
+	std::deque<event::idx> order;
+};
+
+decltype(ircd::m::sync::members::max_devices)
+ircd::m::sync::members::max_devices
+{
+	{ "name",     "ircd.m.sync.members.max_devices" },
+	{ "default",  65536L                            },
+};
+
+decltype(ircd::m::sync::members::max_members)
+ircd::m::sync::members::max_members
+{
+	{ "name",     "ircd.m.sync.members.max_members" },
+	{ "default",  16384L                            },
+};
+
+decltype(ircd::m::sync::members::devices)
+ircd::m::sync::members::devices;
+
+decltype(ircd::m::sync::members::ticks)
+ircd::m::sync::members::ticks;
+
+size_t
+ircd::m::sync::members::reset(const user::id &user_id,
+                              const string_view &device_id)
+{
+	char buf[512];
+	const auto it
+	{
+		devices.find(make_key(buf, user_id, device_id))
+	};
+
+	if(it == end(devices))
+		return 0;
+
+	const size_t ret
+	{
+		it->second.idx.size()
+	};
+
+	devices.erase(it);
+	return ret;
+}
+
+/// Record that the member event was sent to the device. Returns false if
+/// it was already recorded.
+bool
+ircd::m::sync::members::mark(const user::id &user_id,
+                             const string_view &device_id,
+                             const event::idx &event_idx)
+{
+	if(!event_idx)
+		return false;
+
+	char buf[512];
+	const auto key
+	{
+		make_key(buf, user_id, device_id)
+	};
+
+	auto it
+	{
+		devices.lower_bound(key)
+	};
+
+	if(it == end(devices) || it->first != key)
+	{
+		it = devices.emplace_hint(it, std::string(key), device{++ticks});
+		evict();
+		it = devices.find(key);
+		assert(it != end(devices));
+	}
+
+	auto &device(it->second);
+	device.tick = ++ticks;
+	if(!device.idx.emplace(event_idx).second)
+		return false;
+
+	device.order.emplace_back(event_idx);
+	while(device.order.size() > size_t(max_members))
+	{
+		device.idx.erase(device.order.front());
+		device.order.pop_front();
+	}
+
+	return true;
+}
+
+bool
+ircd::m::sync::members::sent(const user::id &user_id,
+                             const string_view &device_id,
+                             const event::idx &event_idx)
+{
+	char buf[512];
+	const auto it
+	{
+		devices.find(make_key(buf, user_id, device_id))
+	};
+
+	return it != end(devices) && it->second.idx.count(event_idx);
+}
+
+/// Drop the least recently used eighth of the devices when over the limit.
+void
+ircd::m::sync::members::evict()
+{
+	if(devices.size() <= size_t(max_devices))
+		return;
+
+	std::vector<uint64_t> ticks;
+	ticks.reserve(devices.size());
+	for(const auto &[key, device] : devices)
+		ticks.emplace_back(device.tick);
+
+	const auto nth
+	{
+		begin(ticks) + ticks.size() / 8
+	};
+
+	std::nth_element(begin(ticks), nth, end(ticks));
+	const auto &cutoff(*nth);
+	for(auto it(begin(devices)); it != end(devices); )
+		if(it->second.tick < cutoff)
+			it = devices.erase(it);
+		else
+			++it;
+}
+
+ircd::string_view
+ircd::m::sync::members::make_key(const mutable_buffer &buf,
+                                 const user::id &user_id,
+                                 const string_view &device_id)
+{
+	return fmt::sprintf
+	{
+		buf, "%s %s",
+		string_view{user_id},
+		device_id,
+	};
+}
+
+//
+// changed
+//
+
+namespace ircd::m::sync::changed
+{
+	struct entry;
+
+	static void bump(entry &, const string_view &room_id, const event::idx &);
+	static void bump(const string_view &room_id, const event::idx &);
+	static void build(entry &, const user::id &);
+	static void evict();
+	static void handle_notify(const m::event &, vm::eval &);
+
+	extern std::map<std::string, entry, std::less<>> users;
+	static size_t erase(const decltype(users)::iterator &);
+	extern std::multimap<std::string, entry *, std::less<>> rooms;
+	extern uint64_t ticks;
+	extern hookfn<vm::eval &> notified;
+}
+
+struct ircd::m::sync::changed::entry
+{
+	event::idx built {0};
+	uint64_t tick {0};
+	bool building {true};
+	std::map<std::string, event::idx, std::less<>> rooms;
+	std::multimap<event::idx, string_view> order;
+};
+
+decltype(ircd::m::sync::changed::enable)
+ircd::m::sync::changed::enable
+{
+	{ "name",     "ircd.m.sync.changed.enable" },
+	{ "default",  true                         },
+};
+
+decltype(ircd::m::sync::changed::max_users)
+ircd::m::sync::changed::max_users
+{
+	{ "name",     "ircd.m.sync.changed.max_users" },
+	{ "default",  16384L                          },
+};
+
+decltype(ircd::m::sync::changed::builds)
+ircd::m::sync::changed::builds
+{
+	{ "name", "ircd.m.sync.changed.builds"                                   },
+	{ "desc", "Number of times the changed-rooms index was built for a user" },
+};
+
+decltype(ircd::m::sync::changed::hits)
+ircd::m::sync::changed::hits
+{
+	{ "name", "ircd.m.sync.changed.hits"                                     },
+	{ "desc", "Number of polylog syncs answered by the changed-rooms index"  },
+};
+
+decltype(ircd::m::sync::changed::skipped)
+ircd::m::sync::changed::skipped
+{
+	{ "name", "ircd.m.sync.changed.skipped"                                  },
+	{ "desc", "Number of idle rooms not visited by polylog syncs"            },
+};
+
+decltype(ircd::m::sync::changed::users)
+ircd::m::sync::changed::users;
+
+decltype(ircd::m::sync::changed::rooms)
+ircd::m::sync::changed::rooms;
+
+decltype(ircd::m::sync::changed::ticks)
+ircd::m::sync::changed::ticks;
+
+decltype(ircd::m::sync::changed::notified)
+ircd::m::sync::changed::notified
+{
+	handle_notify,
+	{
+		{ "_site",  "vm.notify" },
+	}
+};
+
+/// Iterate the rooms of the user which changed at or after since, in the
+/// order they changed. The caller must have checked available() first; if
+/// the index can't answer for since, false is returned without iterating.
+/// The rooms are copied out of the index first, so the closure may yield.
+bool
+ircd::m::sync::changed::for_each(const user::id &user_id,
+                                 const event::idx &since,
+                                 const closure &closure)
+{
+	const auto it
+	{
+		users.find(user_id)
+	};
+
+	if(it == end(users))
+		return false;
+
+	auto &entry(it->second);
+	if(entry.building || since <= entry.built)
+		return false;
+
+	std::vector<std::pair<room::id::buf, event::idx>> changed;
+	const auto start
+	{
+		entry.order.lower_bound(since)
+	};
+
+	changed.reserve(std::distance(start, end(entry.order)));
+	for(auto it(start); it != end(entry.order); ++it)
+		changed.emplace_back(it->second, it->first);
+
+	entry.tick = ++ticks;
+	++hits;
+	skipped += entry.rooms.size() - changed.size();
+	for(const auto &[room_id, event_idx] : changed)
+		if(!closure(room_id, event_idx))
+			return false;
+
+	return true;
+}
+
+/// True if the index can answer for the user at since. If the user isn't
+/// indexed yet the index is built now, which yields, and which only allows
+/// answering for later since tokens; this request must fall back.
+bool
+ircd::m::sync::changed::available(const user::id &user_id,
+                                  const event::idx &since)
+{
+	if(!enable || !since)
+		return false;
+
+	auto it
+	{
+		users.lower_bound(user_id)
+	};
+
+	if(it != end(users) && it->first == user_id)
+		return !it->second.building && since > it->second.built;
+
+	it = users.emplace_hint(it, std::string(user_id), entry{});
+	auto &entry(it->second);
+	entry.tick = ++ticks;
+	build(entry, user_id);
+	evict();
+	return false;
+}
+
+size_t
+ircd::m::sync::changed::clear(const user::id &user_id)
+{
+	const auto it
+	{
+		users.find(user_id)
+	};
+
+	if(it == end(users) || it->second.building)
+		return 0;
+
+	return erase(it);
+}
+
+size_t
+ircd::m::sync::changed::clear()
+{
+	size_t ret(0);
+	for(auto it(begin(users)); it != end(users); )
+		if(!it->second.building)
+			ret += erase(it++);
+		else
+			++it;
+
+	return ret;
+}
+
+/// Drop the least recently used eighth of the users when over the limit.
+void
+ircd::m::sync::changed::evict()
+{
+	if(users.size() <= size_t(max_users))
+		return;
+
+	std::vector<uint64_t> ticks;
+	ticks.reserve(users.size());
+	for(const auto &[user_id, entry] : users)
+		ticks.emplace_back(entry.tick);
+
+	const auto nth
+	{
+		begin(ticks) + ticks.size() / 8
+	};
+
+	std::nth_element(begin(ticks), nth, end(ticks));
+	const auto &cutoff(*nth);
+	for(auto it(begin(users)); it != end(users); )
+		if(it->second.tick < cutoff && !it->second.building)
+			erase(it++);
+		else
+			++it;
+}
+
+/// Remove the user's entry and its references from the room index.
+size_t
+ircd::m::sync::changed::erase(const decltype(users)::iterator &it)
+{
+	auto &entry(it->second);
+	const size_t ret
+	{
+		entry.rooms.size()
+	};
+
+	for(const auto &[room_id, event_idx] : entry.rooms)
+	{
+		auto pit(rooms.equal_range(room_id));
+		for(; pit.first != pit.second; ++pit.first)
+			if(pit.first->second == &entry)
+			{
+				rooms.erase(pit.first);
+				break;
+			}
+	}
+
+	users.erase(it);
+	return ret;
+}
+
+/// Populate the entry with every room of the user at its head. Events which
+/// are notified while this yields are indexed by the hook as usual; anything
+/// at or before the retired sequence at the start is only reflected by the
+/// room heads, so the index doesn't answer for since tokens in that range.
+void
+ircd::m::sync::changed::build(entry &entry,
+                              const user::id &user_id)
+{
+	const unwind done{[&entry]
+	{
+		entry.building = false;
+	}};
+
+	entry.built = vm::sequence::retired;
+	const m::user::rooms user_rooms
+	{
+		user_id
+	};
+
+	user_rooms.for_each([&entry]
+	(const m::room &room, const string_view &membership)
+	{
+		bump(entry, room.room_id, m::head_idx(std::nothrow, room));
+	});
+
+	++builds;
+}
+
+void
+ircd::m::sync::changed::handle_notify(const m::event &event,
+                                      vm::eval &eval)
+{
+	if(users.empty())
+		return;
+
+	const auto &event_idx
+	{
+		vm::sequence::get(eval)
+	};
+
+	const auto &room_id(json::get<"room_id"_>(event));
+	const auto &type(json::get<"type"_>(event));
+	const auto &state_key(json::get<"state_key"_>(event));
+	const auto &sender(json::get<"sender"_>(event));
+	if(!room_id)
+		return;
+
+	// The room's own events are relevant to every user in the room.
+	bump(room_id, event_idx);
+
+	// Membership changes add rooms to the index of the target user.
+	if(type == "m.room.member" && state_key)
+	{
+		const auto it(users.find(state_key));
+		if(it != end(users))
+			bump(it->second, room_id, event_idx);
+	}
+
+	if(!sender || !m::user::room::is(room_id, sender))
+		return;
+
+	// Receipts are sent to the reader's user room; the state_key is the
+	// room which the receipt is for, and is relevant to all of its users.
+	if(type == "ircd.read" && state_key)
+		bump(state_key, event_idx);
+
+	// Room account data and tags are relevant only to the user themself;
+	// the type is suffixed with the room_id.
+	const auto prefix
+	{
+		split(type, '!').first
+	};
+
+	if(prefix != "ircd.account_data" && prefix != "ircd.room_tag")
+		return;
+
+	const string_view target
+	{
+		lstrip(type, prefix)
+	};
+
+	if(!valid(m::id::ROOM, target))
+		return;
+
+	const auto it(users.find(sender));
+	if(it != end(users))
+		bump(it->second, target, event_idx);
+}
+
+void
+ircd::m::sync::changed::bump(const string_view &room_id,
+                             const event::idx &event_idx)
+{
+	auto pit(rooms.equal_range(room_id));
+	for(; pit.first != pit.second; ++pit.first)
+		bump(*pit.first->second, room_id, event_idx);
+}
+
+void
+ircd::m::sync::changed::bump(entry &entry,
+                             const string_view &room_id,
+                             const event::idx &event_idx)
+{
+	auto it
+	{
+		entry.rooms.lower_bound(room_id)
+	};
+
+	const bool added
+	{
+		it == end(entry.rooms) || it->first != room_id
+	};
+
+	if(added)
+	{
+		it = entry.rooms.emplace_hint(it, std::string(room_id), event_idx);
+		rooms.emplace(std::string(room_id), &entry);
+	}
+
+	auto &last(it->second);
+	if(!added && last >= event_idx)
+		return;
+
+	// The order index refers to the key in the rooms map, which is stable.
+	const string_view key
+	{
+		it->first
+	};
+
+	auto pit(entry.order.equal_range(last));
+	for(; !added && pit.first != pit.second; ++pit.first)
+		if(pit.first->second.data() == key.data())
+		{
+			entry.order.erase(pit.first);
+			break;
+		}
+
+	last = event_idx;
+	entry.order.emplace(last, key);
+}
@@ -28,6 +28,13 @@ ircd::util::instance_list<ircd::m::vm::eval>::list
 	allocator
 };
 
+namespace ircd::m::vm
+{
+	static std::string pdu_preimages(const vector_view<m::event> &, const vector_view<const_buffer> &, const bool &all);
+	static std::vector<std::optional<sha256::buf>> pdu_hashes(const vector_view<m::event> &, const vector_view<const const_buffer> &);
+	static std::vector<bool> pdu_verify(const vector_view<m::event> &, const vector_view<const const_buffer> &);
+}
+
 decltype(ircd::m::vm::eval::id_ctr)
 ircd::m::vm::eval::id_ctr;
 
@@ -294,6 +301,41 @@ ircd::m::vm::eval::operator()(const vector_view<m::event> &events)
 	if(likely(opts->verify && opts->mfetch_keys))
 		mfetch_keys();
 
+	// The essential preimage of each pdu is made once here; the reference
+	// hashes and signatures are then computed in batches rather than as
+	// each pdu is executed. Without verification only the pdus lacking an
+	// event_id need one, which is usually none of them.
+	const bool preimaging
+	{
+		!opts->edu && (opts->verify || std::any_of(begin(events), end(events), []
+		(const m::event &event)
+		{
+			return !event.event_id;
+		}))
+	};
+
+	std::vector<const_buffer> preimage(preimaging? events.size() : 0);
+	const std::string preimages
+	{
+		preimaging?
+			pdu_preimages(events, preimage, opts->verify):
+			std::string{}
+	};
+
+	const auto hashes
+	{
+		preimaging?
+			pdu_hashes(events, preimage):
+			std::vector<std::optional<sha256::buf>>{}
+	};
+
+	const auto verified
+	{
+		preimaging && opts->verify?
+			pdu_verify(events, preimage):
+			std::vector<bool>{}
+	};
+
 	// Conduct each eval without letting any one exception ruin things for the
 	// others, including an interrupt. The only exception is a termination.
 	size_t ret(0);
@@ -304,6 +346,26 @@ ircd::m::vm::eval::operator()(const vector_view<m::event> &events)
 			*it
 		};
 
+		const auto &hash
+		{
+			!hashes.empty()?
+				hashes.at(std::distance(begin(events), it)):
+				std::optional<sha256::buf>{}
+		};
+
+		const scope_restore pdu_hash
+		{
+			this->pdu_hash, hash? std::addressof(*hash) : nullptr
+		};
+
+		const scope_restore pdu_verified
+		{
+			this->pdu_verified,
+			!verified.empty()?
+				bool(verified.at(std::distance(begin(events), it))):
+				false
+		};
+
 		const auto status
 		{
 			operator()(event)
@@ -415,6 +477,188 @@ const
 		};
 }
 
+/// The essential form of each pdu is stringified into the returned string;
+/// preimage[i] is its view for events[i]. A pdu which fails here is left
+/// empty for execute() to fail on its own. Unless `all` is set, only the
+/// pdus without an event_id are considered.
+std::string
+ircd::m::vm::pdu_preimages(const vector_view<m::event> &events,
+                           const vector_view<const_buffer> &preimage,
+                           const bool &all)
+{
+	std::string ret;
+	std::vector<size_t> pos(events.size(), -1UL);
+	for(size_t i(0); i < events.size(); ++i) try
+	{
+		if(!all && events.at(i).event_id)
+			continue;
+
+		thread_local char content_buf[event::MAX_SIZE];
+		const m::event essential
+		{
+			m::essential(events.at(i), content_buf)
+		};
+
+		thread_local char preimage_buf[event::MAX_SIZE];
+		const string_view preimage
+		{
+			json::stringify(preimage_buf, essential)
+		};
+
+		pos[i] = ret.size();
+		ret.append(preimage);
+	}
+	catch(const std::exception &e)
+	{
+		continue;
+	}
+
+	for(size_t i(0), end(ret.size()); i < events.size(); ++i)
+	{
+		const auto j(events.size() - i - 1);
+		if(pos[j] == -1UL)
+			continue;
+
+		preimage[j] = string_view
+		{
+			ret.data() + pos[j], end - pos[j]
+		};
+
+		end = pos[j];
+	}
+
+	return ret;
+}
+
+/// The reference hash of each pdu without an event_id, from which execute()
+/// makes its event_id.
+std::vector<std::optional<ircd::sha256::buf>>
+ircd::m::vm::pdu_hashes(const vector_view<m::event> &events,
+                        const vector_view<const const_buffer> &preimage)
+{
+	std::vector<size_t> idx;
+	std::vector<const_buffer> in;
+	for(size_t i(0); i < events.size(); ++i)
+		if(!events.at(i).event_id && !empty(preimage.at(i)))
+		{
+			idx.emplace_back(i);
+			in.emplace_back(preimage.at(i));
+		}
+
+	std::vector<std::optional<sha256::buf>> ret;
+	if(idx.empty())
+		return ret;
+
+	std::vector<sha256::buf> hash(idx.size());
+	std::vector<mutable_buffer> out(idx.size());
+	for(size_t j(0); j < idx.size(); ++j)
+		out[j] = mutable_buffer
+		{
+			reinterpret_cast<char *>(hash[j].data()), hash[j].size()
+		};
+
+	sha256::batch(out, in);
+	ret.resize(events.size());
+	for(size_t j(0); j < idx.size(); ++j)
+		ret[idx[j]] = hash[j];
+
+	return ret;
+}
+
+/// Whether each pdu is verified by a signature of its origin with a key
+/// already in the cache. The signatures are verified as one batch. A pdu
+/// which isn't verified here is verified by execute() as usual, which can
+/// fetch keys and report the failure.
+std::vector<bool>
+ircd::m::vm::pdu_verify(const vector_view<m::event> &events,
+                        const vector_view<const const_buffer> &preimage)
+{
+	std::vector<size_t> idx;
+	std::vector<ed25519::pk> pks;
+	std::vector<ed25519::sig> sigs;
+	pks.reserve(events.size());
+	sigs.reserve(events.size());
+	for(size_t i(0); i < events.size(); ++i) try
+	{
+		const m::event &event(events.at(i));
+		if(empty(preimage.at(i)))
+			continue;
+
+		const auto &origin
+		{
+			json::get<"origin"_>(event)
+		};
+
+		const json::object &origin_sigs
+		{
+			json::get<"signatures"_>(event).get(origin)
+		};
+
+		for(const auto &[keyid_, sig] : origin_sigs)
+		{
+			const json::string keyid(keyid_);
+			ed25519::pk pk;
+			const bool cached
+			{
+				m::keys::cache::get(origin, keyid, [&pk, &keyid]
+				(const json::object &keys)
+				{
+					const json::object &verify_keys
+					{
+						keys.at("verify_keys")
+					};
+
+					const json::object &verify_key
+					{
+						verify_keys.has(keyid)?
+							verify_keys.get(keyid):
+							json::object(keys["old_verify_keys"]).get(keyid)
+					};
+
+					b64decode(pk, json::string(verify_key.at("key")));
+				})
+			};
+
+			if(!cached)
+				continue;
+
+			idx.emplace_back(i);
+			pks.emplace_back(pk);
+			sigs.emplace_back([&sig](auto &buf)
+			{
+				b64decode(buf, json::string(sig));
+			});
+		}
+	}
+	catch(const std::exception &e)
+	{
+		continue;
+	}
+
+	std::vector<bool> ret;
+	if(idx.empty())
+		return ret;
+
+	std::vector<ed25519::verify_item> items(idx.size());
+	for(size_t j(0); j < idx.size(); ++j)
+		items[j] = ed25519::verify_item
+		{
+			&pks.at(j), preimage.at(idx[j]), &sigs.at(j)
+		};
+
+	std::unique_ptr<bool[]> valid
+	{
+		new bool[idx.size()]
+	};
+
+	ed25519::verify_batch(items, vector_view<bool>(valid.get(), idx.size()));
+	ret.resize(events.size(), false);
+	for(size_t j(0); j < idx.size(); ++j)
+		ret[idx[j]] = ret[idx[j]] || valid[j];
+
+	return ret;
+}
+
 const ircd::m::event *
 ircd::m::vm::eval::find_pdu(const event::id &event_id)
 {
@@ -186,7 +186,9 @@ try
 	// We have to set the event_id in the event instance if it didn't come
 	// with the event JSON.
 	if(!opts.edu && !event.event_id)
-		const_cast<m::event &>(event).event_id = eval.room_version == "3"?
+		const_cast<m::event &>(event).event_id = eval.pdu_hash?
+			make_id(event, eval.room_version == "3"? "3"_sv : "4"_sv, eval.event_id, *eval.pdu_hash):
+		eval.room_version == "3"?
 			event::id{event::id::v3{eval.event_id, event}}:
 			event::id{event::id::v4{eval.event_id, event}};
 
@@ -530,7 +532,7 @@ ircd::m::vm::execute_pdu(eval &eval,
 	if(likely(opts.access))
 		call_hook(access_hook, eval, event, eval);
 
-	if(likely(opts.verify) && !verify(event))
+	if(likely(opts.verify) && !eval.pdu_verified && !verify(event))
 		throw m::BAD_SIGNATURE
 		{
 			"Signature verification failed"
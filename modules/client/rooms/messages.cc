@@ -29,6 +29,13 @@ _append(json::stack::array &chunk,
         const m::user::room &user_room,
         const int64_t &room_depth);
 
+static void
+_append_members(json::stack::object &top,
+                const m::resource::request &,
+                const m::room_event_filter &,
+                const m::user::room &user_room,
+                const std::set<m::event::idx> &members);
+
 conf::item<size_t>
 max_filter_miss
 {
@@ -125,6 +132,14 @@ get__messages(client &client,
 		top, "chunk"
 	};
 
+	// When lazy-loading members, the member events of the senders in the
+	// chunk are collected here and included in the state of the response.
+	const bool lazy_load_members
+	{
+		json::get<"lazy_load_members"_>(filter)
+	};
+
+	std::set<m::event::idx> members;
 	size_t hit{0}, miss{0};
 	m::room::events it
 	{
@@ -153,9 +168,15 @@ get__messages(client &client,
 
 		hit += ok;
 		miss += !ok;
+		if(ok && lazy_load_members)
+			if(const auto member_idx{room.get(std::nothrow, "m.room.member", at<"sender"_>(event))})
+				members.emplace(member_idx);
 	}
 	chunk.~array();
 
+	if(lazy_load_members)
+		_append_members(top, request, filter, user_room, members);
+
 	if(it || page.dir == 'b')
 		json::stack::member
 		{
@@ -201,6 +222,48 @@ _append(json::stack::array &chunk,
 	return m::event::append(chunk, event, opts);
 }
 
+void
+_append_members(json::stack::object &top,
+                const m::resource::request &request,
+                const m::room_event_filter &filter,
+                const m::user::room &user_room,
+                const std::set<m::event::idx> &members)
+{
+	const m::device::id::buf device_id
+	{
+		m::device::access_token_to_id(request.access_token)
+	};
+
+	const bool redundant
+	{
+		json::get<"include_redundant_members"_>(filter)
+	};
+
+	json::stack::array state
+	{
+		top, "state"
+	};
+
+	m::event::fetch event;
+	m::event::append::opts opts;
+	opts.user_id = &user_room.user.user_id;
+	opts.user_room = &user_room;
+	opts.query_txnid = false;
+	opts.query_prev_state = false;
+	for(const auto &member_idx : members)
+	{
+		if(!redundant && m::sync::members::sent(request.user_id, device_id, member_idx))
+			continue;
+
+		if(!seek(event, member_idx, std::nothrow))
+			continue;
+
+		opts.event_idx = &member_idx;
+		if(m::event::append(state, event, opts))
+			m::sync::members::mark(request.user_id, device_id, member_idx);
+	}
+}
+
 // Client-Server 6.3.6 query parameters
 pagination_tokens::pagination_tokens(const m::resource::request &request)
 try
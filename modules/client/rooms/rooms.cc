@@ -38,6 +38,8 @@ rooms_resource_unstable
 	}
 };
 
+extern m::resource::method method_get;
+
 m::resource::response
 get_rooms(client &client,
           const m::resource::request &request)
@@ -58,6 +60,11 @@ get_rooms(client &client,
 		request.parv[1]
 	};
 
+	// Only the commands which page through the timeline are limited, each
+	// with its own bucket; the rest are cheap lookups a client makes often.
+	if(cmd == "messages" || cmd == "context" || cmd == "initialSync" || cmd == "relations")
+		method_get.rate_limit(client, request, cmd);
+
 	if(cmd == "event")
 		return get__event(client, request, room_id);
 
@@ -143,7 +150,8 @@ method_put
 {
 	rooms_resource, "PUT", put_rooms,
 	{
-		method_put.REQUIRES_AUTH
+		method_put.REQUIRES_AUTH |
+		method_put.INTERACTIVE
 	}
 };
 
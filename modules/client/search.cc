@@ -43,7 +43,8 @@ post_method
 {
 	search_resource, "POST", post__search,
 	{
-		post_method.REQUIRES_AUTH
+		post_method.REQUIRES_AUTH |
+		post_method.EXPENSIVE
 	}
 };
 
@@ -164,7 +164,9 @@ ircd::m::sync::method_get
 {
 	resource, "GET", handle_get,
 	{
-		method_get.REQUIRES_AUTH,
+		method_get.REQUIRES_AUTH |
+		method_get.RATE_LIMITED |
+		method_get.EXPENSIVE,
 		-1s,
 	}
 };
@@ -246,6 +248,10 @@ ircd::m::sync::handle_get(client &client,
 		range.first == 0UL
 	};
 
+	// An initial-sync starts the device over with no members lazy-loaded.
+	if(initial_sync)
+		m::sync::members::reset(request.user_id, device_id);
+
 	// Conditions for phased sync for this client
 	data.phased =
 	{
@@ -758,20 +764,109 @@ ircd::m::sync::linear_proffer_event_one(data &data)
 //
 // longpoll
 //
+// Clients parked in longpoll register a waiter which indexes the request by
+// the rooms it is interested in and by the user. When the vm notifies us of
+// an event, the event is routed through the index and only the waiters to
+// which it might be relevant are woken; everyone else stays asleep. A waiter
+// collects the event_idx of every event routed to it and only proffers those
+// to the linear handlers, rather than every event in the sequence.
+//
 
 namespace ircd::m::sync::longpoll
 {
+	struct waiter;
+	using index = std::multimap<size_t, waiter *>;
+
 	static bool polled(data &, const args &);
-	static int poll(data &);
+	static int poll(data &, waiter &);
+	static size_t route(index &, const string_view &key, const m::event &, const event::idx &);
+	static size_t route(const m::event &, const event::idx &);
 	static void handle_notify(const m::event &, m::vm::eval &);
 	static void fini() noexcept;
 
+	extern index rooms;
+	extern index users;
+	extern std::vector<waiter *> deferred;
+	extern ircd::stats::item notify_count;
+	extern ircd::stats::item notify_wakes;
+	extern ircd::stats::item notify_fanout;
+	extern ircd::stats::item notify_broadcast;
 	extern m::hookfn<m::vm::eval &> notified;
-	extern ctx::dock dock;
 }
 
-decltype(ircd::m::sync::longpoll::dock)
-ircd::m::sync::longpoll::dock;
+/// Represents one client parked in longpoll. The waiter is indexed by the
+/// rooms the user is joined or invited to, their user room, and their
+/// user_id (for membership changes to rooms not yet indexed). The index keys
+/// are hashes of the identifiers; a collision only results in a superfluous
+/// wakeup, which the linear handlers will reject.
+struct ircd::m::sync::longpoll::waiter
+:instance_list<waiter>
+{
+	const sync::data &data;
+	std::vector<std::pair<index *, index::iterator>> keys;
+	std::set<event::idx> pending;
+	event::idx since {0};
+	ctx::dock dock;
+
+	void add(index &, const string_view &key);
+	bool wake(const m::event &, const event::idx &);
+	bool ready();
+	event::idx next() const;
+
+	waiter(const sync::data &);
+	waiter(waiter &&) = delete;
+	waiter(const waiter &) = delete;
+	~waiter() noexcept;
+};
+
+template<>
+decltype(ircd::util::instance_list<ircd::m::sync::longpoll::waiter>::allocator)
+ircd::util::instance_list<ircd::m::sync::longpoll::waiter>::allocator
+{};
+
+template<>
+decltype(ircd::util::instance_list<ircd::m::sync::longpoll::waiter>::list)
+ircd::util::instance_list<ircd::m::sync::longpoll::waiter>::list
+{
+	allocator
+};
+
+decltype(ircd::m::sync::longpoll::rooms)
+ircd::m::sync::longpoll::rooms;
+
+decltype(ircd::m::sync::longpoll::users)
+ircd::m::sync::longpoll::users;
+
+decltype(ircd::m::sync::longpoll::deferred)
+ircd::m::sync::longpoll::deferred;
+
+decltype(ircd::m::sync::longpoll::notify_count)
+ircd::m::sync::longpoll::notify_count
+{
+	{ "name", "ircd.client.sync.longpoll.notify.count"                       },
+	{ "desc", "Number of events routed to longpolling clients"               },
+};
+
+decltype(ircd::m::sync::longpoll::notify_wakes)
+ircd::m::sync::longpoll::notify_wakes
+{
+	{ "name", "ircd.client.sync.longpoll.notify.wakes"                       },
+	{ "desc", "Total number of longpolling clients woken by all events"      },
+};
+
+decltype(ircd::m::sync::longpoll::notify_fanout)
+ircd::m::sync::longpoll::notify_fanout
+{
+	{ "name", "ircd.client.sync.longpoll.notify.fanout"                      },
+	{ "desc", "Number of longpolling clients woken by the last event"        },
+};
+
+decltype(ircd::m::sync::longpoll::notify_broadcast)
+ircd::m::sync::longpoll::notify_broadcast
+{
+	{ "name", "ircd.client.sync.longpoll.notify.broadcast"                   },
+	{ "desc", "Number of events which had to wake every longpolling client"  },
+};
 
 decltype(ircd::m::sync::longpoll::notified)
 ircd::m::sync::longpoll::notified
@@ -786,14 +881,15 @@ void
 ircd::m::sync::longpoll::fini()
 noexcept
 {
-	if(!dock.empty())
+	if(!waiter::list.empty())
 		log::warning
 		{
 			log, "Interrupting %zu longpolling clients...",
-			dock.size(),
+			waiter::list.size(),
 		};
 
-	interrupt(dock);
+	for(auto *const &waiter : waiter::list)
+		interrupt(waiter->dock);
 }
 
 void
@@ -805,7 +901,34 @@ try
 	if(!eval.opts->notify_clients)
 		return;
 
-	dock.notify_all();
+	const auto &event_idx
+	{
+		vm::sequence::get(eval)
+	};
+
+	const size_t woken
+	{
+		route(event, event_idx)
+	};
+
+	++notify_count;
+	notify_wakes += woken;
+	notify_fanout = woken;
+
+	// Events notified before they are retired (i.e. the sequence is shared
+	// with an eval lower on the stack) are held by their waiters until the
+	// retired counter passes them; they're woken again here when it has.
+	auto it(begin(deferred));
+	while(it != end(deferred))
+	{
+		auto &waiter(**it);
+		if(waiter.ready())
+		{
+			waiter.dock.notify();
+			it = deferred.erase(it);
+		}
+		else ++it;
+	}
 }
 catch(const ctx::interrupted &)
 {
@@ -821,14 +944,192 @@ catch(const std::exception &e)
 	};
 }
 
+/// Find the waiters to which the event might be relevant and wake them.
+/// This mirrors the conditions under which the linear handlers consider
+/// an event; anything more precise is left to the handlers themselves.
+/// Returns the number of waiters woken.
+size_t
+ircd::m::sync::longpoll::route(const m::event &event,
+                               const event::idx &event_idx)
+{
+	const auto &type
+	{
+		json::get<"type"_>(event)
+	};
+
+	// Presence from our users is offered to everyone by the sync handler so
+	// this is the one case where everybody has to be woken up.
+	if(type == "ircd.presence" && my_host(json::get<"origin"_>(event)))
+	{
+		size_t ret(0);
+		for(auto *const &waiter : waiter::list)
+			ret += waiter->wake(event, event_idx);
+
+		++notify_broadcast;
+		return ret;
+	}
+
+	size_t ret(0);
+	ret += route(rooms, json::get<"room_id"_>(event), event, event_idx);
+
+	// Membership changes for rooms the user is not (yet) joined to.
+	if(type == "m.room.member")
+		ret += route(users, json::get<"state_key"_>(event), event, event_idx);
+
+	// Typing is sent to the sender's user room and targets the room in the
+	// content; receipts are sent to the reader's user room and target the
+	// room in the state_key.
+	if(type == "ircd.typing")
+		ret += route(rooms, unquote(json::get<"content"_>(event).get("room_id")), event, event_idx);
+
+	if(type == "ircd.read")
+		ret += route(rooms, json::get<"state_key"_>(event), event, event_idx);
+
+	return ret;
+}
+
+size_t
+ircd::m::sync::longpoll::route(index &index,
+                               const string_view &key,
+                               const m::event &event,
+                               const event::idx &event_idx)
+{
+	if(!key)
+		return 0;
+
+	size_t ret(0);
+	const auto pit
+	{
+		index.equal_range(std::hash<string_view>{}(key))
+	};
+
+	for(auto it(pit.first); it != pit.second; ++it)
+		ret += it->second->wake(event, event_idx);
+
+	return ret;
+}
+
+//
+// waiter::waiter
+//
+
+ircd::m::sync::longpoll::waiter::waiter(const sync::data &data)
+:data
+{
+	data
+}
+{
+	add(rooms, data.user_room.room_id);
+	add(users, data.user.user_id);
+	data.user_rooms.for_each("join", [this]
+	(const m::room &room, const string_view &)
+	{
+		add(rooms, room.room_id);
+	});
+
+	data.user_rooms.for_each("invite", [this]
+	(const m::room &room, const string_view &)
+	{
+		add(rooms, room.room_id);
+	});
+
+	// Everything retired while we were indexing (we may have yielded) was
+	// not routed to us; poll() sweeps the sequence up to this point instead.
+	since = vm::sequence::retired + 1;
+}
+
+ircd::m::sync::longpoll::waiter::~waiter()
+noexcept
+{
+	for(const auto &[index, it] : keys)
+		index->erase(it);
+
+	const auto it
+	{
+		std::find(begin(deferred), end(deferred), this)
+	};
+
+	if(it != end(deferred))
+		deferred.erase(it);
+}
+
+void
+ircd::m::sync::longpoll::waiter::add(index &index,
+                                     const string_view &key)
+{
+	keys.emplace_back(&index, index.emplace(std::hash<string_view>{}(key), this));
+}
+
+/// Queue the event for this waiter and wake it. Returns false if the event
+/// was filtered or was already queued (such as when routed by several keys).
+bool
+ircd::m::sync::longpoll::waiter::wake(const m::event &event,
+                                      const event::idx &event_idx)
+{
+	// Device events in the user's room are only relevant to the device
+	// which is the state_key; other devices of the user are not woken.
+	const auto &type(json::get<"type"_>(event));
+	const auto &state_key(json::get<"state_key"_>(event));
+	if(startswith(type, "ircd.device.") && state_key && data.device_id)
+		if(json::get<"room_id"_>(event) == data.user_room.room_id)
+			if(state_key != data.device_id)
+				return false;
+
+	if(!pending.emplace(event_idx).second)
+		return false;
+
+	if(!ready())
+	{
+		if(std::find(begin(deferred), end(deferred), this) == end(deferred))
+			deferred.emplace_back(this);
+
+		return true;
+	}
+
+	dock.notify();
+	return true;
+}
+
+/// Whether the next event queued for this waiter can be proffered. Entries
+/// which have already been passed (e.g. by the sweep) are discarded.
+bool
+ircd::m::sync::longpoll::waiter::ready()
+{
+	while(!pending.empty() && *begin(pending) < data.range.second)
+		pending.erase(begin(pending));
+
+	return !pending.empty() && *begin(pending) <= vm::sequence::retired;
+}
+
+/// The lowest event_idx which has not been considered for this waiter;
+/// this is where the client must resume on a timeout.
+ircd::m::event::idx
+ircd::m::sync::longpoll::waiter::next()
+const
+{
+	const auto &ret
+	{
+		vm::sequence::retired + 1
+	};
+
+	return !pending.empty()?
+		std::min(*begin(pending), ret):
+		ret;
+}
+
 /// Longpolling blocks the client's request until a relevant event is processed
 /// by the m::vm. If no event is processed by a timeout this returns false.
 bool
 ircd::m::sync::longpoll_handle(data &data)
 try
 {
+	longpoll::waiter waiter
+	{
+		data
+	};
+
 	int ret;
-	while((ret = longpoll::poll(data)) == -1)
+	while((ret = longpoll::poll(data, waiter)) == -1)
 	{
 		// When the client explicitly gives a next_batch token we have to
 		// adhere to it and return an empty response before going past their
@@ -866,10 +1167,11 @@ catch(const std::exception &e)
 	throw;
 }
 
-/// When the vm's sequence number is incremented our dock is notified and the
-/// event at that next sequence number is fetched. That event gets proffered
+/// Events which were retired before the waiter was indexed are swept in
+/// sequence here without blocking. After that, the dock is waited on until
+/// the router gives us an event_idx; that event is fetched and proffered
 /// around the linear sync handlers for whether it's relevant to the user
-/// making the request on this stack.
+/// making the request on this stack. Events not routed to us are skipped.
 ///
 /// If relevant, we respond immediately with that one event and finish the
 /// request right there, providing them the next since token of one-past the
@@ -889,17 +1191,33 @@ catch(const std::exception &e)
 /// has been sent to the client yet here either.
 ///
 int
-ircd::m::sync::longpoll::poll(data &data)
+ircd::m::sync::longpoll::poll(data &data,
+                              waiter &waiter)
 {
-	const auto ready{[&data]
+	const bool sweep
 	{
-		assert(data.range.second <= m::vm::sequence::retired + 1);
-		return data.range.second <= m::vm::sequence::retired;
-	}};
+		data.range.second < waiter.since
+	};
 
 	assert(data.args);
-	if(!dock.wait_until(data.args->timesout, ready))
-		return false;
+	assert(!sweep || data.range.second <= m::vm::sequence::retired);
+	if(!sweep)
+	{
+		const auto ready{[&waiter]
+		{
+			return waiter.ready();
+		}};
+
+		if(!waiter.dock.wait_until(data.args->timesout, ready))
+		{
+			data.range.second = waiter.next();
+			return false;
+		}
+
+		assert(!waiter.pending.empty());
+		data.range.second = *begin(waiter.pending);
+		waiter.pending.erase(begin(waiter.pending));
+	}
 
 	// Check if client went away while we were sleeping,
 	// if so, just returning true is the easiest way out w/o throwing
@@ -8,11 +8,14 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include "args.h"
+
 namespace ircd::m::sync
 {
 	static bool should_ignore(const data &);
 
 	static bool _rooms_polylog_room(data &, const m::room &);
+	static bool _rooms_polylog_changed(data &, const string_view &membership, const user::rooms::closure_bool &);
 	static bool _rooms_polylog(data &, const string_view &membership, int64_t &phase);
 	static bool rooms_polylog(data &);
 
@@ -198,14 +201,46 @@ ircd::m::sync::_rooms_polylog(data &data,
 		return true;
 	}};
 
+	// Only the rooms which changed since the since token are visited when
+	// the index is able to tell us; otherwise all of the user's rooms.
+	const bool indexed
+	{
+		!data.phased
+		&& !data.args->full_state
+		&& changed::available(data.user, data.range.first)
+	};
+
 	const bool done
 	{
-		data.user_rooms.for_each(membership, closure)
+		indexed?
+			_rooms_polylog_changed(data, membership, closure):
+			data.user_rooms.for_each(membership, closure)
 	};
 
 	return ret;
 }
 
+bool
+ircd::m::sync::_rooms_polylog_changed(data &data,
+                                      const string_view &membership,
+                                      const user::rooms::closure_bool &closure)
+{
+	return changed::for_each(data.user, data.range.first, [&data, &membership, &closure]
+	(const room::id &room_id, const event::idx &event_idx)
+	{
+		const m::room room
+		{
+			room_id
+		};
+
+		char membuf[room::MEMBERSHIP_MAX_SIZE];
+		if(m::membership(membuf, room, data.user) != membership)
+			return true;
+
+		return closure(room, membership);
+	});
+}
+
 bool
 ircd::m::sync::_rooms_polylog_room(data &data,
                                    const m::room &room)
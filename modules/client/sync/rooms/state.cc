@@ -12,20 +12,29 @@
 
 namespace ircd::m::sync
 {
+	using members_view = vector_view<const event::idx>;
+
 	static bool room_state_append(data &, json::stack::array &, const m::event &, const m::event::idx &, const bool &query_prev);
+	static bool room_state_append_members(data &, json::stack::array &, const members_view &);
+
+	static bool room_state_lazy(const data &);
+	static bool room_state_lazy_redundant(const data &);
+	static size_t room_state_lazy_members(const data &, event::idx *const &, const size_t &);
 
 	static bool room_state_phased_member_events(data &, json::stack::array &);
 	static bool room_state_phased_events(data &);
-	static bool room_state_polylog_events(data &);
+	static bool room_state_polylog_events(data &, const members_view &);
 	static bool _room_state_polylog(data &);
 	static bool room_state_polylog(data &);
 	static bool room_invite_state_polylog(data &);
 
+	static bool room_state_linear_lazy(data &);
 	static bool room_state_linear_events(data &);
 	static bool room_invite_state_linear(data &);
 	static bool room_state_linear(data &);
 
 	extern conf::item<bool> lazyload_members;
+	extern conf::item<size_t> lazyload_members_events;
 	extern conf::item<bool> crazyload_historical_members;
 
 	extern item room_invite_state;
@@ -66,7 +75,88 @@ ircd::m::sync::room_state_linear(data &data)
 	if(data.membership == "invite")
 		return false;
 
-	return room_state_linear_events(data);
+	json::stack::checkpoint checkpoint
+	{
+		*data.out
+	};
+
+	if(room_state_linear_events(data))
+		return true;
+
+	checkpoint.rollback();
+	return room_state_linear_lazy(data);
+}
+
+/// When lazy-loading members, the member event of the sender of a timeline
+/// event is included in the state if this device hasn't been sent it yet.
+bool
+ircd::m::sync::room_state_linear_lazy(data &data)
+{
+	if(!data.event_idx)
+		return false;
+
+	if(!data.room)
+		return false;
+
+	if(data.membership != "join")
+		return false;
+
+	assert(data.event);
+	if(json::get<"type"_>(*data.event) == "m.room.member")
+		return false;
+
+	if(!room_state_lazy(data))
+		return false;
+
+	const event::idx member_idx
+	{
+		data.room->get(std::nothrow, "m.room.member", json::get<"sender"_>(*data.event))
+	};
+
+	if(!member_idx)
+		return false;
+
+	if(!room_state_lazy_redundant(data))
+		if(members::sent(data.user, data.device_id, member_idx))
+			return false;
+
+	json::stack::object rooms
+	{
+		*data.out, "rooms"
+	};
+
+	json::stack::object membership_
+	{
+		*data.out, data.membership
+	};
+
+	json::stack::object room_
+	{
+		*data.out, data.room->room_id
+	};
+
+	json::stack::object state
+	{
+		*data.out, "state"
+	};
+
+	json::stack::array array
+	{
+		*data.out, "events"
+	};
+
+	const bool ret
+	{
+		room_state_append_members(data, array, members_view
+		{
+			&member_idx, 1
+		})
+	};
+
+	if(ret)
+		members::mark(data.user, data.device_id, member_idx);
+
+	return ret;
 }
 
 bool
@@ -235,7 +325,50 @@ ircd::m::sync::_room_state_polylog(data &data)
 			if(!apropos(data, data.room_head))
 				return false;
 
-	return room_state_polylog_events(data);
+	// The phased initial sync loads its own members.
+	const bool lazy
+	{
+		room_state_lazy(data) && !(data.phased && data.range.first == 0)
+	};
+
+	std::array<event::idx, 64> lazy_idx;
+	const members_view lazy_members
+	{
+		lazy_idx.data(), lazy?
+			room_state_lazy_members(data, lazy_idx.data(), lazy_idx.size()):
+			0UL
+	};
+
+	const auto compose{[&lazy_members](auto &data)
+	{
+		return room_state_polylog_events(data, lazy_members);
+	}};
+
+	// The state of the room at its head is the same for every initial sync
+	// (or full_state sync) with the same membership; otherwise the output
+	// depends on the since token. Lazy-loaded members are picked from the
+	// events in the sync range, so they're only shared in an initial sync.
+	const bool cacheable
+	{
+		data.range.first == 0 || (data.args->full_state && !lazy)
+	};
+
+	char vclass[48];
+	const bool ret
+	{
+		cacheable?
+			cache::fragment(data, "state", fmt::sprintf
+			{
+				vclass, "%s %b %b", data.membership, data.args->full_state, lazy
+			},
+			compose):
+			compose(data)
+	};
+
+	for(const auto &member_idx : lazy_members)
+		members::mark(data.user, data.device_id, member_idx);
+
+	return ret;
 }
 
 decltype(ircd::m::sync::lazyload_members)
@@ -244,6 +377,15 @@ ircd::m::sync::lazyload_members
 	{ "name",         "ircd.client.sync.rooms.state.members.lazyload" },
 	{ "default",      true                                            },
 	{ "persist",      false                                           },
+	{ "help",         "Omit members from the state of an incremental sync when the filter does not lazy-load them." },
+};
+
+decltype(ircd::m::sync::lazyload_members_events)
+ircd::m::sync::lazyload_members_events
+{
+	{ "name",         "ircd.client.sync.rooms.state.members.lazyload.events" },
+	{ "default",      24L                                                   },
+	{ "help",         "Number of recent events whose senders are loaded."   },
 };
 
 decltype(ircd::m::sync::crazyload_historical_members)
@@ -254,11 +396,17 @@ ircd::m::sync::crazyload_historical_members
 };
 
 bool
-ircd::m::sync::room_state_polylog_events(data &data)
+ircd::m::sync::room_state_polylog_events(data &data,
+                                         const members_view &lazy_members)
 {
 	if(data.phased && data.range.first == 0)
 		return room_state_phased_events(data);
 
+	const bool lazy
+	{
+		room_state_lazy(data)
+	};
+
 	bool ret{false};
 	ctx::mutex mutex;
 	json::stack::array array
@@ -303,7 +451,7 @@ ircd::m::sync::room_state_polylog_events(data &data)
 	};
 
 	const room::state state{*data.room};
-	state.for_each([&data, &concurrent]
+	state.for_each([&data, &concurrent, &lazy]
 	(const string_view &type, const string_view &state_key, const event::idx &event_idx)
 	{
 		// Skip this event if it's not in the sync range, except
@@ -314,6 +462,10 @@ ircd::m::sync::room_state_polylog_events(data &data)
 				return true;
 
 		// For crazyloading/lazyloading related membership event optimiztions.
+		// Lazy-loaded members are appended separately below.
+		if(lazy && type == "m.room.member")
+			return true;
+
 		if(!data.args->full_state && type == "m.room.member")
 		{
 			if(lazyload_members)
@@ -331,6 +483,7 @@ ircd::m::sync::room_state_polylog_events(data &data)
 
 	const ctx::uninterruptible::nothrow ui;
 	concurrent.wait();
+	ret |= room_state_append_members(data, array, lazy_members);
 	return ret;
 }
 
@@ -433,11 +586,55 @@ bool
 ircd::m::sync::room_state_phased_member_events(data &data,
                                                json::stack::array &array)
 {
-	// The number of recent room events we'll seek senders for.
-	static const size_t &max{24};
-	const size_t &count
+	std::array<event::idx, 64> event_idx;
+	const members_view members
 	{
-		std::min(size_t(room::events::viewport_size), max)
+		event_idx.data(), room_state_lazy_members(data, event_idx.data(), event_idx.size())
+	};
+
+	const bool ret
+	{
+		room_state_append_members(data, array, members)
+	};
+
+	for(const auto &member_idx : members)
+		members::mark(data.user, data.device_id, member_idx);
+
+	return ret;
+}
+
+/// Fetch and stream the member events to the client.
+bool
+ircd::m::sync::room_state_append_members(data &data,
+                                         json::stack::array &array,
+                                         const members_view &members)
+{
+	bool ret{false};
+	m::event::fetch event;
+	for(const auto &member_idx : members)
+	{
+		if(!seek(event, member_idx, std::nothrow))
+			continue;
+
+		ret |= room_state_append(data, array, event, member_idx, false);
+	}
+
+	return ret;
+}
+
+/// Find the m.room.member events of the senders of the most recent events in
+/// the room (within the sync range) which is the set of members a client
+/// lazy-loading members needs to render the timeline. Members this device
+/// was already sent are omitted unless this is an initial sync or the filter
+/// asked for redundant members.
+size_t
+ircd::m::sync::room_state_lazy_members(const data &data,
+                                       event::idx *const &out,
+                                       const size_t &max)
+{
+	const size_t count
+	{
+		std::min(size_t(lazyload_members_events), max)
 	};
 
 	m::room::events it
@@ -447,16 +644,22 @@ ircd::m::sync::room_state_phased_member_events(data &data,
 
 	// Prefetch the senders of the recent room events
 	size_t i(0), prefetched(0);
-	std::array<event::idx, max> event_idx;
-	assert(count <= max && count <= event_idx.size());
-	for(; it && i < count; --it, ++i)
+	for(; it && i < count; --it)
 	{
-		event_idx[i] = it.event_idx();
-		prefetched += m::prefetch(event_idx[i], "sender");
+		const auto &event_idx(it.event_idx());
+		if(!data.phased && event_idx >= data.range.second)
+			continue;
+
+		if(!data.phased && event_idx < data.range.first)
+			break;
+
+		out[i] = event_idx;
+		prefetched += m::prefetch(out[i], "sender");
+		++i;
 	}
 
 	// Transform the senders into member event::idx's and prefetch events
-	std::transform(begin(event_idx), begin(event_idx) + i, begin(event_idx), [&data]
+	std::transform(out, out + i, out, [&data]
 	(const m::event::idx &event_idx)
 	{
 		const event::idx &member_idx
@@ -473,23 +676,50 @@ ircd::m::sync::room_state_phased_member_events(data &data,
 	});
 
 	// Eliminate duplicate member event::idx
-	std::sort(begin(event_idx), begin(event_idx) + i);
-	const auto end(std::unique(begin(event_idx), begin(event_idx) + i));
-	assert(std::distance(begin(event_idx), end) > 0 || i == 0);
+	std::sort(out, out + i);
+	auto end(std::unique(out, out + i));
 
-	// Fetch and stream those member events to client
-	bool ret{false};
-	m::event::fetch event;
-	std::for_each(begin(event_idx), end, [&data, &array, &ret, &event]
-	(const event::idx &sender_idx)
+	// Eliminate members this device already has.
+	const bool initial
+	{
+		data.range.first == 0 || int64_t(data.range.first) < 0
+	};
+
+	end = std::remove_if(out, end, [&data, &initial]
+	(const event::idx &member_idx)
 	{
-		if(!seek(event, sender_idx, std::nothrow))
-			return;
+		if(!member_idx)
+			return true;
 
-		ret |= room_state_append(data, array, event, sender_idx, false);
+		if(initial || room_state_lazy_redundant(data))
+			return false;
+
+		return members::sent(data.user, data.device_id, member_idx);
 	});
 
-	return ret;
+	return std::distance(out, end);
+}
+
+bool
+ircd::m::sync::room_state_lazy(const data &data)
+{
+	const m::state_filter &state_filter
+	{
+		json::get<"state"_>(json::get<"room"_>(data.filter))
+	};
+
+	return json::get<"lazy_load_members"_>(state_filter);
+}
+
+bool
+ircd::m::sync::room_state_lazy_redundant(const data &data)
+{
+	const m::state_filter &state_filter
+	{
+		json::get<"state"_>(json::get<"room"_>(data.filter))
+	};
+
+	return json::get<"include_redundant_members"_>(state_filter);
 }
 
 bool
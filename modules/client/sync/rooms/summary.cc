@@ -13,6 +13,7 @@ namespace ircd::m::sync
 	static bool room_summary_append_counts(data &);
 	static bool room_summary_append_heroes(data &);
 
+	static bool _room_summary_polylog(data &);
 	static bool room_summary_polylog(data &);
 	static bool room_summary_linear(data &);
 	extern item room_summary;
@@ -82,6 +83,13 @@ ircd::m::sync::room_summary_linear(data &data)
 
 bool
 ircd::m::sync::room_summary_polylog(data &data)
+{
+	// The summary does not depend on the user or the since token.
+	return cache::fragment(data, "summary", string_view{}, _room_summary_polylog);
+}
+
+bool
+ircd::m::sync::_room_summary_polylog(data &data)
 {
 	bool ret{false};
 	ret |= room_summary_append_counts(data);
@@ -12,6 +12,8 @@ namespace ircd::m::sync
 {
 	static bool _room_timeline_append(data &, json::stack::array &, const m::event::idx &, const m::event &);
 	static event::id::buf _room_timeline_polylog_events(data &, const m::room &, bool &, bool &);
+	static string_view _room_timeline_polylog_vclass(const data &);
+	static bool _room_timeline_polylog(data &);
 	static bool room_timeline_polylog(data &);
 
 	static bool _room_timeline_linear_command(data &);
@@ -201,6 +203,69 @@ ircd::m::sync::room_timeline_polylog(data &data)
 	if(!apropos(data, data.room_head))
 		return false;
 
+	// The timeline depends on the since token for all but initial syncs.
+	if(data.range.first != 0)
+		return _room_timeline_polylog(data);
+
+	return cache::fragment(data, "timeline", _room_timeline_polylog_vclass(data),
+	                       _room_timeline_polylog);
+}
+
+/// Users share a timeline for a room unless they sent one of the events in
+/// it (which carry their transaction_id) or they ignore other users; in that
+/// case the class is personal to the user.
+ircd::string_view
+ircd::m::sync::_room_timeline_polylog_vclass(const data &data)
+{
+	const m::user::ignores ignores
+	{
+		data.user
+	};
+
+	const bool ignoring
+	{
+		ignores.enforce("events") && !ignores.for_each([]
+		(const auto &, const auto &)
+		{
+			return false;
+		})
+	};
+
+	if(ignoring)
+		return data.user.user_id;
+
+	const ssize_t limit
+	{
+		ssize_t(limit_default)
+	};
+
+	ssize_t i(0);
+	m::room::events it
+	{
+		*data.room
+	};
+
+	for(; it && i <= limit; --it, ++i)
+	{
+		const bool own
+		{
+			m::query(std::nothrow, it.event_idx(), "sender", [&data]
+			(const string_view &sender)
+			{
+				return sender == data.user.user_id;
+			})
+		};
+
+		if(own)
+			return data.user.user_id;
+	}
+
+	return data.membership;
+}
+
+bool
+ircd::m::sync::_room_timeline_polylog(data &data)
+{
 	// events
 	assert(data.room);
 	bool limited{false}, ret{false};
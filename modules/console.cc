@@ -4942,6 +4942,8 @@ console_cmd__peer(opt &out, const string_view &line)
 		<< std::setw(4) << std::right << "LNKS" << ' '
 		<< std::setw(4) << std::right << "TAGS" << ' '
 		<< std::setw(4) << std::right << "PIPE" << ' '
+		<< std::setw(10) << std::right << "RTT" << ' '
+		<< std::setw(14) << std::right << "RATE" << ' '
 		<< std::setw(15) << std::left << "FLAGS" << ' '
 		<< std::setw(32) << std::left << "ERROR" << ' '
 		<< std::endl;
@@ -4963,7 +4965,7 @@ console_cmd__peer(opt &out, const string_view &line)
 		if(peer.op_resolve)  strlcat(flags, "RESOLVING ");
 		if(peer.op_fini)     strlcat(flags, "FINISHED ");
 
-		char pbuf[32];
+		char pbuf[32], rbuf[32];
 		out
 		<< std::setw(40) << std::right << host << ' '
 		<< std::setw(40) << std::left << net::ipport{peer.remote} << ' '
@@ -4974,6 +4976,8 @@ console_cmd__peer(opt &out, const string_view &line)
 		<< std::setw(4) << std::right << peer.link_count() << ' '
 		<< std::setw(4) << std::right << peer.tag_count() << ' '
 		<< std::setw(4) << std::right << peer.tag_committed() << ' '
+		<< std::setw(10) << std::right << pretty(pbuf, peer.rtt, true) << ' '
+		<< std::setw(12) << std::right << pretty(rbuf, iec(size_t(peer.rate))) << "/s" << ' '
 		<< std::setw(15) << std::left << flags << ' '
 		<< std::setw(32) << std::left << error << ' '
 		<< std::endl;
@@ -4991,6 +4995,26 @@ console_cmd__peer(opt &out, const string_view &line)
 
 		print_head();
 		print(peer.hostcanon, peer);
+
+		out
+		<< std::endl
+		<< std::setw(8) << std::right << "LINK" << ' '
+		<< std::setw(4) << std::right << "TAGS" << ' '
+		<< std::setw(4) << std::right << "PIPE" << ' '
+		<< std::setw(10) << std::right << "LATENCY" << ' '
+		<< std::setw(10) << std::right << "EXPECTED" << ' '
+		<< std::endl;
+
+		char pbuf[2][32];
+		for(const auto &link : peer.links)
+			out
+			<< std::setw(8) << std::right << link.id << ' '
+			<< std::setw(4) << std::right << link.tag_count() << ' '
+			<< std::setw(4) << std::right << link.tag_committed() << ' '
+			<< std::setw(10) << std::right << pretty(pbuf[0], link.latency, true) << ' '
+			<< std::setw(10) << std::right << pretty(pbuf[1], peer.expected(&link), true) << ' '
+			<< std::endl;
+
 		return true;
 	}
 
@@ -5637,6 +5661,87 @@ console_cmd__net__host__cache__clear(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__net__iou(opt &out, const string_view &line)
+{
+	if(!net::iou::system)
+		throw error
+		{
+			"Socket input by io_uring is not %s.",
+			net::iou::support?
+				"enabled"_sv:
+				"supported"_sv,
+		};
+
+	const auto show{[&out]
+	(const string_view &name, const stats::item &item)
+	{
+		out << std::setw(18) << std::left << name
+		    << std::setw(12) << std::right << uint64_t(stats::get(item))
+		    << std::endl;
+	}};
+
+	show("enters", net::iou::enters);
+	show("submits", net::iou::submits);
+	show("completions", net::iou::completions);
+	show("arms", net::iou::arms);
+	show("nobufs", net::iou::nobufs);
+	out << std::setw(18) << std::left << "bytes"
+	    << std::setw(12) << std::right << "-"
+	    << "   " << pretty(iec(stats::get(net::iou::bytes)))
+	    << std::endl;
+
+	return true;
+}
+
+bool
+console_cmd__net__iou__bench(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"MiB", "chunk"
+	}};
+
+	const size_t bytes
+	{
+		param.at<size_t>("MiB", 256UL) * 1_MiB
+	};
+
+	const size_t chunk
+	{
+		param.at<size_t>("chunk", 64_KiB)
+	};
+
+	const net::iou::bench b
+	{
+		bytes, chunk
+	};
+
+	const auto rate{[&b]
+	(const nanoseconds &t)
+	{
+		return t.count()?
+			long(double(b.bytes) / (t.count() / 1e9) / 1e6):
+			0L;
+	}};
+
+	char pbuf[2][48];
+	out << std::setw(10) << std::left << "reactor"
+	    << std::setw(14) << std::right << pretty(pbuf[0], b.reactor, true)
+	    << std::setw(10) << std::right << rate(b.reactor) << " MB/s"
+	    << "   reads:" << b.reactor_reads
+	    << std::endl;
+
+	out << std::setw(10) << std::left << "io_uring"
+	    << std::setw(14) << std::right << pretty(pbuf[1], b.ring, true)
+	    << std::setw(10) << std::right << rate(b.ring) << " MB/s"
+	    << "   enters:" << b.ring_enters
+	    << " cqes:" << b.ring_cqes
+	    << std::endl;
+
+	return true;
+}
+
 bool
 console_cmd__net__listen__list(opt &out, const string_view &line)
 {
@@ -6072,6 +6177,8 @@ console_cmd__resource(opt &out, const string_view &line)
 		    << (m.opts->flags & resource::method::RATE_LIMITED? " RATE_LIMITED" : "")
 		    << (m.opts->flags & resource::method::VERIFY_ORIGIN? " VERIFY_ORIGIN" : "")
 		    << (m.opts->flags & resource::method::CONTENT_DISCRETION? " CONTENT_DISCRETION" : "")
+		    << (m.opts->flags & resource::method::INTERACTIVE? " INTERACTIVE" : "")
+		    << (m.opts->flags & resource::method::EXPENSIVE? " EXPENSIVE" : "")
 		    << std::endl;
 
 		return true;
@@ -6096,6 +6203,7 @@ console_cmd__resource(opt &out, const string_view &line)
 			    << " | RET " << std::setw(8) << m.stats->completions
 			    << " | TIM " << std::setw(8) << m.stats->timeouts
 			    << " | ERR " << std::setw(8) << m.stats->internal_errors
+			    << " | SHED " << std::setw(8) << m.stats->shed
 			    << std::endl;
 		}
 	}
@@ -6731,6 +6839,165 @@ console_command_numeric(opt &out, const string_view &line)
 	return console_cmd__stage(out, line);
 }
 
+//
+// json
+//
+
+/// Throughput of iterating and validating the most recent events with the
+/// vectorized scanner and with the grammar alone.
+bool
+console_cmd__json__bench(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"count", "rounds"
+	}};
+
+	const size_t count
+	{
+		param.at<size_t>("count", 16384UL)
+	};
+
+	const size_t rounds
+	{
+		param.at<size_t>("rounds", 4UL)
+	};
+
+	size_t bytes(0);
+	std::vector<std::string> corpus;
+	corpus.reserve(count);
+	for(auto it(m::dbs::event_json.rbegin()); it && corpus.size() < count; ++it)
+	{
+		corpus.emplace_back(m::dbs::event_json_source(it->second));
+		bytes += size(corpus.back());
+	}
+
+	// Visit every member and element at every depth.
+	static const auto walk{[](const auto &walk, const string_view &val) -> size_t
+	{
+		size_t ret(1);
+		switch(json::type(val))
+		{
+			case json::OBJECT:
+				for(const auto &[name, sub] : json::object(val))
+					ret += walk(walk, sub);
+				break;
+
+			case json::ARRAY:
+				for(const auto &sub : json::array(val))
+					ret += walk(walk, sub);
+				break;
+
+			default:
+				break;
+		}
+
+		return ret;
+	}};
+
+	const auto run{[&corpus, &rounds](const auto &closure)
+	{
+		size_t ret(0);
+		for(size_t i(0); i < rounds; ++i)
+			for(const auto &event : corpus)
+				ret += closure(event);
+
+		return ret;
+	}};
+
+	const auto report{[&out, &bytes, &rounds]
+	(const string_view &name, const bool &scan, const auto &closure)
+	{
+		const scope_restore enable
+		{
+			json::scan_enable, scan
+		};
+
+		ircd::timer timer;
+		const size_t visited(closure());
+		const auto elapsed(timer.at<nanoseconds>());
+		const double rate
+		{
+			bytes * rounds / (elapsed.count() / 1e9)
+		};
+
+		char pbuf[2][48];
+		out << std::left << std::setw(24) << name
+		    << std::right << std::setw(12) << pretty(pbuf[0], elapsed, true)
+		    << std::right << std::setw(16) << pretty(pbuf[1], iec(size_t(rate))) << "/s"
+		    << "  " << visited << " values"
+		    << std::endl;
+	}};
+
+	const auto iterate{[&run]
+	{
+		return run([](const string_view &event)
+		{
+			return walk(walk, event);
+		});
+	}};
+
+	const auto validate{[&run]
+	{
+		return run([](const string_view &event)
+		{
+			return size_t(json::valid(event, std::nothrow));
+		});
+	}};
+
+	// Round-trip every string member of the event and of its content.
+	const auto escape{[&run]
+	{
+		return run([](const string_view &event)
+		{
+			thread_local char buf[2][64_KiB];
+			const auto strings{[](const json::object &object)
+			{
+				size_t ret(0);
+				for(const auto &[name, val] : object)
+				{
+					if(json::type(val) != json::STRING)
+						continue;
+
+					const string_view raw
+					{
+						json::unescape(buf[0], json::string(val))
+					};
+
+					json::escape(buf[1], raw);
+					++ret;
+				}
+
+				return ret;
+			}};
+
+			const json::object object{event};
+			return strings(object) + strings(object["content"]);
+		});
+	}};
+
+	const auto utf8{[&run]
+	{
+		return run([](const string_view &event)
+		{
+			return size_t(json::valid_utf8(event));
+		});
+	}};
+
+	out << corpus.size() << " events "
+	    << pretty(iec(bytes)) << " x" << rounds
+	    << std::endl << std::endl;
+
+	report("iterate (scanner)", true, iterate);
+	report("iterate (grammar)", false, iterate);
+	report("validate (scanner)", true, validate);
+	report("validate (grammar)", false, validate);
+	report("escape (scanner)", true, escape);
+	report("escape (grammar)", false, escape);
+	report("utf-8", true, utf8);
+	return true;
+}
+
 //
 // events
 //
@@ -11,9 +11,9 @@
 namespace ircd::m::push
 {
 	static void execute(const event &, vm::eval &, const user::id &, const path &, const rule &, const event::idx &);
-	static bool matching(const event &, vm::eval &, const user::id &, const path &, const rule &);
-	static bool handle_kind(const event &, vm::eval &, const user::id &, const path &);
-	static void handle_rules(const event &, vm::eval &, const user::id &, const string_view &scope);
+	static bool matching(const event &, vm::eval &, const match::opts &, const path &, const rule &);
+	static bool handle_kind(const event &, vm::eval &, const match::opts &, const path &);
+	static void handle_rules(const event &, vm::eval &, const match::opts &, const string_view &scope);
 	static void handle_event(const m::event &, vm::eval &);
 	extern hookfn<vm::eval &> hook_event;
 }
@@ -56,7 +56,14 @@ try
 		room_id
 	};
 
-	members.for_each("join", my_host(), [&event, &eval]
+	// The content is indexed once here for every rule of every member.
+	json::index::entry content_buf[32];
+	const json::index content
+	{
+		json::get<"content"_>(event), content_buf
+	};
+
+	members.for_each("join", my_host(), [&event, &eval, &content]
 	(const user::id &user_id, const event::idx &membership_event_idx)
 	{
 		// r0.6.0-13.13.15 Homeservers MUST NOT notify the Push Gateway for
@@ -64,7 +71,10 @@ try
 		if(user_id == at<"sender"_>(event))
 			return true;
 
-		handle_rules(event, eval, user_id, "global");
+		push::match::opts opts;
+		opts.user_id = user_id;
+		opts.content = &content;
+		handle_rules(event, eval, opts, "global");
 		return true;
 	});
 }
@@ -85,7 +95,7 @@ catch(const std::exception &e)
 void
 ircd::m::push::handle_rules(const event &event,
                             vm::eval &eval,
-                            const user::id &user_id,
+                            const match::opts &opts,
                             const string_view &scope)
 {
 	const push::path path[]
@@ -98,27 +108,27 @@ ircd::m::push::handle_rules(const event &event,
 	};
 
 	for(const auto &p : path)
-		if(!handle_kind(event, eval, user_id, p))
+		if(!handle_kind(event, eval, opts, p))
 			break;
 }
 
 bool
 ircd::m::push::handle_kind(const event &event,
                            vm::eval &eval,
-                           const user::id &user_id,
+                           const match::opts &opts,
                            const path &path)
 {
 	const user::pushrules pushrules
 	{
-		user_id
+		opts.user_id
 	};
 
-	return pushrules.for_each(path, [&event, &eval, &user_id]
+	return pushrules.for_each(path, [&event, &eval, &opts]
 	(const auto &event_idx, const auto &path, const auto &rule)
 	{
-		if(matching(event, eval, user_id, path, rule))
+		if(matching(event, eval, opts, path, rule))
 		{
-			execute(event, eval, user_id, path, rule, event_idx);
+			execute(event, eval, opts.user_id, path, rule, event_idx);
 			return false; // false to break due to match
 		}
 		else return true;
@@ -128,7 +138,7 @@ ircd::m::push::handle_kind(const event &event,
 bool
 ircd::m::push::matching(const event &event,
                         vm::eval &eval,
-                        const user::id &user_id,
+                        const match::opts &opts,
                         const path &path,
                         const rule &rule)
 try
@@ -141,8 +151,6 @@ try
 	if(!json::get<"enabled"_>(rule))
 		return false;
 
-	push::match::opts opts;
-	opts.user_id = user_id;
 	const push::match match
 	{
 		event, rule, opts
@@ -156,7 +164,7 @@ try
 		scope,
 		kind,
 		ruleid,
-		string_view{user_id},
+		string_view{opts.user_id},
 		bool(match)? "MATCH"_sv : string_view{}
 	};
 	#endif
@@ -178,7 +186,7 @@ catch(const std::exception &e)
 	{
 		log, "Push rule matching in %s for %s at { %s, %s, %s } :%s",
 		string_view{event.event_id},
-		string_view{user_id},
+		string_view{opts.user_id},
 		scope,
 		kind,
 		ruleid,
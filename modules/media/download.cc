@@ -138,7 +138,7 @@ get__download_local(client &client,
 		m::media::file::read(room, [&client, &sent]
 		(const string_view &block)
 		{
-			sent += write_all(*client.sock, block);
+			sent += client.write_all(block);
 		})
 	};
 
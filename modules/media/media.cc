@@ -59,8 +59,9 @@ ircd::m::media::blocks_descriptor
 	// explain
 	R"(
 	Key-value store of blocks belonging to files. The key is a hash of
-	the block. The key is plaintext sha256-b58 and the block is binary
-	up to 32768 bytes.
+	the block. The key is the binary 32 byte sha256 digest and the block
+	is binary up to 32768 bytes. Older databases keyed the block with the
+	plaintext sha256-b58; those are rewritten by a background migration.
 	)",
 
 	// typing
@@ -153,6 +154,23 @@ ircd::m::media::events_prefetch
 	{ "default",  16L                               },
 };
 
+decltype(ircd::m::media::blocks_migrate)
+ircd::m::media::blocks_migrate
+{
+	{ "name",     "ircd.media.blocks.migrate" },
+	{ "default",  true                        },
+	{
+		"help",
+
+		"Rewrite blocks keyed by the legacy sha256-b58 string to the binary"
+		" digest in the background after startup. Blocks are served under"
+		" either key in the meantime."
+	}
+};
+
+decltype(ircd::m::media::migrate_context)
+ircd::m::media::migrate_context;
+
 decltype(ircd::m::media::database)
 ircd::m::media::database;
 
@@ -181,6 +199,17 @@ ircd::m::media::init()
 	conf::reset("ircd.media.blocks.cache.size");
 	conf::reset("ircd.media.blocks.cache_comp.size");
 
+	// Blocks from before the key format changed are rewritten in the
+	// background; until then they're found under their legacy key.
+	if(blocks_migrate && !ircd::read_only && !ircd::write_avoid)
+		migrate_context.reset(new context
+		{
+			"m.media.migrate",
+			256_KiB,
+			&migrate_worker,
+			context::POST
+		});
+
 	// conditions to load the magick.so module
 	const bool enable_magick
 	{
@@ -204,6 +233,7 @@ void
 ircd::m::media::fini()
 {
 	magick_support.reset();
+	migrate_context.reset(nullptr);
 
 	// The database close contains pthread_join()'s within RocksDB which
 	// deadlock under certain conditions when called during a dlclose()
@@ -212,6 +242,144 @@ ircd::m::media::fini()
 	database = std::shared_ptr<db::database>{};
 }
 
+void
+ircd::m::media::migrate_worker()
+try
+{
+	// Wait for runlevel RUN before proceeding...
+	run::barrier<ctx::interrupted>{};
+
+	// Set a low priority for this context; it's only housekeeping.
+	ionice(ctx::cur(), 4);
+	nice(ctx::cur(), 4);
+
+	migrate();
+}
+catch(const ctx::interrupted &e)
+{
+	log::dwarning
+	{
+		log, "Block key migration interrupted; it will resume at next startup."
+	};
+
+	throw;
+}
+catch(const ctx::terminated &e)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Block key migration :%s",
+		e.what(),
+	};
+}
+
+/// Rewrites any block still keyed by its sha256-b58 string under the binary
+/// digest instead. The legacy key is the only kind which isn't exactly the
+/// size of a digest. Rewrites are committed in batches so a partial run is
+/// harmless and simply resumes the next time.
+size_t
+ircd::m::media::migrate()
+{
+	static const size_t batch_max {256};
+
+	size_t ret(0), batched(0);
+	db::txn txn
+	{
+		*database
+	};
+
+	for(auto it(blocks.begin()); it; ++it)
+	{
+		const string_view &b58hash
+		{
+			it->first
+		};
+
+		if(size(b58hash) == sha256::digest_size)
+			continue;
+
+		sha256::buf hash;
+		const mutable_buffer buf
+		{
+			hash.data(), hash.size()
+		};
+
+		const bool valid
+		{
+			size(b58hash) <= b58encode_size(sizeof(hash)) && [&b58hash, &buf]
+			{
+				try
+				{
+					return size(b58decode(buf, b58hash)) == size(buf);
+				}
+				catch(const std::out_of_range &)
+				{
+					return false;
+				}
+			}()
+		};
+
+		if(unlikely(!valid))
+		{
+			log::error
+			{
+				log, "Block with invalid key '%s' (%zu bytes) not migrated.",
+				b58hash,
+				size(b58hash),
+			};
+
+			continue;
+		}
+
+		db::txn::append
+		{
+			txn, blocks, db::column::delta
+			{
+				db::op::SET, string_view{const_buffer{hash}}, it->second
+			}
+		};
+
+		db::txn::append
+		{
+			txn, blocks, db::column::delta
+			{
+				db::op::DELETE, b58hash
+			}
+		};
+
+		++ret;
+		if(++batched < batch_max)
+			continue;
+
+		txn();
+		txn.clear();
+		batched = 0;
+		ctx::yield();
+		ctx::interruption_point();
+		log::info
+		{
+			log, "Migrated %zu blocks to binary keys...",
+			ret,
+		};
+	}
+
+	if(batched)
+		txn();
+
+	if(ret)
+		log::notice
+		{
+			log, "Migrated %zu blocks from sha256-b58 to binary keys.",
+			ret,
+		};
+
+	return ret;
+}
+
 //
 // media::file
 //
@@ -425,22 +593,52 @@ ircd::m::media::file::write(const m::room &room,
 		{ "value", content_type }
 	});
 
+	// Blocks are hashed together in batches ahead of writing them.
+	static const size_t batch_max {16};
 	size_t off{0}, wrote{0};
 	while(off < size(content))
 	{
-		const size_t blksz
+		sha256::buf hashbuf[batch_max];
+		mutable_buffer hash[batch_max];
+		const_buffer block[batch_max];
+		size_t num(0);
+		for(; num < batch_max && off < size(content); ++num)
 		{
-			std::min(size(content) - off, size_t(32_KiB))
-		};
+			const size_t blksz
+			{
+				std::min(size(content) - off, size_t(32_KiB))
+			};
 
-		const const_buffer &block
+			block[num] = const_buffer
+			{
+				data(content) + off, blksz
+			};
+
+			hash[num] = mutable_buffer
+			{
+				hashbuf[num].data(), hashbuf[num].size()
+			};
+			off += blksz;
+		}
+
+		sha256::batch({hash, num}, {block, num});
+		for(size_t i(0); i < num; ++i)
 		{
-			data(content) + off, blksz
-		};
+			char b64buf[b64encode_size(sha256::digest_size)];
+			const string_view b64hash
+			{
+				b64encode_unpadded(b64buf, hashbuf[i])
+			};
 
-		block::set(room, user_id, block);
-		wrote += size(block);
-		off += blksz;
+			block::set(hashbuf[i], block[i]);
+			send(room, user_id, "ircd.file.block", json::members
+			{
+				{ "size",    long(size(block[i]))  },
+				{ "sha256",  b64hash               }
+			});
+
+			wrote += size(block[i]);
+		}
 	}
 
 	assert(off == size(content));
@@ -495,9 +693,9 @@ ircd::m::media::file::read(const m::room &room,
 			if(at<"type"_>(event) != "ircd.file.block")
 				continue;
 
-			const json::string &hash
+			const sha256::buf hash
 			{
-				at<"content"_>(event).at("hash")
+				block::key(at<"content"_>(event))
 			};
 
 			blocks_prefetched += block::prefetch(hash);
@@ -515,11 +713,17 @@ ircd::m::media::file::read(const m::room &room,
 		if(at<"type"_>(event) != "ircd.file.block")
 			continue;
 
-		const json::string &hash
+		const sha256::buf hash
 		{
-			at<"content"_>(event).at("hash")
+			block::key(at<"content"_>(event))
 		};
 
+		char b64buf[b64encode_size(sha256::digest_size)];
+		const auto b64hash{[&b64buf, &hash]
+		{
+			return b64encode_unpadded(b64buf, hash);
+		}};
+
 		const auto &block_size
 		{
 			at<"content"_>(event).get<size_t>("size")
@@ -532,7 +736,7 @@ ircd::m::media::file::read(const m::room &room,
 				{
 					"File [%s] block [%s] event %s idx:%lu block size %zu != %zu",
 					string_view{room.room_id},
-					hash,
+					b64hash(),
 					string_view{event.event_id},
 					it.event_idx(),
 					block_size,
@@ -547,7 +751,7 @@ ircd::m::media::file::read(const m::room &room,
 			{
 				log, "File %s read %s block[fetched:%zu prefetched:%zu] events[fetched:%zu prefetched:%zu] size:%zu total:%zu",
 				string_view{room.room_id},
-				hash,
+				b64hash(),
 				blocks_fetched,
 				blocks_prefetched,
 				events_fetched,
@@ -565,7 +769,7 @@ ircd::m::media::file::read(const m::room &room,
 			{
 				"File [%s] block %s missing in event %s idx:%lu",
 				string_view{room.room_id},
-				hash,
+				b64hash(),
 				string_view{event.event_id},
 				it.event_idx(),
 			};
@@ -621,73 +825,141 @@ ircd::m::media::block::set(const m::room &room,
                            const m::user::id &user_id,
                            const const_buffer &block)
 {
-	static constexpr const auto bufsz
-	{
-		b58encode_size(sha256::digest_size)
-	};
-
-	char b58buf[bufsz];
-	const auto hash
+	const sha256::buf hash
 	{
-		set(mutable_buffer{b58buf}, block)
+		set(block)
 	};
 
+	char b64buf[b64encode_size(sha256::digest_size)];
 	return send(room, user_id, "ircd.file.block", json::members
 	{
-		{ "size",  long(size(block))  },
-		{ "hash",  hash               }
+		{ "size",    long(size(block))                  },
+		{ "sha256",  b64encode_unpadded(b64buf, hash)   }
 	});
 }
 
-ircd::string_view
+ircd::sha256::buf
 IRCD_MODULE_EXPORT
-ircd::m::media::block::set(const mutable_buffer &b58buf,
-                           const const_buffer &block)
+ircd::m::media::block::set(const const_buffer &block)
 {
 	const sha256::buf hash
 	{
 		sha256{block}
 	};
 
-	const string_view b58hash
-	{
-		b58encode(b58buf, hash)
-	};
-
-	set(b58hash, block);
-	return b58hash;
+	set(hash, block);
+	return hash;
 }
 
 void
 IRCD_MODULE_EXPORT
-ircd::m::media::block::set(const string_view &b58hash,
+ircd::m::media::block::set(const sha256::buf &hash,
                            const const_buffer &block)
 {
-	db::write(blocks, b58hash, block);
+	db::write(blocks, string_view{const_buffer{hash}}, block);
 }
 
 ircd::const_buffer
 IRCD_MODULE_EXPORT
 ircd::m::media::block::get(const mutable_buffer &out,
-                           const string_view &b58hash)
+                           const sha256::buf &hash)
 {
-	return db::read(blocks, b58hash, out);
+	const_buffer ret;
+	get(hash, [&out, &ret](const const_buffer &block)
+	{
+		ret = const_buffer
+		{
+			data(out), copy(out, block)
+		};
+	});
+
+	return ret;
 }
 
+/// Blocks not yet rewritten by the migration are still found under their
+/// sha256-b58 key. The digest is tried again last in case the migration
+/// moved the block in between.
 bool
 IRCD_MODULE_EXPORT
-ircd::m::media::block::get(const string_view &b58hash,
+ircd::m::media::block::get(const sha256::buf &hash,
                            const closure &closure)
 {
 	const db::gopts opts;
-	return blocks(b58hash, std::nothrow, closure, opts);
+	const string_view key
+	{
+		const_buffer{hash}
+	};
+
+	if(likely(blocks(key, std::nothrow, closure, opts)))
+		return true;
+
+	char b58buf[b58encode_size(sha256::digest_size)];
+	const string_view b58hash
+	{
+		b58encode(b58buf, hash)
+	};
+
+	return blocks(b58hash, std::nothrow, closure, opts)
+	    || blocks(key, std::nothrow, closure, opts);
 }
 
 bool
 IRCD_MODULE_EXPORT
-ircd::m::media::block::prefetch(const string_view &b58hash)
+ircd::m::media::block::prefetch(const sha256::buf &hash)
 {
-	return db::prefetch(blocks, b58hash);
+	return db::prefetch(blocks, string_view{const_buffer{hash}});
+}
+
+/// The digest referenced by the content of an ircd.file.block event. Blocks
+/// are referenced by the unpadded base64 `sha256`; events prior to that carry
+/// the sha256-b58 in `hash` instead.
+ircd::sha256::buf
+IRCD_MODULE_EXPORT
+ircd::m::media::block::key(const json::object &content)
+{
+	sha256::buf ret;
+	const mutable_buffer buf
+	{
+		ret.data(), ret.size()
+	};
+
+	const json::string &b64hash
+	{
+		content.get("sha256")
+	};
+
+	if(likely(b64hash))
+	{
+		if(unlikely(size(b64decode(buf, b64hash)) != sizeof(ret)))
+			throw error
+			{
+				"Block sha256 '%s' is not a digest.",
+				string_view{b64hash},
+			};
+
+		return ret;
+	}
+
+	const json::string &b58hash
+	{
+		content.at("hash")
+	};
+
+	if(unlikely(size(b58hash) > b58encode_size(sizeof(ret))))
+		throw error
+		{
+			"Block hash '%s' is not a digest.",
+			string_view{b58hash},
+		};
+
+	if(unlikely(size(b58decode(buf, b58hash)) != sizeof(ret)))
+		throw error
+		{
+			"Block hash '%s' is not a digest.",
+			string_view{b58hash},
+		};
+
+	return ret;
 }
 
 //
@@ -14,6 +14,8 @@ namespace ircd::m::media
 
 	static void init();
 	static void fini();
+	static size_t migrate();
+	static void migrate_worker();
 
 	extern log::log log;
 	extern std::unique_ptr<m::media::magick> magick_support;
@@ -24,6 +26,8 @@ namespace ircd::m::media
 	extern conf::item<size_t> blocks_cache_comp_size;
 	extern conf::item<size_t> blocks_prefetch;
 	extern conf::item<size_t> events_prefetch;
+	extern conf::item<bool> blocks_migrate;
+	extern std::unique_ptr<context> migrate_context;
 	extern const db::descriptor blocks_descriptor;
 	extern const db::description description;
 	extern std::shared_ptr<db::database> database;
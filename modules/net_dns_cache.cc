@@ -10,51 +10,149 @@
 
 namespace ircd::net::dns::cache
 {
+	struct entry;
+
 	static bool call_waiter(const string_view &, const string_view &, const json::array &, waiter &);
 	static size_t call_waiters(const string_view &, const string_view &, const json::array &);
-	static void handle(const m::event &, m::vm::eval &);
+
+	static string_view make_key(const mutable_buffer &, const string_view &type, const string_view &state_key);
+	static std::shared_ptr<const entry> find(const string_view &type, const string_view &state_key);
+	static std::shared_ptr<const entry> fetch(const string_view &type, const string_view &state_key);
+	static void refresh(const entry &, const hostport &, const opts &, const string_view &type, const string_view &state_key);
+	static void evict();
+	static bool commit(const string_view &type, const string_view &state_key, const json::object &content);
+	static void persist(const string_view &type, const string_view &state_key, const entry &);
+	static void persist_worker();
 
 	static bool put(const string_view &type, const string_view &state_key, const records &rrs);
 	static bool put(const string_view &type, const string_view &state_key, const uint &code, const string_view &msg);
 
-	extern const m::room::id::buf dns_room_id;
-	extern m::hookfn<m::vm::eval &> hook;
+	extern conf::item<bool> l1_enable;
+	extern conf::item<size_t> l1_max;
+	extern conf::item<size_t> refresh_hits;
+	extern conf::item<size_t> refresh_pct;
+
+	extern stats::item l1_hits;
+	extern stats::item l1_misses;
+	extern stats::item refreshes;
+	extern stats::item persisted;
+
+	extern std::map<std::string, std::shared_ptr<entry>, std::less<>> l1;
+	extern std::deque<std::tuple<std::string, std::string, seconds>> persisting; // key, content, ttl
+	extern ctx::dock persist_dock;
+	extern ctx::context persister;
 
 	static void init(), fini();
 }
 
+/// Memory-resident copy of one cached answer; m::ephemeral is its backing
+/// store. The records are shared with any callback reading them so a
+/// concurrent replacement of the entry can't pull them out from under it.
+struct ircd::net::dns::cache::entry
+{
+	std::string rrs;          // json array of records
+	time_t ts {0};            // when the answer was received
+	time_t expires {0};       // all records expired
+	time_t refresh {0};       // hot entries are refreshed from here
+	mutable size_t hits {0};  // lookups since received
+	mutable bool refreshing {false};
+
+	entry(const json::array &rrs, const time_t &ts);
+};
+
 ircd::mapi::header
 IRCD_MODULE
 {
-	"DNS cache using Matrix rooms.",
+	"DNS cache.",
 	ircd::net::dns::cache::init,
 	ircd::net::dns::cache::fini,
 };
 
-decltype(ircd::net::dns::cache::dns_room_id)
-ircd::net::dns::cache::dns_room_id
+decltype(ircd::net::dns::cache::l1_enable)
+ircd::net::dns::cache::l1_enable
 {
-	"dns", m::my_host()
+	{ "name",     "ircd.net.dns.cache.l1.enable" },
+	{ "default",  true                           },
 };
 
-decltype(ircd::net::dns::cache::hook)
-ircd::net::dns::cache::hook
+decltype(ircd::net::dns::cache::l1_max)
+ircd::net::dns::cache::l1_max
 {
-	ircd::net::dns::cache::handle,
-	{
-		{ "_site",    "vm.effect"              },
-		{ "room_id",  string_view{dns_room_id} },
-	}
+	{ "name",     "ircd.net.dns.cache.l1.max" },
+	{ "default",  long(64_KiB)                },
+};
+
+decltype(ircd::net::dns::cache::refresh_hits)
+ircd::net::dns::cache::refresh_hits
+{
+	{ "name",     "ircd.net.dns.cache.refresh.hits" },
+	{ "default",  4L                                },
+	{ "help",
+	R"(
+	An entry looked up at least this many times during its lifetime is
+	considered hot and is queried again before it expires, so the lookup
+	never has to wait on a resolver. Zero disables refresh-ahead.
+	)"},
+};
+
+decltype(ircd::net::dns::cache::refresh_pct)
+ircd::net::dns::cache::refresh_pct
+{
+	{ "name",     "ircd.net.dns.cache.refresh.pct" },
+	{ "default",  75L                              },
+	{ "help",
+	R"(
+	Percentage of a hot entry's lifetime after which it is refreshed.
+	)"},
+};
+
+decltype(ircd::net::dns::cache::l1_hits)
+ircd::net::dns::cache::l1_hits
+{
+	{ "name", "ircd.net.dns.cache.l1.hits"                         },
+	{ "desc", "Lookups answered from memory"                       },
 };
 
+decltype(ircd::net::dns::cache::l1_misses)
+ircd::net::dns::cache::l1_misses
+{
+	{ "name", "ircd.net.dns.cache.l1.misses"                       },
+	{ "desc", "Lookups which had to consult the ephemeral store"  },
+};
+
+decltype(ircd::net::dns::cache::refreshes)
+ircd::net::dns::cache::refreshes
+{
+	{ "name", "ircd.net.dns.cache.refreshes"                       },
+	{ "desc", "Queries made ahead of expiration for hot entries"    },
+};
+
+decltype(ircd::net::dns::cache::persisted)
+ircd::net::dns::cache::persisted
+{
+	{ "name", "ircd.net.dns.cache.persisted"                       },
+	{ "desc", "Answers written to the ephemeral store"             },
+};
+
+decltype(ircd::net::dns::cache::l1)
+ircd::net::dns::cache::l1;
+
+decltype(ircd::net::dns::cache::persisting)
+ircd::net::dns::cache::persisting;
+
+decltype(ircd::net::dns::cache::persist_dock)
+ircd::net::dns::cache::persist_dock;
+
+decltype(ircd::net::dns::cache::persister)
+ircd::net::dns::cache::persister
+{
+	"dns cache", 256_KiB, context::POST, persist_worker
+};
+
+
 void
 ircd::net::dns::cache::init()
 {
-	log::debug
-	{
-		"DNS cache room %s currently set.",
-		string_view{dns_room_id}
-	};
 }
 
 void
@@ -71,6 +169,14 @@ ircd::net::dns::cache::fini()
 	{
 		return waiting.empty();
 	});
+
+	persist_dock.wait([]
+	{
+		return persisting.empty();
+	});
+
+	persister.terminate();
+	persister.join();
 }
 
 bool
@@ -168,40 +274,7 @@ try
 	rr0.~object();
 	array.~array();
 	content.~object();
-	const m::room room
-	{
-		dns_room_id
-	};
-
-	if(unlikely(!exists(room)))
-		create(room, m::me(), "internal");
-
-	send(room, m::me(), type, state_key, json::object(out.completed()));
-	return true;
-}
-catch(const http::error &e)
-{
-	const ctx::exception_handler eh;
-	log::error
-	{
-		log, "cache put (%s, %s) code:%u (%s) :%s %s",
-		type,
-		state_key,
-		code,
-		msg,
-		e.what(),
-		e.content,
-	};
-
-	const json::value error_value
-	{
-		json::object{e.content}
-	};
-
-	const json::value error_records{&error_value, 1};
-	const json::strung error{error_records};
-	call_waiters(type, state_key, error);
-	return false;
+	return commit(type, state_key, json::object(out.completed()));
 }
 catch(const std::exception &e)
 {
@@ -296,39 +369,7 @@ try
 
 	array.~array();
 	content.~object();
-	const m::room room
-	{
-		dns_room_id
-	};
-
-	if(unlikely(!exists(room)))
-		create(room, m::me(), "internal");
-
-	send(room, m::me(), type, state_key, json::object{out.completed()});
-	return true;
-}
-catch(const http::error &e)
-{
-	const ctx::exception_handler eh;
-	log::error
-	{
-		log, "cache put (%s, %s) rrs:%zu :%s %s",
-		type,
-		state_key,
-		rrs.size(),
-		e.what(),
-		e.content,
-	};
-
-	const json::value error_value
-	{
-		json::object{e.content}
-	};
-
-	const json::value error_records{&error_value, 1};
-	const json::strung error{error_records};
-	call_waiters(type, state_key, error);
-	return false;
+	return commit(type, state_key, json::object{out.completed()});
 }
 catch(const std::exception &e)
 {
@@ -374,46 +415,29 @@ ircd::net::dns::cache::get(const hostport &hp,
 			host(hp)
 	};
 
-	const m::room::state state
-	{
-		dns_room_id
-	};
-
-	const m::event::idx &event_idx
+	const auto entry
 	{
-		state.get(std::nothrow, type, state_key)
+		fetch(type, state_key)
 	};
 
-	if(!event_idx)
+	// If all records are expired then skip; otherwise since this closure
+	// expects a single array we reveal both expired and valid records.
+	const time_t now(ircd::time());
+	if(!entry || entry->expires < now)
 		return false;
 
-	time_t origin_server_ts;
-	if(!m::get<time_t>(event_idx, "origin_server_ts", origin_server_ts))
-		return false;
-
-	bool ret{false};
-	const time_t ts{origin_server_ts / 1000L};
-	m::get(std::nothrow, event_idx, "content", [&hp, &closure, &ret, &ts]
-	(const json::object &content)
-	{
-		const json::array &rrs
-		{
-			content.get("")
-		};
-
-		// If all records are expired then skip; otherwise since this closure
-		// expects a single array we reveal both expired and valid records.
-		ret = !std::all_of(begin(rrs), end(rrs), [&ts]
-		(const json::object &rr)
+	++entry->hits;
+	if(entry->refresh <= now && !entry->refreshing)
+		if(refresh_hits && entry->hits >= size_t(refresh_hits))
 		{
-			return expired(rr, ts);
-		});
+			entry->refreshing = true;
+			refresh(*entry, hp, opts, type, state_key);
+		}
 
-		if(ret && closure)
-			closure(hp, rrs);
-	});
+	if(closure)
+		closure(hp, json::array(entry->rrs));
 
-	return ret;
+	return true;
 }
 
 bool
@@ -436,114 +460,359 @@ ircd::net::dns::cache::for_each(const hostport &hp,
 			host(hp)
 	};
 
-	const m::room::state state
+	const auto entry
 	{
-		dns_room_id
+		fetch(type, state_key)
 	};
 
-	const m::event::idx &event_idx
+	if(!entry)
+		return false;
+
+	for(const json::object &rr : json::array(entry->rrs))
 	{
-		state.get(std::nothrow, type, state_key)
-	};
+		if(expired(rr, entry->ts))
+			continue;
 
-	if(!event_idx)
-		return false;
+		if(!closure(state_key, rr))
+			return false;
+	}
 
-	time_t origin_server_ts;
-	if(!m::get<time_t>(event_idx, "origin_server_ts", origin_server_ts))
-		return false;
+	return true;
+}
 
-	bool ret{true};
-	const time_t ts{origin_server_ts / 1000L};
-	m::get(std::nothrow, event_idx, "content", [&state_key, &closure, &ret, &ts]
-	(const json::object &content)
+bool
+IRCD_MODULE_EXPORT
+ircd::net::dns::cache::for_each(const string_view &type,
+                                const closure &closure)
+{
+	char type_buf[48];
+	const string_view full_type
 	{
+		make_type(type_buf, type)
+	};
+
+	return m::ephemeral::for_each(full_type, [&closure]
+	(const string_view &state_key, const json::object &content)
+	{
+		const time_t ts
+		{
+			content.get<time_t>("ts")
+		};
+
 		for(const json::object &rr : json::array(content.get("")))
 		{
 			if(expired(rr, ts))
 				continue;
 
-			if(!(ret = closure(state_key, rr)))
-				break;
+			if(!closure(state_key, rr))
+				return false;
 		}
+
+		return true;
 	});
+}
 
-	return ret;
+//
+// memory cache
+//
+
+/// Find the entry in memory, otherwise load it from the ephemeral store.
+/// Loading requires a ctx.
+std::shared_ptr<const ircd::net::dns::cache::entry>
+ircd::net::dns::cache::fetch(const string_view &type,
+                             const string_view &state_key)
+{
+	if(auto ret{find(type, state_key)})
+	{
+		++l1_hits;
+		return ret;
+	}
+
+	++l1_misses;
+	std::shared_ptr<entry> ret;
+	m::ephemeral::get(std::nothrow, type, state_key, [&ret]
+	(const json::object &content)
+	{
+		ret = std::make_shared<entry>(content.get(""), content.get<time_t>("ts"));
+	});
+
+	if(!ret || !l1_enable)
+		return ret;
+
+	// The store may have been read while an answer was received; the newer
+	// answer in memory is kept.
+	char keybuf[rfc1035::NAME_BUFSIZE * 3];
+	const string_view key
+	{
+		make_key(keybuf, type, state_key)
+	};
+
+	evict();
+	auto it(l1.lower_bound(key));
+	if(it == end(l1) || it->first != key)
+		it = l1.emplace_hint(it, key, ret);
+
+	return it->second;
+}
+
+std::shared_ptr<const ircd::net::dns::cache::entry>
+ircd::net::dns::cache::find(const string_view &type,
+                            const string_view &state_key)
+{
+	char keybuf[rfc1035::NAME_BUFSIZE * 3];
+	const string_view key
+	{
+		make_key(keybuf, type, state_key)
+	};
+
+	const auto it(l1.find(key));
+	return it != end(l1)?
+		it->second:
+		nullptr;
 }
 
+/// Answers are placed in memory and given to the waiters immediately; the
+/// write to the ephemeral store is left to the persister.
 bool
-IRCD_MODULE_EXPORT
-ircd::net::dns::cache::for_each(const string_view &type,
-                                const closure &closure)
+ircd::net::dns::cache::commit(const string_view &type,
+                              const string_view &state_key,
+                              const json::object &content)
 {
-	char type_buf[48];
-	const string_view full_type
+	const json::array &rrs
 	{
-		make_type(type_buf, type)
+		content.get("")
 	};
 
-	const m::room::state state
+	const auto ent
 	{
-		dns_room_id
+		std::make_shared<entry>(rrs, ircd::time())
 	};
 
-	return state.for_each(full_type, [&closure]
-	(const string_view &, const string_view &state_key, const m::event::idx &event_idx)
+	char keybuf[rfc1035::NAME_BUFSIZE * 3];
+	const string_view key
 	{
-		time_t origin_server_ts;
-		if(!m::get<time_t>(event_idx, "origin_server_ts", origin_server_ts))
-			return true;
+		make_key(keybuf, type, state_key)
+	};
 
-		bool ret{true};
-		const time_t ts{origin_server_ts / 1000L};
-		m::get(std::nothrow, event_idx, "content", [&state_key, &closure, &ret, &ts]
-		(const json::object &content)
-		{
-			for(const json::object &rr : json::array(content.get("")))
-			{
-				if(expired(rr, ts))
-					continue;
+	auto it(l1.find(key));
+	const bool error
+	{
+		is_error(rrs)
+	};
 
-				if(!(ret = closure(state_key, rr)))
-					break;
-			}
-		});
+	// An error answering our own refresh doesn't displace a good answer
+	// which hasn't expired yet; it gets its chance again on the next lookup.
+	const bool keep
+	{
+		error &&
+		it != end(l1) &&
+		it->second->refreshing &&
+		it->second->expires >= ent->ts
+	};
 
-		return ret;
-	});
+	if(keep)
+		it->second->refreshing = false;
+	else if(l1_enable && it != end(l1))
+		it->second = ent;
+	else if(l1_enable)
+	{
+		evict();
+		l1.emplace(key, ent);
+	}
+
+	if(!keep)
+		persist(type, state_key, *ent);
+
+	call_waiters(type, state_key, json::array(ent->rrs));
+	return true;
 }
 
+/// Query again for an entry which is still valid; the answer replaces the
+/// entry through the same path as any other. Our callback has nothing to do.
+/// If the query can't be made the entry is released for another attempt.
 void
-ircd::net::dns::cache::handle(const m::event &event,
-                              m::vm::eval &eval)
+ircd::net::dns::cache::refresh(const entry &entry,
+                               const hostport &hp,
+                               const opts &opts_,
+                               const string_view &type,
+                               const string_view &state_key)
 try
 {
-	const string_view &type
+	auto opts(opts_);
+	opts.cache_check = false;
+	opts.cache_result = true;
+	++refreshes;
+
+	log::debug
+	{
+		log, "Refreshing %s %s ahead of expiration.",
+		type,
+		state_key,
+	};
+
+	dns::resolve(hp, opts, dns::callback{[]
+	(const hostport &, const json::array &)
+	{
+	}});
+}
+catch(const std::exception &e)
+{
+	entry.refreshing = false;
+	log::derror
 	{
-		json::get<"type"_>(event)
+		log, "Refreshing %s %s :%s",
+		type,
+		state_key,
+		e.what(),
 	};
+}
 
-	if(!startswith(type, "ircd.dns.rrs."))
+/// Make room for one more entry. Expired entries go first; otherwise the
+/// entry closest to expiring is dropped.
+void
+ircd::net::dns::cache::evict()
+{
+	if(l1.size() < size_t(l1_max))
 		return;
 
-	const string_view &state_key
+	const time_t now(ircd::time());
+	for(auto it(begin(l1)); it != end(l1); )
+		if(it->second->expires < now)
+			it = l1.erase(it);
+		else
+			++it;
+
+	if(l1.size() < size_t(l1_max))
+		return;
+
+	const auto it
 	{
-		json::get<"state_key"_>(event)
+		std::min_element(begin(l1), end(l1), []
+		(const auto &a, const auto &b)
+		{
+			return a.second->expires < b.second->expires;
+		})
 	};
 
-	const json::array &rrs
+	if(it != end(l1))
+		l1.erase(it);
+}
+
+ircd::net::dns::cache::entry::entry(const json::array &rrs,
+                                    const time_t &ts)
+:rrs
+{
+	rrs
+}
+,ts
+{
+	ts
+}
+{
+	const seconds &min_seconds(min_ttl), &err_seconds(error_ttl);
+	for(const json::object &rr : rrs)
+	{
+		const time_t min
+		{
+			is_error(rr)?
+				err_seconds.count():
+				min_seconds.count()
+		};
+
+		expires = std::max(expires, ts + std::max(get_ttl(rr), min));
+	}
+
+	const auto life
 	{
-		json::get<"content"_>(event).get("")
+		std::max(expires - ts, 0L)
 	};
 
-	call_waiters(type, state_key, rrs);
+	refresh = ts + life * std::min(long(refresh_pct), 100L) / 100L;
 }
-catch(const std::exception &e)
+
+ircd::string_view
+ircd::net::dns::cache::make_key(const mutable_buffer &out,
+                                const string_view &type,
+                                const string_view &state_key)
 {
-	log::critical
+	return fmt::sprintf
+	{
+		out, "%s %s", type, state_key
+	};
+}
+
+/// Queue the answer for the persister. The database write can yield, which
+/// the resolver's contexts shouldn't do for this.
+void
+ircd::net::dns::cache::persist(const string_view &type,
+                               const string_view &state_key,
+                               const entry &entry)
+{
+	const json::strung content
 	{
-		log, "handle_cached() :%s", e.what()
+		json::members
+		{
+			{ "",    json::array(entry.rrs) },
+			{ "ts",  entry.ts               },
+		}
+	};
+
+	const seconds ttl
+	{
+		std::max(entry.expires - entry.ts, 1L)
 	};
+
+	char keybuf[rfc1035::NAME_BUFSIZE * 3];
+	persisting.emplace_back(make_key(keybuf, type, state_key), std::string(content), ttl);
+	persist_dock.notify_one();
+}
+
+/// Writes answers to the ephemeral store in the order they were received.
+/// The store is only read when an answer isn't in memory, so nothing waits
+/// on this.
+void
+ircd::net::dns::cache::persist_worker()
+{
+	while(1)
+	{
+		persist_dock.wait([]
+		{
+			return !persisting.empty();
+		});
+
+		const auto &[key, content, ttl]
+		{
+			persisting.front()
+		};
+
+		const auto &[type, state_key]
+		{
+			split(key, ' ')
+		};
+
+		try
+		{
+			m::ephemeral::set(type, state_key, content, ttl);
+			++persisted;
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			log::error
+			{
+				log, "cache persist (%s, %s) :%s",
+				type,
+				state_key,
+				e.what(),
+			};
+		}
+
+		persisting.pop_front();
+		persist_dock.notify_all();
+	}
 }
 
 /// Note complications due to reentrance and other factors:
@@ -621,54 +890,3 @@ catch(const std::exception &e)
 
 	return true;
 }
-
-//
-// cache room creation
-//
-
-namespace ircd::net::dns::cache
-{
-	static void create_room();
-
-	extern m::hookfn<m::vm::eval &> create_room_hook;
-}
-
-decltype(ircd::net::dns::cache::create_room_hook)
-ircd::net::dns::cache::create_room_hook
-{
-	{
-		{ "_site",    "vm.effect"      },
-		{ "room_id",  "!ircd"          },
-		{ "type",     "m.room.create"  },
-	},
-
-	[](const m::event &, m::vm::eval &)
-	{
-		create_room();
-	}
-};
-
-void
-ircd::net::dns::cache::create_room()
-try
-{
-	const m::room room
-	{
-		m::create(dns_room_id, m::me(), "internal")
-	};
-
-	log::debug
-	{
-		m::log, "Created '%s' for the DNS cache module.",
-		string_view{dns_room_id}
-	};
-}
-catch(const std::exception &e)
-{
-	log::critical
-	{
-		m::log, "Creating the '%s' room failed :%s",
-		string_view{dns_room_id},
-		e.what()
-	};
-}